@@ -0,0 +1,588 @@
+#include "OptimizationMethod.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+/*
+ * End-to-end convergence benchmark of the optimization methods.
+ *
+ * Usage: ConvergenceBench [--repeat <n>] [--output <runs.csv>] [--baseline <runs.csv>]
+ *                         [--eval-tolerance <fraction>] [--time-tolerance <fraction>]
+ *
+ * Every method is run on a fixed catalog of problems: the built-in functions
+ * with known minima on fixed areas, in plain, coordinate-scaled and
+ * value-scaled variants, from several start points each. A problem counts as
+ * solved for an accuracy tau once a point with
+ *
+ *     f(x) <= fMin + tau * (f(x0) - fMin)
+ *
+ * has been evaluated. The cost of reaching it is measured in evaluations,
+ * where a value costs 1 and a gradient costs n, and in wall time. From these
+ * costs the benchmark prints Dolan-More performance profiles and More-Wild
+ * data profiles for every tau.
+ *
+ * --output stores the per-run costs; a file stored this way can be passed as
+ * --baseline to a later run, which then lists every run that stopped solving
+ * its problem or got more expensive than the tolerances allow and exits with
+ * status 1.
+ */
+
+static const double taus[] = {1e-1, 1e-3, 1e-5, 1e-7};
+static const size_t tausNum = sizeof(taus) / sizeof(taus[0]);
+static const double unsolved = std::numeric_limits<double>::infinity();
+
+/**
+ * \struct BudgetExhausted
+ * \brief Thrown by CountingFunction when the evaluation budget of a run is spent.
+ */
+struct BudgetExhausted
+{
+};
+
+/**
+ * \class ScaledFunction
+ * \brief The function c * f(D x) for a diagonal scaling D.
+ */
+class ScaledFunction : public Function
+{
+public:
+    ScaledFunction(std::shared_ptr<Function> f, const VectorX &scales, double valueScale)
+        : f(f), scales(scales), valueScale(valueScale)
+    {
+        dimension = f->getDim();
+        name = f->getName();
+    }
+    std::shared_ptr<Function> clone() const override
+    {
+        return std::make_shared<ScaledFunction>(*this);
+    }
+
+protected:
+    double calcValue(const VectorX &x) const override
+    {
+        return valueScale * (*f)(scaled(x));
+    }
+    VectorX calcGrad(const VectorX &x) const override
+    {
+        return chain(f->grad(scaled(x)));
+    }
+    Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override
+    {
+        Evaluation eval = f->evaluate(scaled(x), wantGrad);
+        eval.value *= valueScale;
+        if (wantGrad)
+            eval.grad = chain(eval.grad);
+        return eval;
+    }
+
+private:
+    VectorX scaled(const VectorX &x) const
+    {
+        VectorX y(x);
+        for (size_t i = 0; i < y.size(); ++i)
+            y[i] *= scales[i];
+        return y;
+    }
+    VectorX chain(VectorX grad) const
+    {
+        for (size_t i = 0; i < grad.size(); ++i)
+            grad[i] *= valueScale * scales[i];
+        return grad;
+    }
+
+    std::shared_ptr<Function> f; ///< The unscaled function.
+    VectorX scales;              ///< The diagonal of D.
+    double valueScale;           ///< The factor c.
+};
+
+/**
+ * \class CountingFunction
+ * \brief Counts the evaluations of a run and records when each target is reached.
+ *
+ * The counters are shared between clones, because TransferData evaluates a
+ * clone of the function it is given.
+ */
+class CountingFunction : public Function
+{
+public:
+    /**
+     * \struct Counters
+     * \brief The evaluation state of one run.
+     */
+    struct Counters
+    {
+        const double *targets;                       ///< The target value of every tau.
+        size_t budget;                               ///< The maximal evaluation cost of the run.
+        size_t cost;                                 ///< The evaluation cost so far.
+        std::chrono::steady_clock::time_point start; ///< The start of the run.
+        double costToTarget[tausNum];                ///< Evaluation cost at which each target was first reached.
+        double secondsToTarget[tausNum];             ///< Time at which each target was first reached.
+    };
+
+    CountingFunction(const Function &f, const double *targets, size_t budget)
+        : f(f), counters(std::make_shared<Counters>())
+    {
+        dimension = f.getDim();
+        name = f.getName();
+        counters->targets = targets;
+        counters->budget = budget;
+        counters->cost = 0;
+        counters->start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < tausNum; ++i)
+        {
+            counters->costToTarget[i] = unsolved;
+            counters->secondsToTarget[i] = unsolved;
+        }
+    }
+    std::shared_ptr<Function> clone() const override
+    {
+        return std::make_shared<CountingFunction>(*this);
+    }
+    const Counters &getCounters() const
+    {
+        return *counters;
+    }
+
+protected:
+    double calcValue(const VectorX &x) const override
+    {
+        charge(1);
+        return record(f(x));
+    }
+    VectorX calcGrad(const VectorX &x) const override
+    {
+        charge(dimension);
+        return f.grad(x);
+    }
+    Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override
+    {
+        charge(wantGrad ? 1 + dimension : 1);
+        Evaluation eval = f.evaluate(x, wantGrad);
+        record(eval.value);
+        return eval;
+    }
+    void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override
+    {
+        charge(points.getCount() * (grads ? 1 + dimension : 1));
+        f.evaluateBatch(points, values, grads);
+        for (size_t k = 0; k < points.getCount(); ++k)
+            record(values[k]);
+    }
+
+private:
+    void charge(size_t units) const
+    {
+        if (counters->cost + units > counters->budget)
+            throw BudgetExhausted();
+        counters->cost += units;
+    }
+    double record(double value) const
+    {
+        for (size_t i = 0; i < tausNum; ++i)
+        {
+            if (value <= counters->targets[i] && counters->costToTarget[i] == unsolved)
+            {
+                counters->costToTarget[i] = static_cast<double>(counters->cost);
+                counters->secondsToTarget[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - counters->start).count();
+            }
+        }
+        return value;
+    }
+
+    const Function &f;                  ///< The counted function.
+    std::shared_ptr<Counters> counters; ///< The state shared with the clones.
+};
+
+/**
+ * \struct Problem
+ * \brief A function, its area, its known minimum and a start point.
+ */
+struct Problem
+{
+    std::string name;            ///< The name in the report.
+    std::shared_ptr<Function> f; ///< The function.
+    Area area;                   ///< The search area.
+    double fMin;                 ///< The minimum of the function in the area.
+    VectorX startPoint;          ///< The start point.
+};
+
+/**
+ * \struct Solver
+ * \brief A method configuration under test.
+ */
+struct Solver
+{
+    std::string name;                              ///< The name in the report.
+    std::shared_ptr<OptimizationMethod> prototype; ///< Cloned for every run.
+};
+
+/**
+ * \struct Run
+ * \brief The costs of one solver on one problem.
+ */
+struct Run
+{
+    double evals[tausNum];   ///< Evaluation cost to reach each target, infinity if not reached.
+    double seconds[tausNum]; ///< Time to reach each target, infinity if not reached.
+};
+
+static std::vector<Problem> makeProblems()
+{
+    struct Base
+    {
+        std::string name;
+        std::shared_ptr<Function> f;
+        std::vector<std::pair<double, double>> bounds;
+        double fMin;
+    };
+    std::vector<Base> bases = {
+        {"Function1", std::make_shared<Function1>(), {{-2, 2}, {-2, 2}}, -4},
+        {"Function2", std::make_shared<Function2>(), {{-2, 2}, {-2, 2}, {-2, 2}}, -1},
+        {"Function3", std::make_shared<Function3>(), {{-3, 3}, {-3, 3}}, 0},
+        {"Function4", std::make_shared<Function4>(), {{-2, 2}, {-2, 2}}, 0},
+        {"Function5", std::make_shared<Function5>(), {{-2, 2}, {-2, 2}, {-2, 2}, {-2, 2}}, 0},
+        {"Function6", std::make_shared<Function6>(), {{-3, 3}, {-3, 3}}, 0},
+    };
+    const size_t startsNum = 3;
+
+    std::vector<Problem> problems;
+    for (const Base &base : bases)
+    {
+        size_t dim = base.f->getDim();
+        VectorX ones(dim, 1.0), stretched(dim, 1.0);
+        for (size_t i = 1; i < dim; i += 2)
+            stretched[i] = 10;
+        struct Variant
+        {
+            std::string suffix;
+            VectorX scales;
+            double valueScale;
+        };
+        for (const Variant &variant : {Variant{"", ones, 1}, Variant{"/coord10", stretched, 1}, Variant{"/value100", ones, 100}})
+        {
+            std::vector<std::pair<double, double>> bounds = base.bounds;
+            for (size_t i = 0; i < dim; ++i)
+                bounds[i] = {bounds[i].first / variant.scales[i], bounds[i].second / variant.scales[i]};
+            Area area(bounds);
+            auto f = std::make_shared<ScaledFunction>(base.f, variant.scales, variant.valueScale);
+            Xoshiro256 gen(228);
+            for (size_t s = 0; s < startsNum; ++s)
+            {
+                VectorX startPoint(dim);
+                area.genRandPoint(startPoint, gen);
+                problems.push_back({base.name + variant.suffix + "/start" + std::to_string(s), f, area, variant.valueScale * base.fMin, startPoint});
+            }
+        }
+    }
+    return problems;
+}
+
+static std::shared_ptr<OptimizationMethod> makeRandomSearch(Sampling sampling)
+{
+    auto method = std::make_shared<RandomSearch>(0.9, 0.5, 1);
+    method->setSampling(sampling);
+    return method;
+}
+
+static std::vector<Solver> makeSolvers()
+{
+    return {
+        {"Adam", std::make_shared<AdamGradientDescent>(0.01, 0.9, 0.999, 1e-8)},
+        {"ClassicGD", std::make_shared<ClassicGradientDescent>()},
+        {"ClassicGD-Brent", std::make_shared<ClassicGradientDescent>(std::make_shared<BrentLineSearch>())},
+        {"ClassicGD-Wolfe", std::make_shared<ClassicGradientDescent>(std::make_shared<StrongWolfeLineSearch>())},
+        {"RandomSearch", std::make_shared<RandomSearch>(0.9, 0.5, 1)},
+        {"Random-Sobol", makeRandomSearch(Sampling::ScrambledSobol)},
+        {"Random-Halton", makeRandomSearch(Sampling::Halton)},
+        {"LBFGSB", std::make_shared<LBFGSB>()},
+        {"NewtonCG", std::make_shared<NewtonCG>()},
+    };
+}
+
+static Run runSolver(const Solver &solver, const Problem &problem, size_t repeat)
+{
+    size_t dim = problem.f->getDim();
+    size_t budget = 2000 * (dim + 1);
+    double f0 = (*problem.f)(problem.startPoint);
+    double targets[tausNum];
+    for (size_t i = 0; i < tausNum; ++i)
+        targets[i] = problem.fMin + taus[i] * (f0 - problem.fMin);
+    DifferenceNormStopCriteria criteria(1e-12, 1000000);
+
+    Run run;
+    std::vector<std::vector<double>> times(tausNum);
+    for (size_t r = 0; r < repeat; ++r)
+    {
+        CountingFunction counted(*problem.f, targets, budget);
+        std::shared_ptr<OptimizationMethod> method = solver.prototype->clone();
+        Area area(problem.area);
+        try
+        {
+            method->optimise(problem.startPoint, area, counted, criteria);
+        }
+        catch (const BudgetExhausted &)
+        {
+        }
+        catch (const std::exception &exc)
+        {
+            std::cerr << solver.name << " failed on " << problem.name << ": " << exc.what() << std::endl;
+        }
+        for (size_t i = 0; i < tausNum; ++i)
+        {
+            run.evals[i] = counted.getCounters().costToTarget[i];
+            times[i].push_back(counted.getCounters().secondsToTarget[i]);
+        }
+    }
+    for (size_t i = 0; i < tausNum; ++i)
+    {
+        std::sort(times[i].begin(), times[i].end());
+        run.seconds[i] = times[i][times[i].size() / 2];
+    }
+    return run;
+}
+
+/**
+ * \brief Print the Dolan-More performance profile of one cost measure.
+ *
+ * For every solver the fraction of problems whose cost is within a factor
+ * alpha of the best solver's cost.
+ */
+static void printPerformanceProfile(const std::string &title, const std::vector<Solver> &solvers,
+                                    const std::vector<std::vector<double>> &cost)
+{
+    const double alphas[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+    size_t problemsNum = cost[0].size();
+    std::cout << title << std::endl;
+    std::cout << std::setw(14) << "alpha";
+    for (double alpha : alphas)
+        std::cout << std::setw(7) << static_cast<long>(alpha);
+    std::cout << std::endl;
+    for (size_t s = 0; s < solvers.size(); ++s)
+    {
+        std::cout << std::setw(14) << solvers[s].name;
+        for (double alpha : alphas)
+        {
+            size_t within = 0;
+            for (size_t p = 0; p < problemsNum; ++p)
+            {
+                double best = unsolved;
+                for (size_t o = 0; o < solvers.size(); ++o)
+                    best = std::min(best, cost[o][p]);
+                double ratio = cost[s][p] / std::max(best, std::numeric_limits<double>::min());
+                if (cost[s][p] != unsolved && ratio <= alpha)
+                    ++within;
+            }
+            std::cout << std::setw(7) << std::fixed << std::setprecision(2) << double(within) / problemsNum;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+/**
+ * \brief Print the More-Wild data profile.
+ *
+ * For every solver the fraction of problems solved within kappa simplex
+ * gradients, i.e. kappa * (n + 1) evaluations.
+ */
+static void printDataProfile(const std::string &title, const std::vector<Solver> &solvers, const std::vector<Problem> &problems,
+                             const std::vector<std::vector<double>> &evals)
+{
+    const double kappas[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000};
+    std::cout << title << std::endl;
+    std::cout << std::setw(14) << "kappa";
+    for (double kappa : kappas)
+        std::cout << std::setw(7) << static_cast<long>(kappa);
+    std::cout << std::endl;
+    for (size_t s = 0; s < solvers.size(); ++s)
+    {
+        std::cout << std::setw(14) << solvers[s].name;
+        for (double kappa : kappas)
+        {
+            size_t solved = 0;
+            for (size_t p = 0; p < problems.size(); ++p)
+                if (evals[s][p] <= kappa * (problems[p].f->getDim() + 1))
+                    ++solved;
+            std::cout << std::setw(7) << std::fixed << std::setprecision(2) << double(solved) / problems.size();
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+static std::string runKey(const std::string &problem, const std::string &solver, double tau)
+{
+    std::ostringstream key;
+    key << problem << "," << solver << "," << tau;
+    return key.str();
+}
+
+static void writeRuns(std::ostream &os, const std::vector<Solver> &solvers, const std::vector<Problem> &problems,
+                      const std::vector<std::vector<Run>> &runs)
+{
+    os << "problem,solver,tau,evals,seconds" << std::endl;
+    os << std::setprecision(17);
+    for (size_t s = 0; s < solvers.size(); ++s)
+        for (size_t p = 0; p < problems.size(); ++p)
+            for (size_t i = 0; i < tausNum; ++i)
+            {
+                const Run &run = runs[s][p];
+                os << runKey(problems[p].name, solvers[s].name, taus[i]) << ",";
+                if (run.evals[i] == unsolved)
+                    os << "-1,-1" << std::endl;
+                else
+                    os << run.evals[i] << "," << run.seconds[i] << std::endl;
+            }
+}
+
+/**
+ * \brief Compare the runs with a baseline written by writeRuns.
+ *
+ * \return The number of regressions.
+ */
+static size_t compareRuns(std::istream &is, const std::vector<Solver> &solvers, const std::vector<Problem> &problems,
+                          const std::vector<std::vector<Run>> &runs, double evalTolerance, double timeTolerance)
+{
+    std::map<std::string, std::pair<double, double>> baseline;
+    std::string line;
+    std::getline(is, line);
+    while (std::getline(is, line))
+    {
+        size_t secondsPos = line.rfind(',');
+        size_t evalsPos = line.rfind(',', secondsPos - 1);
+        if (secondsPos == std::string::npos || evalsPos == std::string::npos)
+            continue;
+        baseline[line.substr(0, evalsPos)] = {std::stod(line.substr(evalsPos + 1, secondsPos - evalsPos - 1)),
+                                              std::stod(line.substr(secondsPos + 1))};
+    }
+
+    // Times below this are dominated by timer and scheduling noise.
+    const double minSeconds = 1e-4;
+    size_t regressions = 0, improvements = 0, missing = 0;
+    for (size_t s = 0; s < solvers.size(); ++s)
+        for (size_t p = 0; p < problems.size(); ++p)
+            for (size_t i = 0; i < tausNum; ++i)
+            {
+                std::string key = runKey(problems[p].name, solvers[s].name, taus[i]);
+                auto it = baseline.find(key);
+                if (it == baseline.end())
+                {
+                    ++missing;
+                    continue;
+                }
+                double oldEvals = it->second.first, oldSeconds = it->second.second;
+                double newEvals = runs[s][p].evals[i], newSeconds = runs[s][p].seconds[i];
+                bool wasSolved = oldEvals >= 0, isSolved = newEvals != unsolved;
+                std::string reason;
+                if (wasSolved && !isSolved)
+                    reason = "no longer solved";
+                else if (wasSolved && newEvals > oldEvals * (1 + evalTolerance))
+                    reason = "evaluations " + std::to_string(static_cast<size_t>(oldEvals)) + " -> " + std::to_string(static_cast<size_t>(newEvals));
+                else if (wasSolved && oldSeconds > minSeconds && newSeconds > oldSeconds * (1 + timeTolerance))
+                    reason = "seconds " + std::to_string(oldSeconds) + " -> " + std::to_string(newSeconds);
+                if (!reason.empty())
+                {
+                    ++regressions;
+                    std::cout << "REGRESSION " << key << ": " << reason << std::endl;
+                }
+                else if ((!wasSolved && isSolved) || (wasSolved && newEvals < oldEvals))
+                    ++improvements;
+            }
+    std::cout << regressions << " regressions, " << improvements << " improvements";
+    if (missing)
+        std::cout << ", " << missing << " runs missing from the baseline";
+    std::cout << std::endl;
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t repeat = 3;
+    std::string outputPath, baselinePath;
+    double evalTolerance = 0.05, timeTolerance = 1.0;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for " + arg + ".");
+            std::string value = argv[++i];
+            if (arg == "--repeat")
+                repeat = std::stoul(value);
+            else if (arg == "--output")
+                outputPath = value;
+            else if (arg == "--baseline")
+                baselinePath = value;
+            else if (arg == "--eval-tolerance")
+                evalTolerance = std::stod(value);
+            else if (arg == "--time-tolerance")
+                timeTolerance = std::stod(value);
+            else
+                throw std::invalid_argument("Unknown option " + arg + ".");
+        }
+        if (repeat == 0)
+            throw std::invalid_argument("Number of repeats must be positive.");
+    }
+    catch (const std::exception &exc)
+    {
+        std::cerr << exc.what() << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [--repeat <n>] [--output <runs.csv>] [--baseline <runs.csv>]"
+                  << " [--eval-tolerance <fraction>] [--time-tolerance <fraction>]" << std::endl;
+        return 2;
+    }
+
+    std::vector<Problem> problems = makeProblems();
+    std::vector<Solver> solvers = makeSolvers();
+    std::vector<std::vector<Run>> runs(solvers.size(), std::vector<Run>(problems.size()));
+    for (size_t s = 0; s < solvers.size(); ++s)
+        for (size_t p = 0; p < problems.size(); ++p)
+            runs[s][p] = runSolver(solvers[s], problems[p], repeat);
+
+    std::cout << problems.size() << " problems, " << solvers.size() << " solvers" << std::endl;
+    for (size_t i = 0; i < tausNum; ++i)
+    {
+        std::vector<std::vector<double>> evals(solvers.size()), seconds(solvers.size());
+        for (size_t s = 0; s < solvers.size(); ++s)
+            for (size_t p = 0; p < problems.size(); ++p)
+            {
+                evals[s].push_back(runs[s][p].evals[i]);
+                seconds[s].push_back(runs[s][p].seconds[i]);
+            }
+        std::cout << std::endl
+                  << "tau = " << taus[i] << std::endl;
+        printPerformanceProfile("Performance profile, evaluations:", solvers, evals);
+        printPerformanceProfile("Performance profile, wall time:", solvers, seconds);
+        printDataProfile("Data profile, simplex gradients:", solvers, problems, evals);
+    }
+
+    if (!outputPath.empty())
+    {
+        std::ofstream os(outputPath);
+        if (!os)
+        {
+            std::cerr << "Cannot open output file " << outputPath << std::endl;
+            return 2;
+        }
+        writeRuns(os, solvers, problems, runs);
+    }
+    if (!baselinePath.empty())
+    {
+        std::ifstream is(baselinePath);
+        if (!is)
+        {
+            std::cerr << "Cannot open baseline file " << baselinePath << std::endl;
+            return 2;
+        }
+        std::cout << std::endl;
+        if (compareRuns(is, solvers, problems, runs, evalTolerance, timeTolerance) > 0)
+            return 1;
+    }
+    return 0;
+}
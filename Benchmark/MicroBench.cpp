@@ -0,0 +1,434 @@
+#include "Area.h"
+#include "Function.h"
+#include "FiniteDifferenceFunction.h"
+#include "OptimizationMethod.h"
+#include "ParsedFunction.h"
+#include "ScalableFunction.h"
+#include "TapeFunction.h"
+#include "TransferData.h"
+#include "VectorKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+
+/*
+ * Microbenchmarks of the per-call hot paths.
+ *
+ * Usage: MicroBench [--reps <n>] [--warmup <n>] [--min-time-ms <ms>] [--filter <text>] [--output <file.json>]
+ *
+ * Every benchmark is first calibrated so that one sample runs for at least
+ * --min-time-ms, then runs --warmup unmeasured samples and --reps measured
+ * samples. The nanoseconds per operation of each sample are sorted to report
+ * the minimum, median and 99th percentile. Allocations are counted by the
+ * global operator new below and averaged over all measured operations.
+ */
+
+static std::atomic<size_t> allocations(0);
+
+// The replacements pair malloc with free, which GCC cannot see through once new and delete are inlined.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#pragma GCC diagnostic pop
+
+/**
+ * \brief Keep a result alive so the compiler cannot drop the benchmarked call.
+ */
+static volatile double sink;
+
+static void keep(double value)
+{
+    sink = value;
+}
+
+static void keep(const VectorX &x)
+{
+    sink = x.empty() ? 0 : x[0];
+}
+
+/**
+ * \struct Benchmark
+ * \brief A named operation to be timed.
+ */
+struct Benchmark
+{
+    std::string name;           ///< The name in the report.
+    std::function<void()> body; ///< One operation.
+};
+
+/**
+ * \struct BenchmarkResult
+ * \brief Statistics of one benchmark.
+ */
+struct BenchmarkResult
+{
+    std::string name;     ///< The name of the benchmark.
+    size_t opsPerSample;  ///< Operations per timed sample.
+    size_t reps;          ///< Number of timed samples.
+    double nsMin;         ///< Fastest sample, ns/op.
+    double nsMedian;      ///< Median sample, ns/op.
+    double nsP99;         ///< 99th percentile sample, ns/op.
+    double allocsPerOp;   ///< Heap allocations per operation.
+};
+
+/**
+ * \struct BenchmarkOptions
+ * \brief Options of the benchmark run.
+ */
+struct BenchmarkOptions
+{
+    size_t reps = 50;           ///< Timed samples per benchmark.
+    size_t warmup = 5;          ///< Untimed samples per benchmark.
+    double minTimeMs = 2;       ///< Minimum duration of one sample.
+    std::string filter;         ///< Only run benchmarks whose name contains this.
+    std::string output;         ///< JSON output file, stdout if empty.
+};
+
+static double sampleNs(const std::function<void()> &body, size_t ops)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i)
+        body();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static BenchmarkResult measure(const Benchmark &bench, const BenchmarkOptions &options)
+{
+    size_t ops = 1;
+    while (sampleNs(bench.body, ops) < options.minTimeMs * 1e6 && ops < (size_t(1) << 40))
+        ops *= 2;
+    for (size_t i = 0; i < options.warmup; ++i)
+        sampleNs(bench.body, ops);
+
+    std::vector<double> samples(options.reps);
+    size_t allocsBefore = allocations.load(std::memory_order_relaxed);
+    for (double &sample : samples)
+        sample = sampleNs(bench.body, ops) / ops;
+    size_t allocs = allocations.load(std::memory_order_relaxed) - allocsBefore;
+
+    std::sort(samples.begin(), samples.end());
+    size_t p99 = std::min(samples.size() - 1, static_cast<size_t>(0.99 * samples.size()));
+    return {bench.name, ops, options.reps, samples.front(), samples[samples.size() / 2], samples[p99],
+            static_cast<double>(allocs) / (ops * options.reps)};
+}
+
+template <typename F>
+static void addFunctionBenchmarks(std::vector<Benchmark> &benchmarks, const std::string &name)
+{
+    auto f = std::make_shared<F>();
+    auto x = std::make_shared<VectorX>(F::Dim);
+    for (size_t i = 0; i < F::Dim; ++i)
+        (*x)[i] = 0.3 + 0.1 * i;
+    benchmarks.push_back({name + "::operator()", [f, x]
+                          { keep((*f)(*x)); }});
+    benchmarks.push_back({name + "::grad", [f, x]
+                          { keep(f->grad(*x)); }});
+}
+
+static std::vector<Benchmark> makeBenchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+
+    for (size_t n : {2, 256})
+    {
+        auto a = std::make_shared<VectorX>(n, 1.5);
+        auto b = std::make_shared<VectorX>(n, -0.25);
+        auto c = std::make_shared<VectorX>(n);
+        std::string suffix = "/" + std::to_string(n);
+        benchmarks.push_back({"VectorX::operator+" + suffix, [a, b, c]
+                              { *c = *a + *b; keep(*c); }});
+        benchmarks.push_back({"VectorX::operator-" + suffix, [a, b, c]
+                              { *c = *a - *b; keep(*c); }});
+        benchmarks.push_back({"VectorX::operator*" + suffix, [a, c]
+                              { *c = 0.5 * *a; keep(*c); }});
+        benchmarks.push_back({"VectorX::operator+=" + suffix, [b, c]
+                              { *c += *b; keep(*c); }});
+        benchmarks.push_back({"VectorX::axpy" + suffix, [b, c]
+                              { *c -= 1e-3 * *b; keep(*c); }});
+        benchmarks.push_back({"VectorX::copy" + suffix, [a]
+                              { VectorX copy(*a); keep(copy); }});
+        benchmarks.push_back({"norm" + suffix, [a]
+                              { keep(norm(*a)); }});
+    }
+
+    addFunctionBenchmarks<Function1>(benchmarks, "Function1");
+    addFunctionBenchmarks<Function2>(benchmarks, "Function2");
+    addFunctionBenchmarks<Function3>(benchmarks, "Function3");
+    addFunctionBenchmarks<Function4>(benchmarks, "Function4");
+    addFunctionBenchmarks<Function5>(benchmarks, "Function5");
+    addFunctionBenchmarks<Function6>(benchmarks, "Function6");
+
+    // The formula of Function4, compiled at run time, next to its native code.
+    auto parsed = std::make_shared<ParsedFunction>("(1 - x)^2 + 100(y - x^2)^2");
+    auto parsedX = std::make_shared<VectorX>(VectorX{0.3, 0.4});
+    benchmarks.push_back({"ParsedFunction::operator()", [parsed, parsedX]
+                          { keep((*parsed)(*parsedX)); }});
+    benchmarks.push_back({"ParsedFunction::grad", [parsed, parsedX]
+                          { keep(parsed->grad(*parsedX)); }});
+    auto batch = std::make_shared<PointBatch>(2, 1024);
+    for (size_t k = 0; k < batch->getCount(); ++k)
+        batch->setPoint(k, VectorX{0.001 * k, 0.5 - 0.001 * k});
+    auto batchValues = std::make_shared<std::vector<double>>(batch->getCount());
+    auto batchGrads = std::make_shared<PointBatch>();
+    for (const auto &[name, f] : std::vector<std::pair<std::string, std::shared_ptr<Function>>>{
+             {"Function4", std::make_shared<Function4>()}, {"ParsedFunction", parsed}})
+    {
+        benchmarks.push_back({name + "::evaluateBatch/1024", [f, batch, batchValues]
+                              { f->evaluateBatch(*batch, batchValues->data()); keep((*batchValues)[0]); }});
+        benchmarks.push_back({name + "::evaluateBatch+grad/1024", [f, batch, batchValues, batchGrads]
+                              { f->evaluateBatch(*batch, batchValues->data(), batchGrads.get()); keep((*batchValues)[0]); }});
+    }
+
+    // The cost of differencing a cheap function, which is mostly the stencil
+    // bookkeeping, through a formula per point and through one batch.
+    auto native = std::make_shared<Function4>();
+    auto pointwise = std::make_shared<FiniteDifferenceFunction>("Function4", 2, FiniteDifferenceFunction::Formula([native](const VectorX &x)
+                                                                                                                 { return (*native)(x); }));
+    auto batched = std::make_shared<FiniteDifferenceFunction>("Function4", 2, FiniteDifferenceFunction::BatchFormula([native](const PointBatch &points, double *values)
+                                                                                                                     { native->evaluateBatch(points, values); }));
+    benchmarks.push_back({"FiniteDifferenceFunction::grad", [pointwise, parsedX]
+                          { keep(pointwise->grad(*parsedX)); }});
+    benchmarks.push_back({"FiniteDifferenceFunction::grad batched", [batched, parsedX]
+                          { keep(batched->grad(*parsedX)); }});
+    benchmarks.push_back({"FiniteDifferenceFunction::evaluateBatch+grad/1024", [batched, batch, batchValues, batchGrads]
+                          { batched->evaluateBatch(*batch, batchValues->data(), batchGrads.get()); keep((*batchValues)[0]); }});
+
+    // The scalable functions in cache and far beyond it, to show where memory
+    // bandwidth takes over from arithmetic.
+    for (const char *id : {"rosenbrock", "rastrigin", "ackley", "griewank", "styblinskitang", "quadratic"})
+    {
+        for (size_t n : {1000, 1000000})
+        {
+            std::shared_ptr<ScalableFunction> f = makeScalableFunction(id, n);
+            auto x = std::make_shared<VectorX>(n);
+            for (size_t i = 0; i < n; ++i)
+                (*x)[i] = 0.5 + 1e-6 * i;
+            std::string name = std::string(id) + "/" + std::to_string(n);
+            benchmarks.push_back({name + "::operator()", [f, x]
+                                  { keep((*f)(*x)); }});
+            benchmarks.push_back({name + "::evaluate+grad", [f, x]
+                                  { keep(f->evaluate(*x, true).value); }});
+        }
+    }
+
+    for (size_t n : {100, 10000})
+    {
+        auto f = std::make_shared<TapeFunction>("chained Rosenbrock", n, [](const std::vector<TapeVar> &x)
+                                                {
+            TapeVar sum;
+            for (size_t i = 0; i + 1 < x.size(); ++i)
+            {
+                TapeVar a = 1 - x[i];
+                TapeVar b = x[i + 1] - x[i] * x[i];
+                sum += a * a + 100 * b * b;
+            }
+            return sum; });
+        auto x = std::make_shared<VectorX>(n, 0.5);
+        std::string suffix = "/" + std::to_string(n);
+        benchmarks.push_back({"TapeFunction::operator()" + suffix, [f, x]
+                              { keep((*f)(*x)); }});
+        benchmarks.push_back({"TapeFunction::grad" + suffix, [f, x]
+                              { keep(f->grad(*x)); }});
+    }
+
+    // Whole runs of a fixed number of iterations; the methods are reused, so
+    // allocs_per_op shows what a warm run still takes from the heap.
+    {
+        std::shared_ptr<Function> f = makeScalableFunction("rosenbrock", 100);
+        auto box = std::make_shared<Area>(std::vector<std::pair<double, double>>(100, {-2, 2}));
+        auto start = std::make_shared<VectorX>(100, -1.2);
+        auto criteria = std::make_shared<DifferenceNormStopCriteria>(0, 50);
+        std::vector<std::shared_ptr<OptimizationMethod>> methods = {
+            std::make_shared<AdamGradientDescent>(1e-3, 0.9, 0.999, 1e-8),
+            std::make_shared<ClassicGradientDescent>(std::make_shared<StrongWolfeLineSearch>()),
+            std::make_shared<LBFGSB>(),
+            std::make_shared<NewtonCG>()};
+        for (const std::shared_ptr<OptimizationMethod> &method : methods)
+        {
+            benchmarks.push_back({method->getName() + "::optimise/50 iterations", [f, box, start, criteria, method]
+                                  { method->optimise(*start, *box, *f, *criteria); keep(method->getIterNum()); }});
+        }
+    }
+
+    // Adam on Function4 through the Function interface and compiled for it.
+    {
+        auto f = std::make_shared<Function4>();
+        auto box = std::make_shared<Area>(std::vector<std::pair<double, double>>(2, {-2, 2}));
+        auto start = std::make_shared<VectorX>(VectorX{-1.2, 1});
+        auto criteria = std::make_shared<DifferenceNormStopCriteria>(0, 1000);
+        auto adam = std::make_shared<AdamGradientDescent>(1e-3, 0.9, 0.999, 1e-8);
+        auto fixed = std::make_shared<FixedAdamGradientDescent<Function4>>(1e-3, 0.9, 0.999, 1e-8);
+        benchmarks.push_back({"AdamGradientDescent::optimise/Function4 1000 iterations", [f, box, start, criteria, adam]
+                              { adam->optimise(*start, *box, *f, *criteria); keep(adam->getIterNum()); }});
+        benchmarks.push_back({"FixedAdamGradientDescent<Function4>::optimise/1000 iterations", [f, box, start, criteria, fixed]
+                              { fixed->optimise(VectorN<2>(*start), *box, *f, *criteria); keep(fixed->getIterNum()); }});
+    }
+
+    auto area = std::make_shared<Area>(std::vector<std::pair<double, double>>{{-3, 3}, {-2, 2}, {-1, 1}});
+    auto other = std::make_shared<Area>(std::vector<std::pair<double, double>>{{0, 5}, {-5, 0}, {-0.5, 0.5}});
+    auto inside = std::make_shared<VectorX>(VectorX{0.5, -0.5, 0.25});
+    auto point = std::make_shared<VectorX>(3);
+    auto gen = std::make_shared<Xoshiro256>(228);
+    benchmarks.push_back({"Area::inArea", [area, inside]
+                          { keep(area->inArea(*inside)); }});
+    benchmarks.push_back({"Area::genRandPoint", [area, point, gen]
+                          { area->genRandPoint(*point, *gen); keep(*point); }});
+    for (size_t n : {256, 4096})
+    {
+        auto box = std::make_shared<Area>(std::vector<std::pair<double, double>>(n, {-5, 5}));
+        auto u = std::make_shared<VectorX>(n);
+        auto xoshiro = std::make_shared<Xoshiro256>(228);
+        auto philox = std::make_shared<Philox4x32>(228);
+        auto mersenne = std::make_shared<std::mt19937_64>(228);
+        std::string suffix = "/" + std::to_string(n);
+        benchmarks.push_back({"Xoshiro256::fillUniform" + suffix, [u, xoshiro]
+                              { xoshiro->fillUniform(u->data(), u->size()); keep(*u); }});
+        benchmarks.push_back({"Philox4x32::fillUniform" + suffix, [u, philox]
+                              { philox->fillUniform(u->data(), u->size()); keep(*u); }});
+        benchmarks.push_back({"std::mt19937_64 uniform" + suffix, [u, mersenne]
+                              {
+            std::uniform_real_distribution<> unit(0, 1);
+            for (double &ui : *u)
+                ui = unit(*mersenne);
+            keep(*u); }});
+        benchmarks.push_back({"Area::genRandPoint Philox" + suffix, [box, u, philox]
+                              { box->genRandPoint(*u, *philox); keep(*u); }});
+    }
+    auto unitPoint = std::make_shared<std::vector<double>>(SobolSequence::maxDim);
+    for (std::shared_ptr<RandomEngine> sequence : {makeSampler(Sampling::Sobol, SobolSequence::maxDim, 228),
+                                                   makeSampler(Sampling::ScrambledSobol, SobolSequence::maxDim, 228),
+                                                   makeSampler(Sampling::Halton, SobolSequence::maxDim, 228)})
+    {
+        benchmarks.push_back({sequence->getName() + " nextPoint/" + std::to_string(SobolSequence::maxDim), [unitPoint, sequence]
+                              { sequence->nextPoint(unitPoint->data(), unitPoint->size()); keep((*unitPoint)[0]); }});
+    }
+    benchmarks.push_back({"intersect", [area, other]
+                          { Area result = intersect(*area, *other); keep(result.getBounds()[0].first); }});
+
+    auto data = std::make_shared<TransferData>();
+    auto trajectory = std::make_shared<std::vector<VectorX>>(1000, VectorX{0.5, -0.5});
+    benchmarks.push_back({"TransferData::setPoints/1000", [data, trajectory]
+                          { data->setPoints(*trajectory); keep(data->getCurrPoint()); }});
+
+    return benchmarks;
+}
+
+static void writeJson(std::ostream &os, const std::vector<BenchmarkResult> &results, const BenchmarkOptions &options)
+{
+    os << "{\n";
+    os << "  \"kernels\": \"" << vectorKernels().name << "\",\n";
+    os << "  \"reps\": " << options.reps << ",\n";
+    os << "  \"warmup\": " << options.warmup << ",\n";
+    os << "  \"min_time_ms\": " << options.minTimeMs << ",\n";
+    os << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult &r = results[i];
+        os << "    {\"name\": \"" << r.name << "\", \"ops_per_sample\": " << r.opsPerSample
+           << ", \"ns_per_op_min\": " << r.nsMin << ", \"ns_per_op_median\": " << r.nsMedian
+           << ", \"ns_per_op_p99\": " << r.nsP99 << ", \"allocs_per_op\": " << r.allocsPerOp << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+int main(int argc, char *argv[])
+{
+    BenchmarkOptions options;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for " + arg + ".");
+            std::string value = argv[++i];
+            if (arg == "--reps")
+                options.reps = std::stoul(value);
+            else if (arg == "--warmup")
+                options.warmup = std::stoul(value);
+            else if (arg == "--min-time-ms")
+                options.minTimeMs = std::stod(value);
+            else if (arg == "--filter")
+                options.filter = value;
+            else if (arg == "--output")
+                options.output = value;
+            else
+                throw std::invalid_argument("Unknown option " + arg + ".");
+        }
+        if (options.reps == 0)
+            throw std::invalid_argument("Number of repetitions must be positive.");
+    }
+    catch (const std::exception &exc)
+    {
+        std::cerr << exc.what() << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [--reps <n>] [--warmup <n>] [--min-time-ms <ms>] [--filter <text>] [--output <file.json>]" << std::endl;
+        return 2;
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (const Benchmark &bench : makeBenchmarks())
+    {
+        if (bench.name.find(options.filter) == std::string::npos)
+            continue;
+        results.push_back(measure(bench, options));
+        const BenchmarkResult &r = results.back();
+        std::cerr << r.name << ": median " << r.nsMedian << " ns/op, p99 " << r.nsP99
+                  << " ns/op, " << r.allocsPerOp << " allocs/op" << std::endl;
+    }
+
+    if (options.output.empty())
+    {
+        writeJson(std::cout, results, options);
+        return 0;
+    }
+    std::ofstream os(options.output);
+    if (!os)
+    {
+        std::cerr << "Cannot open output file " << options.output << std::endl;
+        return 2;
+    }
+    writeJson(os, results, options);
+    return 0;
+}
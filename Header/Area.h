@@ -1,7 +1,7 @@
 ﻿#pragma once
 #include "VectorX.h"
+#include "RandomEngine.h"
 #include <stdexcept>
-#include <random>
 /**
  * \class Area
  * \brief Class representing a multidimensional area defined by bounding intervals.
@@ -15,7 +15,7 @@ class Area
     friend Area intersect(const Area &area1, const Area &area2); ///< Friend function to calculate the intersection of two areas.
 
 public:
-    Area() = default;
+    Area();
 
     Area(const std::vector<std::pair<double, double>> &bounds);
 
@@ -33,7 +33,7 @@ public:
      *
      * \return A vector of pairs representing the bounds of each dimension.
      */
-    std::vector<std::pair<double, double>> getBounds() const;
+    const std::vector<std::pair<double, double>> &getBounds() const;
     /**
      * \brief Check if a point is within the area.
      *
@@ -44,10 +44,13 @@ public:
     /**
      * \brief Generate a random point within the area.
      *
-     * \param x A vector to store the generated point.
-     * \param gen A random number generator.
+     * The engine writes a point of the unit cube straight into x, which is
+     * then scaled onto the bounds in one pass.
+     *
+     * \param x A vector of the dimension of the area to store the generated point.
+     * \param engine The source of the point.
      */
-    void genRandPoint(VectorX &x, std::mt19937 gen);
+    void genRandPoint(VectorX &x, RandomEngine &engine) const;
     /**
      * \brief Change the bounds of the area.
      *
@@ -56,10 +59,8 @@ public:
     void change(const std::vector<std::pair<double, double>> &newBounds);
 
 protected:
-    std::vector<std::uniform_real_distribution<>> dis; ///< Distributions for random point generation.
-    std::vector<std::pair<double, double>> bounds;     ///< The bounds of the area.
-    size_t dimension;                                  ///< The number of dimensions of the area.
-    bool isRandInitialized;                            ///< Flag indicating if random distributions are initialized.
+    std::vector<std::pair<double, double>> bounds; ///< The bounds of the area.
+    size_t dimension;                              ///< The number of dimensions of the area.
 
 private:
     /**
@@ -0,0 +1,84 @@
+#pragma once
+#include "Sweep.h"
+#include <istream>
+
+/**
+ * \struct BatchJob
+ * \brief One optimization run described by a line of a job file.
+ */
+struct BatchJob
+{
+	size_t line;								 ///< The line of the job file.
+	std::shared_ptr<Function> f;				 ///< The function to optimize.
+	Area area;									 ///< The search area.
+	VectorX startPoint;							 ///< The start point.
+	std::shared_ptr<StopCriteria> criteria;		 ///< The stopping criteria.
+	std::shared_ptr<OptimizationMethod> method; ///< The optimization method.
+	size_t traceEvery = 0;						 ///< Trace every Nth iteration, 0 for no trace.
+	bool histogram = false;						 ///< Whether to collect a PhaseHistogram.
+};
+
+/**
+ * \brief Parse one line of a job file.
+ *
+ * A job is a list of whitespace-separated key=value fields:
+ * - function: 1-6, numbered as in the interactive menu, or instead formula:
+ *   a formula for ParsedFunction written without spaces, such as (1-x)^2+100(y-x^2)^2;
+ * - dim: if given, function names a ScalableFunction of that dimension:
+ *   rosenbrock, rastrigin, ackley, griewank, styblinskitang or quadratic;
+ * - bounds: min:max per coordinate, separated by commas, or a single min:max for all;
+ * - start: the coordinates of the start point, separated by commas, or a single value for all;
+ * - criterion: 1-3 or grad, difference, funcdifference; eps; maxiter;
+ * - method: 1-6 or adam, classic, random, lbfgsb, newtoncg, fixedadam, followed by its parameters:
+ *   alpha, beta1, beta2, epsilon for adam and fixedadam, alpha, p, delta for
+ *   random and memory for lbfgsb; classic takes an optional linesearch:
+ *   ternary (default), golden, brent or wolfe, and random an optional
+ *   sampling: random (default), sobol, scrambled-sobol or halton; fixedadam
+ *   is Adam compiled for one of the functions 1-6;
+ * - trace: optional, trace every Nth iteration with a SampledTracer;
+ * - histogram: optional, 1 to collect a PhaseHistogram of the iterations.
+ *
+ * For example:
+ * `function=4 bounds=-3:3,-3:3 start=-1,1 criterion=grad eps=1e-6 maxiter=10000 method=adam alpha=0.01 beta1=0.9 beta2=0.999 epsilon=1e-8`
+ * `function=rosenbrock dim=100000 bounds=-2:2 start=-1 criterion=grad eps=1e-6 maxiter=10000 method=lbfgsb memory=10`
+ *
+ * \param text The line without comments.
+ * \param line The line number, stored in the job.
+ * \return The parsed job.
+ * \throw std::invalid_argument If a field is missing or malformed.
+ */
+BatchJob parseBatchJob(const std::string &text, size_t line);
+
+/**
+ * \brief Run every job of a job file and write the results as CSV.
+ *
+ * Empty lines and text after '#' are ignored. Jobs run concurrently on a
+ * WorkStealingScheduler; a row is written as soon as a job finishes, with the
+ * line number of the job in the first column. Lines that fail to parse are
+ * reported as rows with an error message. The trace and the histogram of a
+ * job are written to a separate stream once the job finishes, after a line
+ * "# job <line>".
+ *
+ * \param jobs The job file contents.
+ * \param results The stream to write the results to.
+ * \param threads The number of threads; 0 selects the number of hardware threads.
+ * \param traces The stream to write traces and histograms to.
+ * \return 0 if every job ran, 1 if any job failed.
+ */
+int runBatch(std::istream &jobs, std::ostream &results, size_t threads, std::ostream &traces);
+
+/**
+ * \brief Run the built-in grid of the interactive menu and write the results as CSV.
+ *
+ * Every function 1-6 on a fixed area is minimized by every method 1-5 with
+ * default parameters, under every stopping criterion with eps 1e-6 and at
+ * most 10000 iterations, from the same scrambled Sobol start points. The
+ * jobs run on a Sweep; a row is written as soon as a job finishes, with the
+ * position of the job in the grid in the first column.
+ *
+ * \param results The stream to write the results to.
+ * \param startsNum The number of start points per function.
+ * \param threads The number of threads; 0 selects the number of hardware threads.
+ * \return 0 if every job ran, 1 if any job failed.
+ */
+int runSweep(std::ostream &results, size_t startsNum, size_t threads);
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+/**
+ * \brief Force inlining of the dual-number operations.
+ *
+ * A formula over dual numbers is only fast once every operation is inlined
+ * into the caller: the partials then live in registers and a loop over points
+ * vectorizes across the points. The inliner gives up on long formulas, so the
+ * operations insist.
+ */
+#if defined(_MSC_VER)
+#define DUAL_INLINE __forceinline
+#define DUAL_INLINE_LAMBDA
+#else
+#define DUAL_INLINE inline __attribute__((always_inline))
+#define DUAL_INLINE_LAMBDA __attribute__((always_inline))
+#endif
+
+/**
+ * \class Dual
+ * \brief A dual number carrying a value and N partial derivatives.
+ *
+ * Forward-mode automatic differentiation: a formula written once as a
+ * template over its scalar type yields its value for double and, for
+ * Dual<N>, its value together with all N partial derivatives in one pass.
+ * The partials are stored in one array and every operation updates them in a
+ * loop over the constant N, so the compiler unrolls the loop and vectorizes it
+ * across the lanes.
+ *
+ * The scalar type T can itself be a dual number. Nesting gives second
+ * derivatives, which is how hessianVectorProduct() works.
+ *
+ * \tparam N The number of partial derivatives.
+ * \tparam T The type of the value and of the partials.
+ */
+template <size_t N, typename T = double>
+class Dual
+{
+public:
+    T value;                   ///< The value.
+    std::array<T, N> partials; ///< The partial derivatives with respect to the N variables.
+
+    DUAL_INLINE Dual() : value(0), partials{} {}
+
+    /**
+     * \brief A constant: all partial derivatives are zero.
+     */
+    DUAL_INLINE Dual(const T &constant) : value(constant), partials{} {}
+
+    /**
+     * \brief A constant given as double when the value is itself a dual number.
+     */
+    DUAL_INLINE Dual(double constant)
+        requires(!std::is_same_v<T, double>)
+        : value(constant), partials{}
+    {
+    }
+
+    DUAL_INLINE Dual(const T &value, const std::array<T, N> &partials) : value(value), partials(partials) {}
+
+    /**
+     * \brief The independent variable with the given index.
+     *
+     * \param value The value of the variable.
+     * \param index The index of the variable, its partial derivative is 1.
+     * \return The seeded dual number.
+     */
+    DUAL_INLINE static Dual variable(const T &value, size_t index)
+    {
+        Dual x(value);
+        x.partials[index] = 1;
+        return x;
+    }
+
+    DUAL_INLINE Dual &operator+=(const Dual &other)
+    {
+        value += other.value;
+        for (size_t i = 0; i < N; ++i)
+            partials[i] += other.partials[i];
+        return *this;
+    }
+
+    DUAL_INLINE Dual &operator-=(const Dual &other)
+    {
+        value -= other.value;
+        for (size_t i = 0; i < N; ++i)
+            partials[i] -= other.partials[i];
+        return *this;
+    }
+
+    DUAL_INLINE Dual &operator*=(const Dual &other)
+    {
+        for (size_t i = 0; i < N; ++i)
+            partials[i] = partials[i] * other.value + value * other.partials[i];
+        value *= other.value;
+        return *this;
+    }
+
+    DUAL_INLINE Dual &operator/=(const Dual &other)
+    {
+        T inverse = 1 / other.value;
+        value *= inverse;
+        for (size_t i = 0; i < N; ++i)
+            partials[i] = (partials[i] - value * other.partials[i]) * inverse;
+        return *this;
+    }
+};
+
+/**
+ * \brief Apply the chain rule: the result has value f and derivative df times the partials of a.
+ */
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> chain(const Dual<N, T> &a, const T &f, const T &df)
+{
+    Dual<N, T> result(f);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = df * a.partials[i];
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator-(const Dual<N, T> &a)
+{
+    Dual<N, T> result(-a.value);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = -a.partials[i];
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator+(const Dual<N, T> &a, const Dual<N, T> &b)
+{
+    Dual<N, T> result(a.value + b.value);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = a.partials[i] + b.partials[i];
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator+(const Dual<N, T> &a, double b)
+{
+    return Dual<N, T>(a.value + b, a.partials);
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator+(double a, const Dual<N, T> &b)
+{
+    return Dual<N, T>(a + b.value, b.partials);
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator-(const Dual<N, T> &a, const Dual<N, T> &b)
+{
+    Dual<N, T> result(a.value - b.value);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = a.partials[i] - b.partials[i];
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator-(const Dual<N, T> &a, double b)
+{
+    return Dual<N, T>(a.value - b, a.partials);
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator-(double a, const Dual<N, T> &b)
+{
+    Dual<N, T> result(a - b.value);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = -b.partials[i];
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator*(const Dual<N, T> &a, const Dual<N, T> &b)
+{
+    Dual<N, T> result(a.value * b.value);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = a.partials[i] * b.value + a.value * b.partials[i];
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator*(const Dual<N, T> &a, double b)
+{
+    Dual<N, T> result(a.value * b);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = a.partials[i] * b;
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator*(double a, const Dual<N, T> &b)
+{
+    return b * a;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator/(const Dual<N, T> &a, const Dual<N, T> &b)
+{
+    T inverse = 1 / b.value;
+    Dual<N, T> result(a.value * inverse);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = (a.partials[i] - result.value * b.partials[i]) * inverse;
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator/(const Dual<N, T> &a, double b)
+{
+    return a * (1 / b);
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> operator/(double a, const Dual<N, T> &b)
+{
+    T inverse = 1 / b.value;
+    Dual<N, T> result(a * inverse);
+    for (size_t i = 0; i < N; ++i)
+        result.partials[i] = -result.value * b.partials[i] * inverse;
+    return result;
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> sin(const Dual<N, T> &a)
+{
+    using std::cos, std::sin;
+    return chain(a, T(sin(a.value)), T(cos(a.value)));
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> cos(const Dual<N, T> &a)
+{
+    using std::cos, std::sin;
+    return chain(a, T(cos(a.value)), T(-sin(a.value)));
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> exp(const Dual<N, T> &a)
+{
+    using std::exp;
+    T e = exp(a.value);
+    return chain(a, e, e);
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> log(const Dual<N, T> &a)
+{
+    using std::log;
+    return chain(a, T(log(a.value)), T(1 / a.value));
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> sqrt(const Dual<N, T> &a)
+{
+    using std::sqrt;
+    T s = sqrt(a.value);
+    return chain(a, s, T(0.5 / s));
+}
+
+template <size_t N, typename T>
+DUAL_INLINE Dual<N, T> pow(const Dual<N, T> &a, double p)
+{
+    using std::pow;
+    return chain(a, T(pow(a.value, p)), T(p * pow(a.value, p - 1)));
+}
+
+/**
+ * \brief Calculate the value and the gradient of a formula in one forward pass.
+ *
+ * \param formula A generic callable taking std::array<T, N> and returning T.
+ * \param x The point.
+ * \param grad Receives the gradient at x.
+ * \return The value at x.
+ */
+template <size_t N, typename Formula>
+DUAL_INLINE double valueAndGradient(Formula &&formula, const std::array<double, N> &x, std::array<double, N> &grad)
+{
+    // Seed every variable with a constant index, so that the unit partials
+    // fold into the formula instead of going through memory.
+    Dual<N> y = [&]<size_t... I>(std::index_sequence<I...>) DUAL_INLINE_LAMBDA
+    { return formula(std::array<Dual<N>, N>{Dual<N>::variable(x[I], I)...}); }(std::make_index_sequence<N>());
+    grad = y.partials;
+    return y.value;
+}
+
+/**
+ * \brief Calculate the product of the Hessian of a formula with a vector.
+ *
+ * Differentiates the gradient along v by nesting a one-lane dual number
+ * inside the N-lane one, so H v is exact and costs one pass.
+ *
+ * \param formula A generic callable taking std::array<T, N> and returning T.
+ * \param x The point at which the Hessian is taken.
+ * \param v The vector to multiply.
+ * \param hv Receives the product H(x) v.
+ */
+template <size_t N, typename Formula>
+DUAL_INLINE void hessianVectorProduct(Formula &&formula, const std::array<double, N> &x, const std::array<double, N> &v, std::array<double, N> &hv)
+{
+    using Directional = Dual<1>;
+    Dual<N, Directional> y = [&]<size_t... I>(std::index_sequence<I...>) DUAL_INLINE_LAMBDA
+    { return formula(std::array<Dual<N, Directional>, N>{Dual<N, Directional>::variable(Directional(x[I], {v[I]}), I)...}); }(std::make_index_sequence<N>());
+    for (size_t i = 0; i < N; ++i)
+        hv[i] = y.partials[i].partials[0];
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "Function.h"
+#include "ThreadPool.h"
+#include <complex>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \brief The difference formulas of FiniteDifferenceFunction.
+ */
+enum class DifferenceScheme
+{
+    Forward,     ///< (f(x + h e_i) - f(x)) / h: n + 1 values, error O(h).
+    Central,     ///< (f(x + h e_i) - f(x - h e_i)) / 2h: 2n values, error O(h^2).
+    ComplexStep, ///< Im f(x + i h e_i) / h: n complex values, exact to rounding.
+};
+
+/**
+ * \class FiniteDifferenceFunction
+ * \brief A function known only by its values, differentiated by finite differences.
+ *
+ * Makes black-box objectives, such as simulators, usable with the gradient
+ * methods. The step of coordinate i is chosen from the scheme and the
+ * magnitude of x_i: sqrt(eps) max(|x_i|, 1) for forward differences,
+ * cbrt(eps) max(|x_i|, 1) for central differences, which balances the
+ * truncation and the rounding error, and 1e-20 max(|x_i|, 1) for the complex
+ * step, which has no subtractive cancellation. The step is rounded so that
+ * x_i + h is exactly representable.
+ *
+ * The perturbed points of a gradient are independent. They are evaluated in
+ * one call of the batch formula if there is one, split between the calling
+ * thread and a thread pool if one is set, or one by one otherwise. With a
+ * pool, the formula is called from several threads at once and must be safe
+ * to do so.
+ *
+ * Every value the formula calculates is counted in threadRunStats.valueCalls
+ * of the calling thread, and every gradient in gradCalls, so the statistics
+ * of a run show the true cost of the differences.
+ */
+class FiniteDifferenceFunction : public Function
+{
+public:
+    /**
+     * \brief A formula that calculates one value.
+     */
+    using Formula = std::function<double(const VectorX &x)>;
+    /**
+     * \brief A formula that calculates the values of all points of a batch at once.
+     */
+    using BatchFormula = std::function<void(const PointBatch &points, double *values)>;
+    /**
+     * \brief A formula that accepts complex arguments, for the complex step.
+     *
+     * It must be analytic in its arguments and use no comparisons, abs or
+     * other operations that discard the imaginary part.
+     */
+    using ComplexFormula = std::function<std::complex<double>(const std::vector<std::complex<double>> &x)>;
+
+    /**
+     * \brief Constructor for a formula evaluated one point at a time.
+     *
+     * \param name The name of the function.
+     * \param dim The dimension of the function.
+     * \param formula The formula of the function.
+     * \param scheme The difference formula, Forward or Central.
+     * \throw std::invalid_argument If dim is zero, formula is empty or scheme is ComplexStep.
+     */
+    FiniteDifferenceFunction(const std::string &name, size_t dim, Formula formula, DifferenceScheme scheme = DifferenceScheme::Central);
+    /**
+     * \brief Constructor for a formula evaluated a batch at a time.
+     *
+     * \param name The name of the function.
+     * \param dim The dimension of the function.
+     * \param formula The formula of the function.
+     * \param scheme The difference formula, Forward or Central.
+     * \throw std::invalid_argument If dim is zero, formula is empty or scheme is ComplexStep.
+     */
+    FiniteDifferenceFunction(const std::string &name, size_t dim, BatchFormula formula, DifferenceScheme scheme = DifferenceScheme::Central);
+    /**
+     * \brief Constructor for a formula differentiated by the complex step.
+     *
+     * \param name The name of the function.
+     * \param dim The dimension of the function.
+     * \param formula The formula of the function.
+     * \throw std::invalid_argument If dim is zero or formula is empty.
+     */
+    FiniteDifferenceFunction(const std::string &name, size_t dim, ComplexFormula formula);
+    ~FiniteDifferenceFunction();
+    std::shared_ptr<Function> clone() const override;
+    /**
+     * \brief Evaluate the perturbed points on a thread pool.
+     *
+     * The pool is shared by the clones. It must not be the pool that calls
+     * the function, because a gradient waits for the tasks it submits.
+     * Ignored if the function has a batch formula.
+     *
+     * \param pool The pool, or null to evaluate on the calling thread only.
+     */
+    void setThreadPool(std::shared_ptr<ThreadPool> pool);
+    /**
+     * \brief Override the automatic step.
+     *
+     * \param relativeStep The step relative to max(|x_i|, 1), or 0 to choose it from the scheme.
+     * \throw std::invalid_argument If relativeStep is negative.
+     */
+    void setRelativeStep(double relativeStep);
+    /**
+     * \brief Get the difference formula.
+     *
+     * \return The difference formula.
+     */
+    DifferenceScheme getScheme() const;
+
+protected:
+    double calcValue(const VectorX &x) const override;
+    VectorX calcGrad(const VectorX &x) const override;
+    Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+    void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
+
+private:
+    /**
+     * \brief Calculate the values of the formula at the points of a batch.
+     *
+     * \param points The points to evaluate.
+     * \param values Receives points.getCount() values.
+     */
+    void evaluatePoints(const PointBatch &points, double *values) const;
+    /**
+     * \brief Calculate the gradient by the complex step.
+     *
+     * \param x The point at which the gradient is calculated.
+     * \param value If not null, receives the value at x.
+     * \return The gradient at x.
+     */
+    VectorX complexStepGrad(const VectorX &x, double *value) const;
+    /**
+     * \brief Calculate the gradients at the points of a batch.
+     *
+     * All perturbed points of the batch are evaluated by one call of
+     * evaluatePoints().
+     *
+     * \param points The points, of dimension getDim().
+     * \param values If not null, receives the values at the points.
+     * \param grads Receives the gradients in the same layout as points.
+     */
+    void differences(const PointBatch &points, double *values, PointBatch &grads) const;
+    /**
+     * \brief Calculate the value and, if requested, the gradient at a point.
+     *
+     * \param x The point, of dimension getDim().
+     * \param grad If not null, receives the gradient.
+     * \param wantValue Whether the value is needed along with the gradient.
+     * \return The value at x, 0 if only the gradient was wanted.
+     */
+    double differentiate(const VectorX &x, VectorX *grad, bool wantValue) const;
+    /**
+     * \brief Get the step of a coordinate.
+     *
+     * \param xi The value of the coordinate.
+     * \return The step, such that xi + step is exactly representable.
+     */
+    double step(double xi) const;
+
+    Formula formula;                  ///< The formula, if evaluated a point at a time.
+    BatchFormula batchFormula;        ///< The formula, if evaluated a batch at a time.
+    ComplexFormula complexFormula;    ///< The formula, if differentiated by the complex step.
+    DifferenceScheme scheme;          ///< The difference formula.
+    double relativeStep;              ///< The step relative to max(|x_i|, 1).
+    std::shared_ptr<ThreadPool> pool; ///< Evaluates the perturbed points, may be null.
+};
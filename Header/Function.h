@@ -2,16 +2,91 @@
 
 #include <string>
 #include "VectorX.h"
+#include "VectorN.h"
+#include "Dual.h"
+#include "RunStats.h"
 #include <cmath>
 #include <stdexcept>
 #include <memory>
 
+/**
+ * \struct Evaluation
+ * \brief Result of evaluating a function at a point.
+ *
+ * Holds the function value and, when it was requested, the gradient.
+ */
+struct Evaluation
+{
+	double value; ///< The value of the function.
+	VectorX grad; ///< The gradient of the function, empty if it was not requested.
+};
+
+/**
+ * \class PointBatch
+ * \brief A batch of points stored as structure of arrays.
+ *
+ * Coordinate d of all points is stored contiguously, so a loop over the
+ * points of a batch reads and writes unit-stride arrays and can be
+ * vectorized by the compiler.
+ */
+class PointBatch
+{
+public:
+	PointBatch() : dim(0), count(0) {}
+	PointBatch(size_t dim, size_t count) : dim(dim), count(count), coords(dim * count) {}
+	/**
+	 * \brief Change the shape of the batch. Existing contents are unspecified afterwards.
+	 */
+	void resize(size_t newDim, size_t newCount)
+	{
+		dim = newDim;
+		count = newCount;
+		coords.resize(dim * count);
+	}
+	size_t getDim() const { return dim; }
+	size_t getCount() const { return count; }
+	/**
+	 * \brief Get coordinate d of all points.
+	 *
+	 * \param d The index of the coordinate.
+	 * \return A pointer to getCount() values.
+	 */
+	double *coord(size_t d) { return coords.data() + d * count; }
+	const double *coord(size_t d) const { return coords.data() + d * count; }
+	/**
+	 * \brief Copy point k out of the batch.
+	 */
+	VectorX getPoint(size_t k) const
+	{
+		VectorX x(dim);
+		for (size_t d = 0; d < dim; ++d)
+			x[d] = coords[d * count + k];
+		return x;
+	}
+	/**
+	 * \brief Store x as point k of the batch.
+	 */
+	void setPoint(size_t k, const VectorX &x)
+	{
+		for (size_t d = 0; d < dim; ++d)
+			coords[d * count + k] = x[d];
+	}
+
+private:
+	size_t dim;					///< The dimension of the points.
+	size_t count;				///< The number of points.
+	std::vector<double> coords; ///< Coordinates, grouped by coordinate index.
+};
+
 /**
  * \class Function
  * \brief Abstract base class for mathematical functions.
  *
  * This class provides an interface for mathematical functions, including
- * methods to calculate the function value and its gradient.
+ * methods to calculate the function value and its gradient. The public
+ * members count every call in threadRunStats and forward it to a protected
+ * virtual member, which derived classes implement, so every implementation
+ * is counted the same way.
  */
 class Function
 {
@@ -33,21 +108,80 @@ public:
 	/**
 	 * \brief Calculate the value of the function at a given point.
 	 *
-	 * This operator must be implemented by derived classes.
+	 * Counts one value and calls calcValue().
 	 *
 	 * \param x The point at which to evaluate the function.
 	 * \return The value of the function at point x.
 	 */
-	virtual double operator()(const VectorX &x) const = 0;
+	double operator()(const VectorX &x) const
+	{
+		double value = calcValue(x);
+		++threadRunStats.valueCalls;
+		return value;
+	}
 	/**
 	 * \brief Gradient of the function.
 	 *
-	 * This function calculates the gradient of the function at a given point.
+	 * Counts one gradient and calls calcGrad().
 	 *
 	 * \param x The point at which the gradient is calculated.
 	 * \return The gradient of the function at point x.
 	 */
-	virtual VectorX grad(const VectorX &x) const = 0;
+	VectorX grad(const VectorX &x) const
+	{
+		VectorX g = calcGrad(x);
+		++threadRunStats.gradCalls;
+		return g;
+	}
+	/**
+	 * \brief Calculate the value and, optionally, the gradient in one call.
+	 *
+	 * Counts one value and, if requested, one gradient and calls calcEvaluation().
+	 *
+	 * \param x The point at which to evaluate the function.
+	 * \param wantGrad Whether the gradient should be calculated as well.
+	 * \return The value of the function and, if requested, its gradient at point x.
+	 */
+	Evaluation evaluate(const VectorX &x, bool wantGrad) const
+	{
+		Evaluation eval = calcEvaluation(x, wantGrad);
+		++threadRunStats.valueCalls;
+		if (wantGrad)
+			++threadRunStats.gradCalls;
+		return eval;
+	}
+	/**
+	 * \brief Product of the Hessian at a point with a vector.
+	 *
+	 * Counts one product and calls calcHessVec(). Neither forms the Hessian.
+	 *
+	 * \param x The point at which the Hessian is taken.
+	 * \param v The vector to multiply, of dimension getDim().
+	 * \return The product H(x) v.
+	 */
+	VectorX hessVec(const VectorX &x, const VectorX &v) const
+	{
+		VectorX hv = calcHessVec(x, v);
+		++threadRunStats.hessVecCalls;
+		return hv;
+	}
+	/**
+	 * \brief Evaluate the function at a batch of points.
+	 *
+	 * Counts a value and, if requested, a gradient per point and calls
+	 * calcBatch(), so many points cost a single virtual call.
+	 *
+	 * \param points The points to evaluate, of dimension getDim().
+	 * \param values Receives points.getCount() function values.
+	 * \param grads If not null, receives the gradients in the same layout as points.
+	 */
+	void evaluateBatch(const PointBatch &points, double *values, PointBatch *grads = nullptr) const
+	{
+		calcBatch(points, values, grads);
+		threadRunStats.valueCalls += points.getCount();
+		if (grads)
+			threadRunStats.gradCalls += points.getCount();
+	}
 	/**
 	 * \brief Clone the function.
 	 *
@@ -58,95 +192,528 @@ public:
 	virtual std::shared_ptr<Function> clone() const = 0;
 
 protected:
+	/**
+	 * \brief Calculate the value of the function at a given point.
+	 *
+	 * This member must be implemented by derived classes.
+	 *
+	 * \param x The point at which to evaluate the function.
+	 * \return The value of the function at point x.
+	 */
+	virtual double calcValue(const VectorX &x) const = 0;
+	/**
+	 * \brief Calculate the gradient of the function at a given point.
+	 *
+	 * This member must be implemented by derived classes.
+	 *
+	 * \param x The point at which the gradient is calculated.
+	 * \return The gradient of the function at point x.
+	 */
+	virtual VectorX calcGrad(const VectorX &x) const = 0;
+	/**
+	 * \brief Calculate the value and, optionally, the gradient.
+	 *
+	 * The default implementation calls calcValue() and calcGrad(). Derived
+	 * classes override it to share subexpressions between the value and the
+	 * gradient.
+	 *
+	 * \param x The point at which to evaluate the function.
+	 * \param wantGrad Whether the gradient should be calculated as well.
+	 * \return The value of the function and, if requested, its gradient at point x.
+	 */
+	virtual Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const;
+	/**
+	 * \brief Calculate the product of the Hessian at a point with a vector.
+	 *
+	 * The default implementation differentiates the gradient along v with a
+	 * central difference; the two gradients it takes are counted as such.
+	 * Derived classes override it with the exact product.
+	 *
+	 * \param x The point at which the Hessian is taken.
+	 * \param v The vector to multiply, of dimension getDim().
+	 * \return The product H(x) v.
+	 */
+	virtual VectorX calcHessVec(const VectorX &x, const VectorX &v) const;
+	/**
+	 * \brief Calculate the values and, optionally, the gradients at a batch of points.
+	 *
+	 * The default implementation evaluates the points one by one. Derived
+	 * classes override it with a loop over the batch that the compiler can
+	 * vectorize.
+	 *
+	 * \param points The points to evaluate, of dimension getDim().
+	 * \param values Receives points.getCount() function values.
+	 * \param grads If not null, receives the gradients in the same layout as points.
+	 */
+	virtual void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const;
+
 	size_t dimension; ///< The dimension of the function.
 	std::string name; ///< The name of the function.
 };
 
-class Function1 : public Function
+/**
+ * \brief Batch evaluation through the fixed-dimension overloads of F.
+ *
+ * Shared by the overrides of Function::calcBatch in the built-in
+ * functions. Each point is loaded into a VectorN, so after inlining the loop
+ * body is straight-line arithmetic over unit-stride arrays.
+ *
+ * \tparam F A function class with a static Dim member.
+ */
+template <typename F>
+void evaluateBatchFixed(const F &f, const PointBatch &points, double *values, PointBatch *grads)
 {
+	constexpr size_t dim = F::Dim;
+	if (points.getDim() != dim)
+	{
+		throw std::invalid_argument("Points of the batch must have exactly " + std::to_string(dim) + " elements.");
+	}
+	size_t count = points.getCount();
+	const double *in[dim];
+	for (size_t d = 0; d < dim; ++d)
+		in[d] = points.coord(d);
+	if (!grads)
+	{
+		for (size_t k = 0; k < count; ++k)
+		{
+			VectorN<dim> x;
+			for (size_t d = 0; d < dim; ++d)
+				x[d] = in[d][k];
+			values[k] = f(x);
+		}
+		return;
+	}
+	grads->resize(dim, count);
+	double *out[dim];
+	for (size_t d = 0; d < dim; ++d)
+		out[d] = grads->coord(d);
+	for (size_t k = 0; k < count; ++k)
+	{
+		VectorN<dim> x, grad;
+		for (size_t d = 0; d < dim; ++d)
+			x[d] = in[d][k];
+		values[k] = f.evaluate(x, grad);
+		for (size_t d = 0; d < dim; ++d)
+			out[d][k] = grad[d];
+	}
+}
 
+class Function1 : public Function
+{
 public:
+	static constexpr size_t Dim = 2; ///< The dimension of the function.
+
 	Function1()
 	{
-		dimension = 2;
+		dimension = Dim;
 		name = "x^2*sin(y)";
 	}
 	virtual ~Function1() {};
-	virtual double operator()(const VectorX &x) const override;
-	virtual VectorX grad(const VectorX &x) const override;
 	virtual std::shared_ptr<Function> clone() const override;
+	using Function::operator();
+	using Function::grad;
+	using Function::evaluate;
+	using Function::hessVec;
+	/**
+	 * \brief Calculate the value at a fixed-dimension point.
+	 *
+	 * Unlike the VectorX overload, this one performs no size check and no
+	 * allocation, so it can be inlined into fixed-dimension optimizers.
+	 */
+	double operator()(const VectorN<Dim> &x) const;
+	/**
+	 * \brief Calculate the gradient at a fixed-dimension point.
+	 */
+	VectorN<Dim> grad(const VectorN<Dim> &x) const;
+	/**
+	 * \brief Calculate the value and the gradient at a fixed-dimension point.
+	 *
+	 * \param x The point at which to evaluate the function.
+	 * \param grad Receives the gradient at point x.
+	 * \return The value of the function at point x.
+	 */
+	double evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const;
+	/**
+	 * \brief Calculate the exact Hessian-vector product at a fixed-dimension point.
+	 *
+	 * \param x The point at which the Hessian is taken.
+	 * \param v The vector to multiply.
+	 * \return The product H(x) v.
+	 */
+	VectorN<Dim> hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const;
+	/**
+	 * \brief The formula of the function, written once for every scalar type.
+	 *
+	 * With double it gives the value. With dual numbers it gives the gradient
+	 * and the Hessian-vector products by forward-mode automatic differentiation,
+	 * so no derivative is maintained by hand.
+	 *
+	 * \tparam T double or a Dual number.
+	 * \param x The point.
+	 * \return The value of the function at x.
+	 */
+	template <typename T>
+	static T formula(const std::array<T, Dim> &x);
+
+protected:
+	virtual double calcValue(const VectorX &x) const override;
+	virtual VectorX calcGrad(const VectorX &x) const override;
+	virtual Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+	virtual VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+	virtual void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
 };
 
+template <typename T>
+DUAL_INLINE T Function1::formula(const std::array<T, Dim> &x)
+{
+	return x[0] * x[0] * sin(x[1]);
+}
+
+inline double Function1::operator()(const VectorN<Dim> &x) const
+{
+	return formula(x);
+}
+
+DUAL_INLINE VectorN<Function1::Dim> Function1::grad(const VectorN<Dim> &x) const
+{
+	VectorN<Dim> grad;
+	evaluate(x, grad);
+	return grad;
+}
+
+DUAL_INLINE double Function1::evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const
+{
+	return valueAndGradient<Dim>([](const auto &x)
+								 { return formula(x); }, x, grad);
+}
+
+DUAL_INLINE VectorN<Function1::Dim> Function1::hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const
+{
+	VectorN<Dim> hv;
+	hessianVectorProduct<Dim>([](const auto &x)
+							  { return formula(x); }, x, v, hv);
+	return hv;
+}
+
 class Function2 : public Function
 {
 public:
+	static constexpr size_t Dim = 3; ///< The dimension of the function.
+
 	Function2()
 	{
-		dimension = 3;
+		dimension = Dim;
 		name = "sin(x)cos(y)sin(z)";
 	}
 	virtual ~Function2() {};
-	virtual double operator()(const VectorX &x) const override;
-	virtual VectorX grad(const VectorX &x) const override;
 	virtual std::shared_ptr<Function> clone() const override;
+	using Function::operator();
+	using Function::grad;
+	using Function::evaluate;
+	using Function::hessVec;
+	double operator()(const VectorN<Dim> &x) const;
+	VectorN<Dim> grad(const VectorN<Dim> &x) const;
+	double evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const;
+	VectorN<Dim> hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const;
+	template <typename T>
+	static T formula(const std::array<T, Dim> &x);
+
+protected:
+	virtual double calcValue(const VectorX &x) const override;
+	virtual VectorX calcGrad(const VectorX &x) const override;
+	virtual Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+	virtual VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+	virtual void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
 };
 
-class Function3 : public Function
+template <typename T>
+DUAL_INLINE T Function2::formula(const std::array<T, Dim> &x)
+{
+	return sin(x[0]) * cos(x[1]) * sin(x[2]);
+}
+
+inline double Function2::operator()(const VectorN<Dim> &x) const
+{
+	return formula(x);
+}
+
+DUAL_INLINE VectorN<Function2::Dim> Function2::grad(const VectorN<Dim> &x) const
+{
+	VectorN<Dim> grad;
+	evaluate(x, grad);
+	return grad;
+}
+
+DUAL_INLINE double Function2::evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const
 {
+	return valueAndGradient<Dim>([](const auto &x)
+								 { return formula(x); }, x, grad);
+}
 
+DUAL_INLINE VectorN<Function2::Dim> Function2::hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const
+{
+	VectorN<Dim> hv;
+	hessianVectorProduct<Dim>([](const auto &x)
+							  { return formula(x); }, x, v, hv);
+	return hv;
+}
+
+class Function3 : public Function
+{
 public:
+	static constexpr size_t Dim = 2; ///< The dimension of the function.
+
 	Function3()
 	{
-		dimension = 2;
+		dimension = Dim;
 		name = "(0.1x - y)^4 + y^2";
 	}
 	virtual ~Function3() {};
-	virtual double operator()(const VectorX &x) const override;
-	virtual VectorX grad(const VectorX &x) const override;
 	virtual std::shared_ptr<Function> clone() const override;
+	using Function::operator();
+	using Function::grad;
+	using Function::evaluate;
+	using Function::hessVec;
+	double operator()(const VectorN<Dim> &x) const;
+	VectorN<Dim> grad(const VectorN<Dim> &x) const;
+	double evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const;
+	VectorN<Dim> hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const;
+	template <typename T>
+	static T formula(const std::array<T, Dim> &x);
+
+protected:
+	virtual double calcValue(const VectorX &x) const override;
+	virtual VectorX calcGrad(const VectorX &x) const override;
+	virtual Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+	virtual VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+	virtual void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
 };
 
-class Function4 : public Function
+template <typename T>
+DUAL_INLINE T Function3::formula(const std::array<T, Dim> &x)
+{
+	T d = 0.1 * x[0] - x[1];
+	T d2 = d * d;
+	return d2 * d2 + x[1] * x[1];
+}
+
+inline double Function3::operator()(const VectorN<Dim> &x) const
+{
+	return formula(x);
+}
+
+DUAL_INLINE VectorN<Function3::Dim> Function3::grad(const VectorN<Dim> &x) const
 {
+	VectorN<Dim> grad;
+	evaluate(x, grad);
+	return grad;
+}
 
+DUAL_INLINE double Function3::evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const
+{
+	return valueAndGradient<Dim>([](const auto &x)
+								 { return formula(x); }, x, grad);
+}
+
+DUAL_INLINE VectorN<Function3::Dim> Function3::hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const
+{
+	VectorN<Dim> hv;
+	hessianVectorProduct<Dim>([](const auto &x)
+							  { return formula(x); }, x, v, hv);
+	return hv;
+}
+
+class Function4 : public Function
+{
 public:
+	static constexpr size_t Dim = 2; ///< The dimension of the function.
+
 	Function4()
 	{
-		dimension = 2;
+		dimension = Dim;
 		name = "(1 - x)^2 + 100(y - x^2)^2";
 	}
 	virtual ~Function4() {};
-	virtual double operator()(const VectorX &x) const override;
-	virtual VectorX grad(const VectorX &x) const override;
 	virtual std::shared_ptr<Function> clone() const override;
+	using Function::operator();
+	using Function::grad;
+	using Function::evaluate;
+	using Function::hessVec;
+	double operator()(const VectorN<Dim> &x) const;
+	VectorN<Dim> grad(const VectorN<Dim> &x) const;
+	double evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const;
+	VectorN<Dim> hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const;
+	template <typename T>
+	static T formula(const std::array<T, Dim> &x);
+
+protected:
+	virtual double calcValue(const VectorX &x) const override;
+	virtual VectorX calcGrad(const VectorX &x) const override;
+	virtual Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+	virtual VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+	virtual void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
 };
 
-class Function5 : public Function
+template <typename T>
+DUAL_INLINE T Function4::formula(const std::array<T, Dim> &x)
+{
+	T a = 1 - x[0];
+	T b = x[1] - x[0] * x[0];
+	return a * a + 100 * b * b;
+}
+
+inline double Function4::operator()(const VectorN<Dim> &x) const
 {
+	return formula(x);
+}
 
+DUAL_INLINE VectorN<Function4::Dim> Function4::grad(const VectorN<Dim> &x) const
+{
+	VectorN<Dim> grad;
+	evaluate(x, grad);
+	return grad;
+}
+
+DUAL_INLINE double Function4::evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const
+{
+	return valueAndGradient<Dim>([](const auto &x)
+								 { return formula(x); }, x, grad);
+}
+
+DUAL_INLINE VectorN<Function4::Dim> Function4::hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const
+{
+	VectorN<Dim> hv;
+	hessianVectorProduct<Dim>([](const auto &x)
+							  { return formula(x); }, x, v, hv);
+	return hv;
+}
+
+class Function5 : public Function
+{
 public:
+	static constexpr size_t Dim = 4; ///< The dimension of the function.
+
 	Function5()
 	{
-		dimension = 4;
+		dimension = Dim;
 		name = "100(x^2 - y)^2 + (x - 1)^2 + 100(z^2 - w)^2 + (z - 1)^2";
 	}
 	virtual ~Function5() {};
-	virtual double operator()(const VectorX &x) const override;
-	virtual VectorX grad(const VectorX &x) const override;
 	virtual std::shared_ptr<Function> clone() const override;
+	using Function::operator();
+	using Function::grad;
+	using Function::evaluate;
+	using Function::hessVec;
+	double operator()(const VectorN<Dim> &x) const;
+	VectorN<Dim> grad(const VectorN<Dim> &x) const;
+	double evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const;
+	VectorN<Dim> hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const;
+	template <typename T>
+	static T formula(const std::array<T, Dim> &x);
+
+protected:
+	virtual double calcValue(const VectorX &x) const override;
+	virtual VectorX calcGrad(const VectorX &x) const override;
+	virtual Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+	virtual VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+	virtual void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
 };
 
-class Function6 : public Function
+template <typename T>
+DUAL_INLINE T Function5::formula(const std::array<T, Dim> &x)
 {
+	T b1 = x[0] * x[0] - x[1];
+	T a1 = x[0] - 1;
+	T b2 = x[2] * x[2] - x[3];
+	T a2 = x[2] - 1;
+	return 100 * b1 * b1 + a1 * a1 + 100 * b2 * b2 + a2 * a2;
+}
 
+inline double Function5::operator()(const VectorN<Dim> &x) const
+{
+	return formula(x);
+}
+
+DUAL_INLINE VectorN<Function5::Dim> Function5::grad(const VectorN<Dim> &x) const
+{
+	VectorN<Dim> grad;
+	evaluate(x, grad);
+	return grad;
+}
+
+DUAL_INLINE double Function5::evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const
+{
+	return valueAndGradient<Dim>([](const auto &x)
+								 { return formula(x); }, x, grad);
+}
+
+DUAL_INLINE VectorN<Function5::Dim> Function5::hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const
+{
+	VectorN<Dim> hv;
+	hessianVectorProduct<Dim>([](const auto &x)
+							  { return formula(x); }, x, v, hv);
+	return hv;
+}
+
+class Function6 : public Function
+{
 public:
+	static constexpr size_t Dim = 2; ///< The dimension of the function.
+
 	Function6()
 	{
-		dimension = 2;
+		dimension = Dim;
 		name = "x^2 + y^2";
 	}
 	virtual ~Function6() {};
-	virtual double operator()(const VectorX &x) const override;
-	virtual VectorX grad(const VectorX &x) const override;
 	virtual std::shared_ptr<Function> clone() const override;
+	using Function::operator();
+	using Function::grad;
+	using Function::evaluate;
+	using Function::hessVec;
+	double operator()(const VectorN<Dim> &x) const;
+	VectorN<Dim> grad(const VectorN<Dim> &x) const;
+	double evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const;
+	VectorN<Dim> hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const;
+	template <typename T>
+	static T formula(const std::array<T, Dim> &x);
+
+protected:
+	virtual double calcValue(const VectorX &x) const override;
+	virtual VectorX calcGrad(const VectorX &x) const override;
+	virtual Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+	virtual VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+	virtual void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
 };
+
+template <typename T>
+DUAL_INLINE T Function6::formula(const std::array<T, Dim> &x)
+{
+	return x[0] * x[0] + x[1] * x[1];
+}
+
+inline double Function6::operator()(const VectorN<Dim> &x) const
+{
+	return formula(x);
+}
+
+DUAL_INLINE VectorN<Function6::Dim> Function6::grad(const VectorN<Dim> &x) const
+{
+	VectorN<Dim> grad;
+	evaluate(x, grad);
+	return grad;
+}
+
+DUAL_INLINE double Function6::evaluate(const VectorN<Dim> &x, VectorN<Dim> &grad) const
+{
+	return valueAndGradient<Dim>([](const auto &x)
+								 { return formula(x); }, x, grad);
+}
+
+DUAL_INLINE VectorN<Function6::Dim> Function6::hessVec(const VectorN<Dim> &x, const VectorN<Dim> &v) const
+{
+	VectorN<Dim> hv;
+	hessianVectorProduct<Dim>([](const auto &x)
+							  { return formula(x); }, x, v, hv);
+	return hv;
+}
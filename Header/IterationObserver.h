@@ -0,0 +1,205 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+/**
+ * \brief The parts of an iteration whose time is measured separately.
+ */
+enum class IterationPhase
+{
+    Evaluation, ///< Function and gradient evaluations of the method.
+    LineSearch, ///< Choosing the step length.
+    Criteria,   ///< Checking the stopping criteria.
+    Other,      ///< Everything else, such as the update of the point.
+};
+
+constexpr size_t iterationPhasesNum = 4; ///< The number of values of IterationPhase.
+
+/**
+ * \struct IterationInfo
+ * \brief What an optimization method reports about one iteration.
+ *
+ * The criteria check counted in an iteration is the one that allowed it to
+ * start, so the final check that stops the run is not reported.
+ */
+struct IterationInfo
+{
+    size_t iterNum;                                       ///< The number of the iteration, starting at 1.
+    double value;                                         ///< The function value at the point the iteration started from.
+    double stepNorm;                                      ///< The distance to the point the iteration moved to.
+    uint64_t elapsedNs = 0;                               ///< The wall time of the iteration.
+    std::array<uint64_t, iterationPhasesNum> phaseNs{};   ///< The wall time of each IterationPhase.
+};
+
+/**
+ * \class IterationObserver
+ * \brief Receives an IterationInfo after every iteration of an optimization method.
+ *
+ * An observer attached to a method is called from the thread that runs
+ * optimise(). Methods cloned for parallel runs, as by MultiStart and Sweep,
+ * share the observer and call it concurrently, so implementations must
+ * synchronize onIteration(); SampledTracer and PhaseHistogram do.
+ */
+class IterationObserver
+{
+public:
+    virtual ~IterationObserver();
+    /**
+     * \brief Called once per iteration.
+     *
+     * \param info The iteration that has just finished.
+     */
+    virtual void onIteration(const IterationInfo &info) = 0;
+};
+
+/**
+ * \class IterationTimer
+ * \brief Measures the phases of the iterations of an optimise loop.
+ *
+ * The loops are instantiated with Enabled set to whether an observer is
+ * attached. The disabled specialization has only empty inline members, so
+ * an unobserved loop contains no timing code at all.
+ *
+ * \tparam Enabled Whether the iterations are measured and reported.
+ */
+template <bool Enabled>
+class IterationTimer
+{
+public:
+    /**
+     * \brief Start timing the first iteration.
+     *
+     * \param observer The observer to report to, not null.
+     */
+    explicit IterationTimer(IterationObserver *observer)
+        : observer(observer), phaseNs{}
+    {
+        last = iterStart = std::chrono::steady_clock::now();
+    }
+    /**
+     * \brief Attribute the time since the previous mark to a phase.
+     *
+     * \param phase The phase that has just ended.
+     */
+    void mark(IterationPhase phase)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        phaseNs[static_cast<size_t>(phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+        last = now;
+    }
+    /**
+     * \brief Finish the iteration and report it.
+     *
+     * The time since the last mark is attributed to IterationPhase::Other.
+     *
+     * \param describe Called only when enabled; returns the info with the
+     * iteration number, value and step norm filled in.
+     */
+    template <typename Describe>
+    void finish(Describe &&describe)
+    {
+        mark(IterationPhase::Other);
+        IterationInfo info = describe();
+        info.elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(last - iterStart).count();
+        info.phaseNs = phaseNs;
+        observer->onIteration(info);
+        phaseNs = {};
+        last = iterStart = std::chrono::steady_clock::now();
+    }
+
+private:
+    IterationObserver *observer;                        ///< The observer to report to.
+    std::chrono::steady_clock::time_point iterStart;    ///< The start of the current iteration.
+    std::chrono::steady_clock::time_point last;         ///< The time of the last mark.
+    std::array<uint64_t, iterationPhasesNum> phaseNs;   ///< The phase times of the current iteration.
+};
+
+template <>
+class IterationTimer<false>
+{
+public:
+    explicit IterationTimer(IterationObserver *) {}
+    void mark(IterationPhase) {}
+    template <typename Describe>
+    void finish(Describe &&) {}
+};
+
+/**
+ * \class SampledTracer
+ * \brief Writes every Nth iteration as a CSV row.
+ *
+ * Rows of runs that share the tracer are interleaved, each written whole.
+ */
+class SampledTracer : public IterationObserver
+{
+public:
+    /**
+     * \brief Constructor for SampledTracer.
+     *
+     * \param os The stream to write to; the header row is written immediately.
+     * \param every Write iterations whose number is a multiple of this, and the first one.
+     * \throw std::invalid_argument If every is 0.
+     */
+    SampledTracer(std::ostream &os, size_t every);
+    ~SampledTracer();
+    void onIteration(const IterationInfo &info) override;
+
+private:
+    std::ostream &os; ///< The output stream.
+    size_t every;     ///< The sampling period.
+    std::mutex mutex; ///< Keeps the rows of concurrent runs whole.
+};
+
+/**
+ * \class PhaseHistogram
+ * \brief Histogram of the time spent per iteration in each phase.
+ *
+ * Bucket k counts iterations whose phase took [2^k, 2^(k+1)) nanoseconds;
+ * bucket 0 also counts iterations that spent no time in the phase.
+ */
+class PhaseHistogram : public IterationObserver
+{
+public:
+    static constexpr size_t bucketsNum = 64; ///< Buckets per phase, enough for any 64-bit duration.
+
+    PhaseHistogram();
+    ~PhaseHistogram();
+    void onIteration(const IterationInfo &info) override;
+    /**
+     * \brief Get the number of iterations in a bucket.
+     *
+     * \param phase The phase.
+     * \param bucket The bucket index, below bucketsNum.
+     * \return The number of iterations.
+     */
+    size_t getCount(IterationPhase phase, size_t bucket) const;
+    /**
+     * \brief Get the total time spent in a phase.
+     *
+     * \param phase The phase.
+     * \return The total time in nanoseconds.
+     */
+    uint64_t getTotalNs(IterationPhase phase) const;
+    /**
+     * \brief Get the number of iterations observed.
+     *
+     * \return The number of iterations.
+     */
+    size_t getIterNum() const;
+    /**
+     * \brief Print the total and mean time and the non-empty buckets of every phase.
+     *
+     * \param os The stream to print to.
+     */
+    void print(std::ostream &os) const;
+
+private:
+    std::array<std::array<size_t, bucketsNum>, iterationPhasesNum> counts; ///< The buckets of every phase.
+    std::array<uint64_t, iterationPhasesNum> totalNs;                      ///< The total time of every phase.
+    size_t iterNum;                                                        ///< The number of iterations observed.
+    mutable std::mutex mutex;                                              ///< Guards the counts of concurrent runs.
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include "Function.h"
+#include <memory>
+#include <string>
+
+/**
+ * \struct LineSearchResult
+ * \brief The step length chosen by a line search and what it cost.
+ */
+struct LineSearchResult
+{
+    double alpha;          ///< The chosen step length.
+    size_t evaluations;    ///< The number of function evaluations spent.
+    Evaluation evaluation; ///< The evaluation at the chosen point if it was made, with an empty gradient if it was not calculated.
+};
+
+/**
+ * \class LineSearch
+ * \brief Abstract base class for choosing the step length of gradient descent.
+ *
+ * A line search minimizes phi(alpha) = f(point - alpha * grad) over
+ * [0, maxAlpha]. Implementations keep no state between calls, so one object
+ * can be shared by methods running on different threads.
+ */
+class LineSearch
+{
+public:
+    LineSearch();
+    virtual ~LineSearch();
+    /**
+     * \brief Choose the step length.
+     *
+     * \param f The function.
+     * \param point The current point.
+     * \param value The function value at the current point.
+     * \param grad The gradient at the current point.
+     * \param maxAlpha The largest step that stays in the area.
+     * \param prevAlpha The step length chosen in the previous iteration, 0 if there is none.
+     * \return The step length and the number of evaluations spent.
+     */
+    virtual LineSearchResult search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                                    double maxAlpha, double prevAlpha) const = 0;
+    /**
+     * \brief Get the name of the line search.
+     *
+     * \return The name of the line search.
+     */
+    virtual std::string getName() const = 0;
+};
+
+/**
+ * \class TernaryLineSearch
+ * \brief Ternary search on [0, maxAlpha].
+ *
+ * Each iteration shrinks the interval by a third at the cost of two new
+ * evaluations. Probes are not reused.
+ */
+class TernaryLineSearch : public LineSearch
+{
+public:
+    /**
+     * \brief Constructor for TernaryLineSearch.
+     *
+     * \param eps The interval length at which the search stops.
+     * \param maxIter The maximum number of iterations.
+     */
+    TernaryLineSearch(double eps = 1e-15, size_t maxIter = 100);
+    ~TernaryLineSearch();
+    LineSearchResult search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                            double maxAlpha, double prevAlpha) const override;
+    std::string getName() const override;
+
+private:
+    double eps;     ///< The interval length at which the search stops.
+    size_t maxIter; ///< The maximum number of iterations.
+};
+
+/**
+ * \class GoldenSectionLineSearch
+ * \brief Golden-section search on [0, maxAlpha].
+ *
+ * The inner probes divide the interval in the golden ratio, so one of them is
+ * reused after every shrink and each iteration costs a single evaluation.
+ * A step of zero is returned when no probe improves on the current value.
+ */
+class GoldenSectionLineSearch : public LineSearch
+{
+public:
+    /**
+     * \brief Constructor for GoldenSectionLineSearch.
+     *
+     * \param tolerance The interval length, relative to maxAlpha, at which the search stops.
+     * \param maxIter The maximum number of evaluations.
+     */
+    GoldenSectionLineSearch(double tolerance = 1.5e-8, size_t maxIter = 100);
+    ~GoldenSectionLineSearch();
+    LineSearchResult search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                            double maxAlpha, double prevAlpha) const override;
+    std::string getName() const override;
+
+private:
+    double tolerance; ///< The relative interval length at which the search stops.
+    size_t maxIter;   ///< The maximum number of evaluations.
+};
+
+/**
+ * \class BrentLineSearch
+ * \brief Brent's method on [0, maxAlpha].
+ *
+ * Fits a parabola through the three best points and falls back to a golden
+ * section step when the parabolic step is unreliable. On smooth functions it
+ * converges superlinearly with one evaluation per iteration. A step of zero
+ * is returned when no probe improves on the current value.
+ */
+class BrentLineSearch : public LineSearch
+{
+public:
+    /**
+     * \brief Constructor for BrentLineSearch.
+     *
+     * \param tolerance The fractional precision of the step length.
+     * \param maxIter The maximum number of evaluations.
+     */
+    BrentLineSearch(double tolerance = 1.5e-8, size_t maxIter = 100);
+    ~BrentLineSearch();
+    LineSearchResult search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                            double maxAlpha, double prevAlpha) const override;
+    std::string getName() const override;
+
+private:
+    double tolerance; ///< The fractional precision of the step length.
+    size_t maxIter;   ///< The maximum number of evaluations.
+};
+
+/**
+ * \class StrongWolfeLineSearch
+ * \brief Inexact line search satisfying the strong Wolfe conditions.
+ *
+ * Every trial point is evaluated together with its gradient through
+ * Function::evaluate. The search expands the step from the previous step
+ * length until the minimum is bracketed and then zooms in with safeguarded
+ * cubic interpolation. The last evaluation is returned so that the method can
+ * reuse it for the next iteration.
+ */
+class StrongWolfeLineSearch : public LineSearch
+{
+public:
+    /**
+     * \brief Constructor for StrongWolfeLineSearch.
+     *
+     * \param c1 The sufficient decrease constant.
+     * \param c2 The curvature constant, c1 < c2 < 1.
+     * \param maxIter The maximum number of evaluations.
+     * \throw std::invalid_argument If the constants do not satisfy 0 < c1 < c2 < 1.
+     */
+    StrongWolfeLineSearch(double c1 = 1e-4, double c2 = 0.9, size_t maxIter = 30);
+    ~StrongWolfeLineSearch();
+    LineSearchResult search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                            double maxAlpha, double prevAlpha) const override;
+    std::string getName() const override;
+
+private:
+    double c1;      ///< The sufficient decrease constant.
+    double c2;      ///< The curvature constant.
+    size_t maxIter; ///< The maximum number of evaluations.
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "OptimizationMethod.h"
+#include "ThreadPool.h"
+#include <limits>
+
+/**
+ * \struct StartResult
+ * \brief Outcome of one optimization run of a multi-start search.
+ */
+struct StartResult
+{
+    VectorX startPoint; ///< The point the run started from.
+    VectorX bestPoint;  ///< The best point found by the run.
+    double value;       ///< The function value at the best point.
+    size_t iterNum;     ///< The number of iterations made.
+    bool completed;     ///< False if the run was skipped because the target was reached before it started.
+};
+
+/**
+ * \struct MultiStartResult
+ * \brief Outcome of a multi-start search.
+ */
+struct MultiStartResult
+{
+    std::vector<StartResult> starts; ///< Results in the order of the start points.
+    size_t bestIndex;                ///< Index of the completed run with the lowest value.
+};
+
+/**
+ * \class MultiStart
+ * \brief Runs an optimization method from many start points concurrently.
+ *
+ * Every run works on its own clone of the method and its own copy of the
+ * area, so the runs share only the function and the stopping criteria, which
+ * are used through const references. The function must therefore be safe to
+ * evaluate from several threads, as the built-in functions are.
+ */
+class MultiStart
+{
+public:
+    /**
+     * \brief Constructor for MultiStart.
+     *
+     * \param threads The number of worker threads; 0 selects the number of hardware threads.
+     */
+    explicit MultiStart(size_t threads = 0);
+    ~MultiStart();
+    /**
+     * \brief Stop the search once a run reaches this value.
+     *
+     * Runs in progress are cancelled at their next check of the stopping
+     * criteria and report the best point they found so far; runs not yet
+     * started are skipped and reported as not completed.
+     *
+     * \param target The function value that is good enough.
+     */
+    void setTarget(double target);
+    /**
+     * \brief Run the method from each of the given start points.
+     *
+     * \param method The prototype of the optimization method.
+     * \param startPoints The start points.
+     * \param area The area within which to optimize the function.
+     * \param f The function to be optimized.
+     * \param criteria The stopping criteria for every run.
+     * \return The result of every run and the index of the best one.
+     */
+    MultiStartResult run(const OptimizationMethod &method, const std::vector<VectorX> &startPoints, const Area &area, const Function &f, const StopCriteria &criteria);
+    /**
+     * \brief Run the method from start points drawn from the area.
+     *
+     * \param method The prototype of the optimization method.
+     * \param startsNum The number of start points.
+     * \param seed The seed used to draw the start points.
+     * \param area The area within which to optimize the function.
+     * \param f The function to be optimized.
+     * \param criteria The stopping criteria for every run.
+     * \param sampling How the start points are drawn; a low-discrepancy sequence spreads them more evenly.
+     * \return The result of every run and the index of the best one.
+     */
+    MultiStartResult run(const OptimizationMethod &method, size_t startsNum, unsigned int seed, const Area &area, const Function &f, const StopCriteria &criteria,
+                         Sampling sampling = Sampling::Random);
+
+private:
+    ThreadPool pool; ///< The worker threads.
+    double target;   ///< The search stops once this value is reached.
+};
@@ -1,8 +1,12 @@
 #pragma once
 #include "Function.h"
 #include "Area.h"
+#include "QuasiRandom.h"
 #include "StopCriteria.h"
-#include <random>
+#include "IterationObserver.h"
+#include "LineSearch.h"
+#include <algorithm>
+#include <atomic>
 
 /**
  * \class OptimizationMethod
@@ -18,6 +22,10 @@ public:
 	virtual ~OptimizationMethod();
 	/**
 	 * \brief Optimizes the given function within the specified area.
+	 *
+	 * Every call starts a new trajectory, so a method object can be reused.
+	 *
+	 * \param startPoint The point to start from.
 	 * \param area The area within which to optimize the function.
 	 * \param f The function to be optimized.
 	 * \param criteria The stopping criteria for the optimization.
@@ -28,6 +36,15 @@ public:
 	 * \return A string representing the name of the optimization method.
 	 */
 	virtual std::string getName() = 0;
+	/**
+	 * \brief Clone the optimization method.
+	 *
+	 * The copy has the same parameters and can run on another thread
+	 * independently of the original.
+	 *
+	 * \return A shared pointer to a new instance of the method.
+	 */
+	virtual std::shared_ptr<OptimizationMethod> clone() const = 0;
 	/**
 	 * \brief Retrieves the best point found during optimization.
 	 *
@@ -40,10 +57,57 @@ public:
 	 * \return The number of iterations made as a size_t.
 	 */
 	size_t getIterNum();
+	/**
+	 * \brief Retrieves the counters of the last optimization.
+	 *
+	 * Includes the evaluations made by the stopping criteria and, for parallel
+	 * methods, by all worker threads.
+	 *
+	 * \return The counters of the last run.
+	 */
+	RunStats getRunStats() const;
+	/**
+	 * \brief Attach an observer that is called after every iteration.
+	 *
+	 * Only the address is stored, so the observer must outlive the runs it
+	 * observes. Without an observer the loops contain no timing code.
+	 *
+	 * \param observer The observer, or nullptr to detach it.
+	 */
+	void setObserver(IterationObserver *observer);
+	/**
+	 * \brief Share a flag that stops the optimization when it is set.
+	 *
+	 * The flag is read before every check of the stopping criteria, so a run
+	 * in progress ends within one iteration of it being set, with the best
+	 * point found so far. Only the address is stored, so the flag must
+	 * outlive the runs it cancels.
+	 *
+	 * \param cancel The flag, or nullptr to detach it.
+	 */
+	void setCancelFlag(const std::atomic<bool> *cancel);
 
 protected:
+	/**
+	 * \brief Check the stopping criteria, attributing their evaluations to them.
+	 *
+	 * \param criteria The stopping criteria.
+	 * \param data The data of the current iteration.
+	 * \return True if the optimization should stop or has been cancelled.
+	 */
+	bool checkCriteria(const StopCriteria &criteria, TransferData &data);
+	/**
+	 * \brief Check whether the run has been cancelled through the shared flag.
+	 *
+	 * \return True if the flag is set.
+	 */
+	bool isCancelled() const;
+
 	std::vector<VectorX> points; ///< Stores the points explored during optimization.
 	size_t iterMade;			 ///< The number of iterations completed.
+	RunStats stats;				 ///< The counters of the last optimization.
+	IterationObserver *observer; ///< The observer of the iterations, may be null.
+	const std::atomic<bool> *cancel; ///< The flag that cancels the run, may be null.
 };
 
 /**
@@ -69,8 +133,15 @@ public:
 	~AdamGradientDescent();
 	virtual void optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria) override;
 	virtual std::string getName() override;
+	virtual std::shared_ptr<OptimizationMethod> clone() const override;
 
 private:
+	/**
+	 * \brief The optimization loop, instantiated with and without an observer.
+	 */
+	template <bool Observed>
+	void optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria);
+
 	double alpha;	///< The learning rate.
 	double beta1;	///< The decay rate for the first moment.
 	double beta2;	///< The decay rate for the second moment.
@@ -94,17 +165,60 @@ public:
 	 * \param alpha The scaling factor for search steps.
 	 * \param p The probability of selecting the entire area to generate a random point.
 	 * \param delta Radius of the neighborhood.
+	 * \param threads The number of worker threads; 1 runs the serial search.
+	 * \param seed The seed of the random number generators.
+	 * \param batchSize The number of candidates each worker draws per iteration in parallel mode.
 	 */
-	RandomSearch(double alpha, double p, double delta);
+	RandomSearch(double alpha, double p, double delta, size_t threads = 1, unsigned int seed = 228, size_t batchSize = 256);
 	~RandomSearch();
 	virtual void optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria) override;
+	/**
+	 * \brief Choose how the candidate points are drawn.
+	 *
+	 * With a low-discrepancy sequence, every run starts the sequence afresh.
+	 * Both the serial and the parallel search map the points of one sequence
+	 * onto the area and those of a second one, scrambled with another seed,
+	 * onto the neighborhood, so each box is covered evenly; the choice
+	 * between the two is still random.
+	 *
+	 * \param sampling The sampling method; Random by default.
+	 */
+	void setSampling(Sampling sampling);
 	virtual std::string getName() override;
+	virtual std::shared_ptr<OptimizationMethod> clone() const override;
 
 private:
+	/**
+	 * \brief The optimization loop, instantiated with and without an observer.
+	 */
+	template <bool Observed>
+	void optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria);
+	/**
+	 * \brief Parallel search used when more than one thread is requested.
+	 *
+	 * Every iteration each worker draws batchSize candidates from its own
+	 * Philox stream, keyed by the seed and numbered by the worker index, and
+	 * evaluates them in one batch. With a low-discrepancy sequence, the area
+	 * and the neighborhood draw from sequences of their own, as in the serial
+	 * search. Each worker owns every threads-th block of batchSize points of
+	 * both and draws from them in order, skipping the blocks of the others. The workers publish their
+	 * best value with a compare-and-swap on a shared minimum; the point is
+	 * then taken from the lowest-indexed worker holding that value. The
+	 * result therefore depends only on the seed and the number of threads.
+	 * As in the serial search, only a point drawn from the neighborhood
+	 * shrinks the neighborhood and moves it to that point.
+	 */
+	template <bool Observed>
+	void optimiseParallel(Area &area, const Function &f, const StopCriteria &criteria);
+
 	double alpha;	  ///< The scaling factor for search steps.
 	double p;		  ///< The probability of selecting the entire area to generate a random point.
 	double delta;	  ///< Radius of the neighborhood.
-	std::mt19937 gen; ///< Random number generator.
+	size_t threads;	  ///< The number of worker threads.
+	unsigned int seed; ///< The seed of the random number generators.
+	size_t batchSize; ///< Candidates per worker and iteration in parallel mode.
+	Sampling sampling; ///< How the candidate points are drawn.
+	Xoshiro256 gen;	  ///< Random number generator of the serial search.
 };
 
 /**
@@ -119,34 +233,382 @@ public:
 	/**
 	 * \brief Constructor for ClassicGradientDescent.
 	 *
-	 * Initializes the classic gradient descent optimizer with a starting point.
-	 *
+	 * \param lineSearch The line search choosing the step length in every iteration.
+	 * \throw std::invalid_argument If the line search is null.
 	 */
-	ClassicGradientDescent();
+	ClassicGradientDescent(std::shared_ptr<LineSearch> lineSearch = std::make_shared<TernaryLineSearch>());
 	~ClassicGradientDescent();
 	virtual void optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria) override;
 	virtual std::string getName() override;
+	virtual std::shared_ptr<OptimizationMethod> clone() const override;
+	/**
+	 * \brief Replace the line search used by the following runs.
+	 *
+	 * The evaluations it spends are reported in RunStats::lineSearchValueCalls
+	 * and RunStats::lineSearchGradCalls.
+	 *
+	 * \param lineSearch The line search.
+	 * \throw std::invalid_argument If the line search is null.
+	 */
+	void setLineSearch(std::shared_ptr<LineSearch> lineSearch);
+	/**
+	 * \brief Get the line search.
+	 *
+	 * \return The line search.
+	 */
+	std::shared_ptr<LineSearch> getLineSearch() const;
 
 private:
 	/**
-	 * \brief Calculates the optimal alpha for the function at the given point.
-	 *
-	 * \param func The function for which to calculate the optimal alpha.
-	 * \param point The current point at which the alpha is calculated.
-	 * \param maxAlpha The maximum alpha allowed.
-	 * \return The optimal alpha.
+	 * \brief The optimization loop, instantiated with and without an observer.
 	 */
-	double alphaOptimization(const Function &func, const VectorX &point, const double maxAlpha);
+	template <bool Observed>
+	void optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria);
 	/**
 	 * \brief Gets the maximum alpha allowed based on the area and function.
 	 *
 	 * \param area The area within which to optimize.
-	 * \param func The function being optimized.
 	 * \param point The current point at which the maximum alpha is calculated.
+	 * \param grad The gradient of the function at the current point.
 	 * \return The maximum alpha allowed.
 	 */
-	double getMaxAlpha(Area &area, const Function &func, const VectorX &point);
+	double getMaxAlpha(Area &area, const VectorX &point, const VectorX &grad);
 
 private:
-	double alpha; ///< The step size for the gradient descent
-};
\ No newline at end of file
+	std::shared_ptr<LineSearch> lineSearch; ///< Chooses the step length.
+	double alpha;							///< The step size for the gradient descent
+};
+
+/**
+ * \class LBFGSB
+ * \brief Limited-memory BFGS with box constraints (L-BFGS-B).
+ *
+ * The bounds of the area are handled natively. Every iteration finds the
+ * generalized Cauchy point along the projected steepest descent path of the
+ * quasi-Newton model, minimizes the model over the variables left free by it
+ * and backtracks along the resulting feasible direction until the Armijo
+ * condition holds. The model keeps the last memory correction pairs in a
+ * contiguous ring buffer allocated once per run and uses the compact
+ * representation B = theta * I - W * M * W^T of Byrd, Lu, Nocedal and Zhu.
+ */
+class LBFGSB : public OptimizationMethod
+{
+public:
+	/**
+	 * \brief Constructor for LBFGSB.
+	 *
+	 * \param memory The number of correction pairs kept.
+	 * \param c1 The sufficient decrease constant of the backtracking.
+	 * \param maxBacktracks The maximum number of step halvings per iteration.
+	 * \throw std::invalid_argument If memory is zero or c1 is not in (0, 1).
+	 */
+	LBFGSB(size_t memory = 5, double c1 = 1e-4, size_t maxBacktracks = 30);
+	~LBFGSB();
+	virtual void optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria) override;
+	virtual std::string getName() override;
+	virtual std::shared_ptr<OptimizationMethod> clone() const override;
+
+private:
+	/**
+	 * \brief The optimization loop, instantiated with and without an observer.
+	 */
+	template <bool Observed>
+	void optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria);
+	/**
+	 * \brief Compute the next iterate of the model: the Cauchy point refined by subspace minimization.
+	 *
+	 * \param x The current point.
+	 * \param g The gradient at the current point.
+	 * \param bounds The bounds of the area.
+	 * \param xBar Receives the minimizer of the model inside the box.
+	 */
+	void modelStep(const VectorX &x, const VectorX &g, const std::vector<std::pair<double, double>> &bounds, VectorX &xBar);
+	/**
+	 * \brief Store a correction pair, overwriting the oldest one when the buffer is full.
+	 *
+	 * \param s The step.
+	 * \param y The change of the gradient.
+	 * \return False if the middle matrix became singular and the memory was cleared.
+	 */
+	bool storePair(const VectorX &s, const VectorX &y);
+	/**
+	 * \brief Forget all correction pairs, so the model becomes the identity.
+	 */
+	void resetMemory();
+	/**
+	 * \brief Rebuild the inverse middle matrix M from the stored products.
+	 *
+	 * \return False if the matrix is singular.
+	 */
+	bool buildMiddle();
+	/**
+	 * \brief The slot of the buffer holding the pair of the given age.
+	 *
+	 * \param j The index of the pair, 0 for the oldest.
+	 * \return The slot in the ring buffer.
+	 */
+	size_t slot(size_t j) const;
+	/**
+	 * \brief Write W^T v into out, where W = [Y, theta * S].
+	 */
+	void multiplyWt(const double *v, double *out) const;
+	/**
+	 * \brief Write row i of W into out.
+	 */
+	void rowOfW(size_t i, double *out) const;
+	/**
+	 * \brief Write M v into out.
+	 */
+	void multiplyM(const double *v, double *out) const;
+
+	/**
+	 * \struct Workspace
+	 * \brief Scratch arrays of modelStep() and buildMiddle().
+	 *
+	 * Kept between iterations, so once they have grown to the dimension and
+	 * the number of pairs of a run, the iterations allocate nothing.
+	 */
+	struct Workspace
+	{
+		std::vector<double> breakpoint;	  ///< Where each coordinate leaves the projected gradient path.
+		std::vector<double> d;			  ///< The direction of the current segment of the path.
+		std::vector<size_t> order;		  ///< The coordinates by increasing breakpoint.
+		std::vector<size_t> freeVars;	  ///< The coordinates strictly inside the box at the Cauchy point.
+		std::vector<double> r, du;		  ///< The reduced gradient and step of the free coordinates.
+		std::vector<double> p, c, mp, mc; ///< Products with W and M along the path, 2 * count values.
+		std::vector<double> w, mw, wtzr, v; ///< Rows of W and products of the subspace minimization, 2 * count values.
+		std::vector<double> a, n, inverse; ///< Square matrices of side 2 * count.
+	};
+
+	size_t memory;			  ///< The number of correction pairs kept.
+	double c1;				  ///< The sufficient decrease constant.
+	size_t maxBacktracks;	  ///< The maximum number of step halvings per iteration.
+	size_t dim;				  ///< The dimension of the current run.
+	std::vector<double> sRing; ///< Steps, memory rows of dim values.
+	std::vector<double> yRing; ///< Gradient changes, memory rows of dim values.
+	std::vector<double> ss;	  ///< s_i^T s_j for every pair of slots, memory x memory.
+	std::vector<double> sy;	  ///< s_i^T y_j for every pair of slots, memory x memory.
+	std::vector<double> middle; ///< The inverse middle matrix M, 2 * count square.
+	size_t head;			  ///< The slot the next pair is written to.
+	size_t count;			  ///< The number of stored pairs.
+	double theta;			  ///< The scaling of the identity in the model.
+	Workspace work;			  ///< Scratch arrays reused by every iteration.
+};
+
+/**
+ * \class NewtonCG
+ * \brief Truncated Newton method with a conjugate gradient inner solver.
+ *
+ * Every iteration solves the Newton system H p = -g approximately by
+ * conjugate gradients that only call Function::hessVec, so the Hessian is
+ * never formed and the memory stays O(n). The inner solve stops once the
+ * residual is below min(0.5, ||g||) * ||g||, which gives quadratic
+ * convergence near a minimum with a positive definite Hessian, or when it
+ * meets a direction of non-positive curvature. The step is then backtracked
+ * until the Armijo condition holds, projecting the trial points onto the area.
+ *
+ * On a bounded area this is a projected Newton method: variables on a bound
+ * whose gradient points out of the area are held fixed, and the system is
+ * solved over the free variables only, so the step is not wasted pushing
+ * against the bounds.
+ */
+class NewtonCG : public OptimizationMethod
+{
+public:
+	/**
+	 * \brief Constructor for NewtonCG.
+	 *
+	 * \param maxCgIter The maximum number of conjugate gradient iterations, 0 for the dimension.
+	 * \param c1 The sufficient decrease constant of the backtracking.
+	 * \param maxBacktracks The maximum number of step halvings per iteration.
+	 * \throw std::invalid_argument If c1 is not in (0, 1).
+	 */
+	NewtonCG(size_t maxCgIter = 0, double c1 = 1e-4, size_t maxBacktracks = 30);
+	~NewtonCG();
+	virtual void optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria) override;
+	virtual std::string getName() override;
+	virtual std::shared_ptr<OptimizationMethod> clone() const override;
+
+private:
+	/**
+	 * \brief The optimization loop, instantiated with and without an observer.
+	 */
+	template <bool Observed>
+	void optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria);
+	/**
+	 * \brief Solve H(x) p = -g approximately by conjugate gradients over the free variables.
+	 *
+	 * \param f The function.
+	 * \param x The current point.
+	 * \param grad The gradient at the current point.
+	 * \param free 1 for a free variable, 0 for a variable held on its bound.
+	 * \param step Receives the approximate Newton step, 0 on the held variables.
+	 */
+	void solveNewton(const Function &f, const VectorX &x, const VectorX &grad, const VectorX &free, VectorX &step) const;
+
+	size_t maxCgIter;	  ///< The maximum number of conjugate gradient iterations, 0 for the dimension.
+	double c1;			  ///< The sufficient decrease constant.
+	size_t maxBacktracks; ///< The maximum number of step halvings per iteration.
+};
+
+/**
+ * \class FixedAdamGradientDescent
+ * \brief Adam gradient descent specialized on a function of compile-time dimension.
+ *
+ * Follows the same update and area handling as AdamGradientDescent, but keeps
+ * its state in VectorN and calls the fixed-dimension overloads of F directly.
+ * Only the current and the previous point are stored, so an iteration makes
+ * no allocation and no virtual call into the function.
+ *
+ * Through the OptimizationMethod interface the function must be an F.
+ *
+ * \tparam F A function class with a static Dim member, such as Function4.
+ */
+template <typename F>
+class FixedAdamGradientDescent : public OptimizationMethod
+{
+public:
+	using Point = VectorN<F::Dim>; ///< The point type of the function.
+
+	/**
+	 * \brief Constructor for FixedAdamGradientDescent.
+	 *
+	 * \param alpha The learning rate.
+	 * \param beta1 The exponential decay rate for the first moment estimates.
+	 * \param beta2 The exponential decay rate for the second moment estimates.
+	 * \param epsilon A small constant to prevent division by zero.
+	 */
+	FixedAdamGradientDescent(double alpha, double beta1, double beta2, double epsilon)
+		: alpha(alpha), beta1(beta1), beta2(beta2), epsilon(epsilon)
+	{
+	}
+	/**
+	 * \brief Optimizes the given function within the specified area.
+	 *
+	 * \param startPoint The point to start from.
+	 * \param area The area within which to optimize the function.
+	 * \param f The function to be optimized.
+	 * \param criteria The stopping criteria for the optimization.
+	 * \throw std::invalid_argument If the area does not bound every coordinate.
+	 */
+	void optimise(const Point &startPoint, const Area &area, const F &f, const StopCriteria &criteria);
+	/**
+	 * \brief Optimizes the given function, which must be an F.
+	 *
+	 * \throw std::invalid_argument If f is not an F, or the start point or the area has another dimension.
+	 */
+	virtual void optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria) override;
+	virtual std::string getName() override { return "FixedAdamGradientDescent"; }
+	virtual std::shared_ptr<OptimizationMethod> clone() const override { return std::make_shared<FixedAdamGradientDescent>(*this); }
+	/**
+	 * \brief Retrieves the best point found during optimization as a VectorN.
+	 */
+	Point getFixedBestPoint() const { return bestPoint; }
+
+private:
+	/**
+	 * \brief The optimization loop, instantiated with and without an observer.
+	 */
+	template <bool Observed>
+	void optimiseLoop(const Point &startPoint, const Area &area, const F &f, const StopCriteria &criteria);
+
+	double alpha;	///< The learning rate.
+	double beta1;	///< The decay rate for the first moment.
+	double beta2;	///< The decay rate for the second moment.
+	double epsilon; ///< Small constant to prevent division by zero.
+	Point bestPoint; ///< The last point of the trajectory.
+};
+
+template <typename F>
+void FixedAdamGradientDescent<F>::optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	const F *fixed = dynamic_cast<const F *>(&f);
+	if (!fixed)
+		throw std::invalid_argument(getName() + " cannot optimise " + f.getName() + ".");
+	if (startPoint.size() != F::Dim)
+		throw std::invalid_argument("Start point must have exactly " + std::to_string(F::Dim) + " elements.");
+	optimise(Point(startPoint), area, *fixed, criteria);
+	points.assign(1, bestPoint.toVectorX());
+}
+
+template <typename F>
+void FixedAdamGradientDescent<F>::optimise(const Point &startPoint, const Area &area, const F &f, const StopCriteria &criteria)
+{
+	if (observer)
+		optimiseLoop<true>(startPoint, area, f, criteria);
+	else
+		optimiseLoop<false>(startPoint, area, f, criteria);
+}
+
+template <typename F>
+template <bool Observed>
+void FixedAdamGradientDescent<F>::optimiseLoop(const Point &startPoint, const Area &area, const F &f, const StopCriteria &criteria)
+{
+	constexpr size_t dim = F::Dim;
+	RunStats begin = threadRunStats;
+	const std::vector<std::pair<double, double>> &bound = area.getBounds();
+	if (bound.size() != dim)
+		throw std::invalid_argument("The area must bound every coordinate of the function.");
+	Point lower, upper;
+	for (size_t i = 0; i < dim; ++i)
+	{
+		lower[i] = bound[i].first;
+		upper[i] = bound[i].second;
+	}
+	Point point = startPoint;
+	Point prevPoint = startPoint;
+	Point grad, m, v, direction;
+	double value = f.evaluate(point, grad);
+	size_t evaluations = 1;
+	double prevValue = value;
+	size_t pointsNum = 1;
+	double beta1Pow = 1;
+	double beta2Pow = 1;
+	iterMade = 0;
+	IterationTimer<Observed> timer(observer);
+	auto describe = [&]
+	{
+		return IterationInfo{iterMade, prevValue, norm(point - prevPoint)};
+	};
+	while (!isCancelled() && !criteria.check(IterationSnapshot{iterMade, pointsNum, norm(grad), norm(point - prevPoint), value, prevValue}))
+	{
+		timer.mark(IterationPhase::Criteria);
+		++iterMade;
+		beta1Pow *= beta1;
+		beta2Pow *= beta2;
+		double biasCorrection1 = 1 - beta1Pow;
+		double biasCorrection2 = 1 - beta2Pow;
+		bool inArea = true;
+		Point nextPoint = point;
+		for (size_t i = 0; i < dim; ++i)
+		{
+			m[i] = beta1 * m[i] + (1 - beta1) * grad[i];
+			v[i] = beta2 * v[i] + (1 - beta2) * grad[i] * grad[i];
+			direction[i] = m[i] / biasCorrection1 / (sqrt(v[i] / biasCorrection2) + epsilon);
+			nextPoint[i] -= alpha * direction[i];
+			inArea = inArea && nextPoint[i] >= lower[i] && nextPoint[i] <= upper[i];
+		}
+		if (!inArea)
+		{
+			double alphaMax = INFINITY;
+			for (size_t i = 0; i < dim; ++i)
+				alphaMax = std::min(alphaMax, std::max((point[i] - lower[i]) / direction[i], (point[i] - upper[i]) / direction[i]));
+			nextPoint = point - alphaMax * direction;
+		}
+		prevPoint = point;
+		prevValue = value;
+		point = nextPoint;
+		timer.mark(IterationPhase::Other);
+		value = f.evaluate(point, grad);
+		timer.mark(IterationPhase::Evaluation);
+		++evaluations;
+		++pointsNum;
+		timer.finish(describe);
+		if (!inArea)
+			break;
+	}
+	bestPoint = point;
+	threadRunStats.valueCalls += evaluations;
+	threadRunStats.gradCalls += evaluations;
+	stats = threadRunStats - begin;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Function.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \brief The operations of the compiled formulas of ParsedFunction.
+ */
+enum class ExprOp : uint8_t
+{
+    Variable, ///< An independent variable.
+    Constant, ///< A number.
+    Add,      ///< lhs + rhs.
+    Sub,      ///< lhs - rhs.
+    Mul,      ///< lhs * rhs.
+    Div,      ///< lhs / rhs.
+    Pow,      ///< lhs ^ rhs.
+    Neg,      ///< -lhs.
+    Sin,      ///< sin(lhs).
+    Cos,      ///< cos(lhs).
+    Tan,      ///< tan(lhs).
+    Exp,      ///< exp(lhs).
+    Log,      ///< log(lhs).
+    Sqrt,     ///< sqrt(lhs).
+    Abs,      ///< abs(lhs).
+    Sign,     ///< The sign of lhs, the derivative of abs.
+};
+
+/**
+ * \class ParsedFunction
+ * \brief A function given by a formula at run time.
+ *
+ * The formula uses the notation of the names of the built-in functions, for
+ * example "(1 - x)^2 + 100(y - x^2)^2": the operators + - * / ^, implicit
+ * multiplication such as 100(y - x) or 2x, parentheses, the functions sin,
+ * cos, tan, exp, log, sqrt and abs, and the constants pi and e.
+ *
+ * The formula is parsed into an expression graph that folds constants and
+ * shares common subexpressions. The gradient is derived symbolically in the
+ * same graph, so it shares subexpressions with the value. Both are compiled
+ * to flat register bytecode. evaluateBatch() runs each instruction over a
+ * block of points at once, which amortizes the dispatch and lets the
+ * compiler vectorize the arithmetic.
+ */
+class ParsedFunction : public Function
+{
+public:
+    /**
+     * \brief Constructor for ParsedFunction.
+     *
+     * \param formula The formula.
+     * \param variables The names of the variables in coordinate order. If
+     * empty, the identifiers of the formula are used: x, y, z and w first in
+     * that order, then the others ordered by name and numeric suffix, so x2
+     * comes before x10.
+     * \throw std::invalid_argument If the formula is malformed, uses an
+     * identifier that is not a variable, or has no variables.
+     */
+    explicit ParsedFunction(const std::string &formula, const std::vector<std::string> &variables = {});
+    ~ParsedFunction();
+    std::shared_ptr<Function> clone() const override;
+    /**
+     * \brief Get the names of the variables in coordinate order.
+     *
+     * \return The names of the variables.
+     */
+    const std::vector<std::string> &getVariables() const;
+    /**
+     * \brief Get the number of instructions of a compiled program.
+     *
+     * \param withGrad Whether to count the program that also calculates the gradient.
+     * \return The number of instructions.
+     */
+    size_t getProgramSize(bool withGrad) const;
+
+    /**
+     * \struct Instruction
+     * \brief One instruction of the bytecode: dst = op(lhs, rhs).
+     */
+    struct Instruction
+    {
+        ExprOp op;    ///< The operation.
+        uint32_t dst; ///< The register written.
+        uint32_t lhs; ///< The first operand register.
+        uint32_t rhs; ///< The second operand register, unused by unary operations.
+    };
+
+    /**
+     * \struct Program
+     * \brief Compiled bytecode with its register layout.
+     *
+     * Registers [0, dim) hold the variables and the next constants.size()
+     * registers the constants; instructions never write to either.
+     */
+    struct Program
+    {
+        std::vector<Instruction> code; ///< The instructions in execution order.
+        std::vector<double> constants; ///< The values of the constant registers.
+        std::vector<uint32_t> outputs; ///< The registers of the results: the value, then the gradient if compiled.
+        size_t registersNum = 0;       ///< The number of registers.
+    };
+
+protected:
+    double calcValue(const VectorX &x) const override;
+    VectorX calcGrad(const VectorX &x) const override;
+    Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+    void calcBatch(const PointBatch &points, double *values, PointBatch *grads) const override;
+
+private:
+    std::vector<std::string> variables;          ///< The names of the variables.
+    std::shared_ptr<const Program> valueProgram; ///< Calculates the value.
+    std::shared_ptr<const Program> gradProgram;  ///< Calculates the value and the gradient.
+};
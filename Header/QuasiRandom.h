@@ -0,0 +1,174 @@
+#pragma once
+
+#include "RandomEngine.h"
+#include <vector>
+
+/**
+ * \class SobolSequence
+ * \brief The Sobol low-discrepancy sequence, optionally Owen-scrambled.
+ *
+ * The first 2^k points of every coordinate fall one into each interval of
+ * width 2^-k, and the direction numbers of Joe and Kuo (new-joe-kuo-6.21201)
+ * keep the two-dimensional projections similarly even, so a box is covered
+ * with fewer gaps and clusters than by independent uniform points. Points
+ * are produced in Gray-code order, one exclusive or per coordinate; the
+ * first 2^k of them are the same set as in the natural order.
+ *
+ * The plain sequence is deterministic and holds the corner and the center
+ * of the box among its first points, which flatters functions whose minimum
+ * lies there. The scrambled sequence applies a random nested permutation of
+ * the binary digits of every coordinate, hashed from the seed as proposed by
+ * Burley; it keeps the equidistribution of the plain sequence and removes
+ * its structure along the diagonals.
+ *
+ * The sequence has 2^32 points and then starts over.
+ */
+class SobolSequence : public RandomEngine
+{
+public:
+    /**
+     * \brief Constructor for SobolSequence.
+     *
+     * \param dim The dimension of the points, at most maxDim.
+     * \param scramble True to scramble the sequence.
+     * \param seed The seed of the scrambling.
+     * \throw std::invalid_argument If dim is 0 or greater than maxDim.
+     */
+    explicit SobolSequence(size_t dim, bool scramble = false, uint64_t seed = 0);
+    ~SobolSequence();
+    /**
+     * \brief Write the next point of the sequence.
+     *
+     * \param u Receives dim coordinates in [0, 1).
+     * \param dim The dimension of the point.
+     * \throw std::invalid_argument If dim is not the dimension of the sequence.
+     */
+    void nextPoint(double *u, size_t dim) override;
+    /**
+     * \brief Skip points of the sequence in constant time per coordinate.
+     *
+     * \param count The number of points to skip.
+     * \param dim The dimension of the points.
+     * \throw std::invalid_argument If dim is not the dimension of the sequence.
+     */
+    void skipPoints(uint64_t count, size_t dim) override;
+    std::shared_ptr<RandomEngine> clone() const override;
+    std::string getName() const override;
+    /**
+     * \brief Get the index of the next point.
+     *
+     * \return The number of points drawn or skipped, modulo 2^32.
+     */
+    uint32_t getIndex() const;
+
+    static constexpr size_t maxDim = 256; ///< The number of dimensions with direction numbers.
+
+private:
+    /**
+     * \brief Check the dimension of a request.
+     *
+     * \param dim The dimension.
+     * \throw std::invalid_argument If dim is not the dimension of the sequence.
+     */
+    void checkDim(size_t dim) const;
+
+    size_t dimension;                 ///< The dimension of the points.
+    bool scrambled;                   ///< True if the digits are scrambled.
+    uint32_t index;                   ///< The index of the next point.
+    std::vector<uint32_t> directions; ///< Direction number c + 1 of coordinate j at c * dimension + j.
+    std::vector<uint32_t> seeds;      ///< The scrambling seed of every coordinate.
+    std::vector<uint32_t> state;      ///< The unscrambled digits of the next point.
+};
+
+/**
+ * \class HaltonSequence
+ * \brief The Halton low-discrepancy sequence.
+ *
+ * Coordinate j of point i is the radical inverse of i in the j-th prime
+ * base: the digits of i mirrored around the radix point. Any dimension is
+ * supported and skipping ahead is free, but the coordinates with large bases
+ * are strongly correlated over short runs, so the sequence is best suited to
+ * a few dozen dimensions.
+ */
+class HaltonSequence : public RandomEngine
+{
+public:
+    /**
+     * \brief Constructor for HaltonSequence.
+     *
+     * \param dim The dimension of the points.
+     * \throw std::invalid_argument If dim is 0.
+     */
+    explicit HaltonSequence(size_t dim);
+    ~HaltonSequence();
+    /**
+     * \brief Write the next point of the sequence.
+     *
+     * \param u Receives dim coordinates in [0, 1).
+     * \param dim The dimension of the point.
+     * \throw std::invalid_argument If dim is not the dimension of the sequence.
+     */
+    void nextPoint(double *u, size_t dim) override;
+    /**
+     * \brief Skip points of the sequence in constant time.
+     *
+     * \param count The number of points to skip.
+     * \param dim The dimension of the points.
+     * \throw std::invalid_argument If dim is not the dimension of the sequence.
+     */
+    void skipPoints(uint64_t count, size_t dim) override;
+    std::shared_ptr<RandomEngine> clone() const override;
+    std::string getName() const override;
+    /**
+     * \brief Get the index of the next point.
+     *
+     * \return The number of points drawn or skipped.
+     */
+    uint64_t getIndex() const;
+
+private:
+    /**
+     * \brief Check the dimension of a request.
+     *
+     * \param dim The dimension.
+     * \throw std::invalid_argument If dim is not the dimension of the sequence.
+     */
+    void checkDim(size_t dim) const;
+
+    uint64_t index;              ///< The index of the next point.
+    std::vector<uint32_t> bases; ///< The prime base of every coordinate.
+};
+
+/**
+ * \enum Sampling
+ * \brief The kind of points a search draws from its area.
+ */
+enum class Sampling
+{
+    Random,         ///< Independent uniform points from xoshiro256++.
+    Sobol,          ///< The Sobol sequence.
+    ScrambledSobol, ///< The Owen-scrambled Sobol sequence.
+    Halton          ///< The Halton sequence.
+};
+
+/**
+ * \brief Create the engine of a sampling method.
+ *
+ * \param sampling The sampling method.
+ * \param dim The dimension of the points.
+ * \param seed The seed of the generator or of the scrambling; unused by Sobol and Halton.
+ * \return The engine, positioned at its first point. The plain Sobol and
+ * Halton sequences start at their second point, since the first one is the
+ * lower corner of the box.
+ * \throw std::invalid_argument If the method does not support the dimension.
+ */
+std::shared_ptr<RandomEngine> makeSampler(Sampling sampling, size_t dim, uint64_t seed);
+
+/**
+ * \brief Parse the name of a sampling method.
+ *
+ * \param name random, sobol, scrambled-sobol or halton.
+ * \return The sampling method.
+ * \throw std::invalid_argument If the name is unknown.
+ */
+Sampling parseSampling(const std::string &name);
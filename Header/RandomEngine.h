@@ -0,0 +1,238 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * \class RandomEngine
+ * \brief Abstract source of points of the unit cube, used by Area to sample boxes.
+ *
+ * Area::genRandPoint() asks the engine for the next point of [0, 1)^n and
+ * maps it onto the bounds of the area, so the sampling method can be
+ * changed without touching the areas or the optimization methods.
+ */
+class RandomEngine
+{
+public:
+    RandomEngine();
+    virtual ~RandomEngine();
+    /**
+     * \brief Write the next point of the unit cube.
+     *
+     * \param u Receives dim coordinates in [0, 1).
+     * \param dim The dimension of the point.
+     */
+    virtual void nextPoint(double *u, size_t dim) = 0;
+    /**
+     * \brief Skip points, as if nextPoint() had been called count times.
+     *
+     * Parallel workers skip to disjoint blocks of one sequence this way. The
+     * default draws and discards the points.
+     *
+     * \param count The number of points to skip.
+     * \param dim The dimension of the points.
+     */
+    virtual void skipPoints(uint64_t count, size_t dim);
+    /**
+     * \brief Create a copy of the engine in its current state.
+     *
+     * \return The copy.
+     */
+    virtual std::shared_ptr<RandomEngine> clone() const = 0;
+    /**
+     * \brief Get the name of the engine.
+     *
+     * \return The name.
+     */
+    virtual std::string getName() const = 0;
+
+protected:
+    /**
+     * \brief Map 64 random bits to a double uniform in [0, 1).
+     *
+     * The top 52 bits become the mantissa of a number in [1, 2), so the
+     * conversion needs only integer operations and one subtraction, which
+     * vectorize on every instruction set.
+     *
+     * \param bits The random bits.
+     * \return A multiple of 2^-52 in [0, 1).
+     */
+    static double toUnit(uint64_t bits)
+    {
+        return std::bit_cast<double>(UINT64_C(0x3FF0000000000000) | bits >> 12) - 1.0;
+    }
+};
+
+/**
+ * \class Xoshiro256
+ * \brief The xoshiro256++ generator of Blackman and Vigna.
+ *
+ * 32 bytes of state and a handful of shifts, rotations and additions per
+ * 64-bit output, with a period of 2^256 - 1. It satisfies the uniform random
+ * bit generator requirements, so it also works with the standard
+ * distributions. jump() and longJump() advance the state by 2^128 and 2^192
+ * outputs, which splits the period into non-overlapping streams for
+ * parallel use.
+ */
+class Xoshiro256 : public RandomEngine
+{
+public:
+    using result_type = uint64_t;
+
+    /**
+     * \brief Constructor for Xoshiro256.
+     *
+     * The state is filled from the seed by splitmix64, so nearby seeds give
+     * unrelated sequences.
+     *
+     * \param seed The seed.
+     */
+    explicit Xoshiro256(uint64_t seed = 0);
+    ~Xoshiro256();
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+
+    static constexpr result_type max()
+    {
+        return UINT64_MAX;
+    }
+
+    result_type operator()()
+    {
+        uint64_t result = std::rotl(state[0] + state[3], 23) + state[0];
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = std::rotl(state[3], 45);
+        return result;
+    }
+
+    /**
+     * \brief Get the next number uniform in [0, 1).
+     *
+     * \return The number.
+     */
+    double uniform()
+    {
+        return toUnit((*this)());
+    }
+    /**
+     * \brief Fill an array with numbers uniform in [0, 1).
+     *
+     * \param u The array.
+     * \param n The number of elements.
+     */
+    void fillUniform(double *u, size_t n);
+    /**
+     * \brief Advance the state by 2^128 outputs.
+     */
+    void jump();
+    /**
+     * \brief Advance the state by 2^192 outputs.
+     */
+    void longJump();
+    void nextPoint(double *u, size_t dim) override;
+    std::shared_ptr<RandomEngine> clone() const override;
+    std::string getName() const override;
+
+private:
+    /**
+     * \brief Advance the state by the polynomial of a jump.
+     *
+     * \param polynomial The coefficients of the jump polynomial.
+     */
+    void jump(const uint64_t (&polynomial)[4]);
+
+    uint64_t state[4]; ///< The state, never all zero.
+};
+
+/**
+ * \class Philox4x32
+ * \brief The counter-based Philox4x32-10 generator of Salmon et al.
+ *
+ * Each block of four 32-bit outputs is a keyed bijection of its 128-bit
+ * counter, computed by ten rounds of multiplications and exclusive ors, with
+ * no state carried from one block to the next. The key is the seed and the
+ * counter holds the stream number and the block index, so there are 2^64
+ * independent streams of 2^65 outputs each, any position of a stream is
+ * reached in constant time, and fillUniform() computes several blocks at once
+ * in the vector registers of the processor.
+ */
+class Philox4x32 : public RandomEngine
+{
+public:
+    using result_type = uint64_t;
+
+    /**
+     * \brief Constructor for Philox4x32.
+     *
+     * \param seed The seed, used as the key.
+     * \param stream The number of the stream.
+     */
+    explicit Philox4x32(uint64_t seed = 0, uint64_t stream = 0);
+    ~Philox4x32();
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+
+    static constexpr result_type max()
+    {
+        return UINT64_MAX;
+    }
+
+    result_type operator()();
+    /**
+     * \brief Get the next number uniform in [0, 1).
+     *
+     * \return The number.
+     */
+    double uniform();
+    /**
+     * \brief Fill an array with numbers uniform in [0, 1).
+     *
+     * \param u The array.
+     * \param n The number of elements.
+     */
+    void fillUniform(double *u, size_t n);
+    /**
+     * \brief Skip outputs of the stream.
+     *
+     * \param n The number of 64-bit outputs to skip.
+     */
+    void discard(uint64_t n);
+    /**
+     * \brief Get the position in the stream.
+     *
+     * \return The number of 64-bit outputs drawn so far.
+     */
+    uint64_t getPosition() const;
+    void nextPoint(double *u, size_t dim) override;
+    void skipPoints(uint64_t count, size_t dim) override;
+    std::shared_ptr<RandomEngine> clone() const override;
+    std::string getName() const override;
+    /**
+     * \brief Compute one block of the generator.
+     *
+     * \param counter The counter.
+     * \param key The key.
+     * \param out Receives the four outputs.
+     */
+    static void block(const uint32_t (&counter)[4], const uint32_t (&key)[2], uint32_t (&out)[4]);
+
+private:
+    uint32_t key[2];    ///< The seed.
+    uint64_t stream;    ///< The stream number, the upper half of the counter.
+    uint64_t position;  ///< The index of the next 64-bit output.
+    uint64_t buffer[2]; ///< The outputs of the block holding the current position.
+};
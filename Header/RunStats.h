@@ -0,0 +1,102 @@
+#pragma once
+
+#include "VectorPool.h"
+#include <cstddef>
+#include <limits>
+#include <new>
+
+/**
+ * \struct RunStats
+ * \brief Counters of the work done during an optimization run.
+ *
+ * The counters are collected per thread in threadRunStats, so incrementing
+ * them costs a single non-atomic add. The cost of a run is the difference of
+ * the counters before and after it.
+ */
+struct RunStats
+{
+    size_t valueCalls = 0;           ///< Function values calculated, one per point of a batch.
+    size_t gradCalls = 0;            ///< Gradients calculated, one per point of a batch.
+    size_t criteriaValueCalls = 0;   ///< Function values calculated while checking the stopping criteria.
+    size_t criteriaGradCalls = 0;    ///< Gradients calculated while checking the stopping criteria.
+    size_t lineSearchValueCalls = 0; ///< Function values calculated by line searches.
+    size_t lineSearchGradCalls = 0;  ///< Gradients calculated by line searches.
+    size_t hessVecCalls = 0;         ///< Hessian-vector products calculated.
+    size_t vectorAllocations = 0;    ///< Buffers of VectorX allocated on the heap.
+    size_t vectorReuses = 0;         ///< Buffers of VectorX taken back from a VectorPoolScope.
+
+    /**
+     * \brief Add the counters of another run.
+     *
+     * \param other The counters to add.
+     * \return A reference to this object.
+     */
+    RunStats &operator+=(const RunStats &other);
+};
+
+/**
+ * \brief Calculate the counters accumulated between two snapshots.
+ *
+ * \param end The later snapshot.
+ * \param begin The earlier snapshot.
+ * \return The difference of the counters.
+ */
+RunStats operator-(const RunStats &end, const RunStats &begin);
+
+/**
+ * \brief The counters of the calling thread.
+ *
+ * Built-in functions count their evaluations here and VectorX counts its
+ * allocations. Constant initialization lets the compiler access the variable
+ * without a thread-local initialization guard.
+ */
+extern thread_local constinit RunStats threadRunStats;
+
+/**
+ * \class CountingAllocator
+ * \brief Allocator of VectorX that draws from the vector pool and counts allocations in threadRunStats.
+ *
+ * Buffers are reused from the pool of the calling thread while a
+ * VectorPoolScope is open, and come from the heap otherwise.
+ *
+ * \tparam T The element type.
+ */
+template <typename T>
+class CountingAllocator
+{
+public:
+    using value_type = T;
+
+    CountingAllocator() = default;
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &) noexcept
+    {
+    }
+
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Pooled buffers have the default alignment.");
+
+    T *allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T *>(acquireVectorBuffer(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t n) noexcept
+    {
+        releaseVectorBuffer(ptr, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U> &) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U> &) const noexcept
+    {
+        return false;
+    }
+};
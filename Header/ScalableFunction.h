@@ -0,0 +1,261 @@
+#pragma once
+
+#include "Function.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \class ScalableFunction
+ * \brief Abstract base class for test functions whose dimension is chosen at construction.
+ *
+ * The functions of this family are defined for any dimension from the
+ * smallest that makes sense up to millions of variables, which makes them
+ * suitable for measuring how the optimization methods scale. Each one
+ * computes its value and gradient in a single pass over unit-stride arrays.
+ * Sums are accumulated in several independent lanes, so the compiler can
+ * vectorize the loops without reassociating floating-point additions on its
+ * own, and the periodic terms use an inline sine and cosine instead of calls
+ * to the library.
+ */
+class ScalableFunction : public Function
+{
+public:
+    /**
+     * \brief Constructor for ScalableFunction.
+     *
+     * \param name The name of the function, without the dimension.
+     * \param dim The dimension of the function.
+     * \param minDim The smallest dimension the function is defined for.
+     * \throw std::invalid_argument If dim is less than minDim.
+     */
+    ScalableFunction(const std::string &name, size_t dim, size_t minDim = 1);
+    ~ScalableFunction();
+    /**
+     * \brief Get the value at the global minimum.
+     *
+     * \return The smallest value of the function.
+     */
+    virtual double getMinValue() const = 0;
+    /**
+     * \brief Get a global minimizer.
+     *
+     * \return A point at which the function takes getMinValue().
+     */
+    virtual VectorX getMinimizer() const = 0;
+    /**
+     * \brief Get the half-width of the customary search box.
+     *
+     * \return The bound b of the box [-b, b]^n the function is usually searched in.
+     */
+    virtual double getDomainBound() const = 0;
+
+protected:
+    double calcValue(const VectorX &x) const override;
+    VectorX calcGrad(const VectorX &x) const override;
+    Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+    /**
+     * \brief Calculate the value and, optionally, the gradient.
+     *
+     * \param x The point, of getDim() coordinates.
+     * \param grad If not null, receives getDim() partial derivatives.
+     * \return The value at x.
+     */
+    virtual double compute(const double *x, double *grad) const = 0;
+    /**
+     * \brief Check the dimension of a vector argument.
+     *
+     * \param x The vector.
+     * \throw std::invalid_argument If x does not have getDim() elements.
+     */
+    void checkDim(const VectorX &x) const;
+};
+
+/**
+ * \class RosenbrockFunction
+ * \brief The chained Rosenbrock function, sum of 100(x_{i+1} - x_i^2)^2 + (1 - x_i)^2.
+ *
+ * Function4 is the case n = 2. The minimum is 0 at (1, ..., 1), at the end
+ * of a curved valley. The Hessian is tridiagonal, so hessVec() is exact.
+ */
+class RosenbrockFunction : public ScalableFunction
+{
+public:
+    /**
+     * \brief Constructor for RosenbrockFunction.
+     *
+     * \param dim The dimension, at least 2.
+     * \throw std::invalid_argument If dim is less than 2.
+     */
+    explicit RosenbrockFunction(size_t dim);
+    ~RosenbrockFunction();
+    std::shared_ptr<Function> clone() const override;
+    double getMinValue() const override;
+    VectorX getMinimizer() const override;
+    double getDomainBound() const override;
+
+protected:
+    VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+    double compute(const double *x, double *grad) const override;
+};
+
+/**
+ * \class RastriginFunction
+ * \brief The Rastrigin function, 10n + sum of x_i^2 - 10 cos(2 pi x_i).
+ *
+ * Highly multimodal with a regular grid of local minima. The minimum is 0 at
+ * the origin. The function is separable, so hessVec() is exact.
+ */
+class RastriginFunction : public ScalableFunction
+{
+public:
+    /**
+     * \brief Constructor for RastriginFunction.
+     *
+     * \param dim The dimension, at least 1.
+     * \throw std::invalid_argument If dim is 0.
+     */
+    explicit RastriginFunction(size_t dim);
+    ~RastriginFunction();
+    std::shared_ptr<Function> clone() const override;
+    double getMinValue() const override;
+    VectorX getMinimizer() const override;
+    double getDomainBound() const override;
+
+protected:
+    VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+    double compute(const double *x, double *grad) const override;
+};
+
+/**
+ * \class AckleyFunction
+ * \brief The Ackley function.
+ *
+ * -20 exp(-0.2 sqrt(mean of x_i^2)) - exp(mean of cos(2 pi x_i)) + 20 + e:
+ * a nearly flat outer region around a deep funnel. The minimum is 0 at the
+ * origin, where the function is not differentiable; the gradient returned
+ * there is 0.
+ */
+class AckleyFunction : public ScalableFunction
+{
+public:
+    /**
+     * \brief Constructor for AckleyFunction.
+     *
+     * \param dim The dimension, at least 1.
+     * \throw std::invalid_argument If dim is 0.
+     */
+    explicit AckleyFunction(size_t dim);
+    ~AckleyFunction();
+    std::shared_ptr<Function> clone() const override;
+    double getMinValue() const override;
+    VectorX getMinimizer() const override;
+    double getDomainBound() const override;
+
+protected:
+    double compute(const double *x, double *grad) const override;
+};
+
+/**
+ * \class GriewankFunction
+ * \brief The Griewank function, 1 + sum of x_i^2 / 4000 - product of cos(x_i / sqrt(i)).
+ *
+ * A paraboloid with a product of cosines that couples all coordinates. The
+ * minimum is 0 at the origin. The gradient uses prefix and suffix products,
+ * so it does not divide by cosines that may vanish. The factors 1 / sqrt(i)
+ * are computed once and shared by the clones.
+ */
+class GriewankFunction : public ScalableFunction
+{
+public:
+    /**
+     * \brief Constructor for GriewankFunction.
+     *
+     * \param dim The dimension, at least 1.
+     * \throw std::invalid_argument If dim is 0.
+     */
+    explicit GriewankFunction(size_t dim);
+    ~GriewankFunction();
+    std::shared_ptr<Function> clone() const override;
+    double getMinValue() const override;
+    VectorX getMinimizer() const override;
+    double getDomainBound() const override;
+
+protected:
+    double compute(const double *x, double *grad) const override;
+
+private:
+    std::shared_ptr<const std::vector<double>> frequencies; ///< The factors 1 / sqrt(i) of the coordinates.
+};
+
+/**
+ * \class StyblinskiTangFunction
+ * \brief The Styblinski-Tang function, half the sum of x_i^4 - 16 x_i^2 + 5 x_i.
+ *
+ * Every coordinate has two local minima, so there are 2^n in total. The
+ * global minimum is about -39.166 n at x_i = -2.9035. The function is
+ * separable, so hessVec() is exact.
+ */
+class StyblinskiTangFunction : public ScalableFunction
+{
+public:
+    /**
+     * \brief Constructor for StyblinskiTangFunction.
+     *
+     * \param dim The dimension, at least 1.
+     * \throw std::invalid_argument If dim is 0.
+     */
+    explicit StyblinskiTangFunction(size_t dim);
+    ~StyblinskiTangFunction();
+    std::shared_ptr<Function> clone() const override;
+    double getMinValue() const override;
+    VectorX getMinimizer() const override;
+    double getDomainBound() const override;
+
+protected:
+    VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+    double compute(const double *x, double *grad) const override;
+};
+
+/**
+ * \class QuadraticFunction
+ * \brief An ill-conditioned convex quadratic, half the sum of w_i x_i^2.
+ *
+ * The weights grow geometrically from 1 to the condition number, so the
+ * Hessian diag(w) has exactly that condition number. The minimum is 0 at
+ * the origin. The weights are computed once and shared by the clones.
+ */
+class QuadraticFunction : public ScalableFunction
+{
+public:
+    /**
+     * \brief Constructor for QuadraticFunction.
+     *
+     * \param dim The dimension, at least 1.
+     * \param conditionNumber The ratio of the largest to the smallest weight.
+     * \throw std::invalid_argument If dim is 0 or conditionNumber is less than 1.
+     */
+    explicit QuadraticFunction(size_t dim, double conditionNumber = 1e6);
+    ~QuadraticFunction();
+    std::shared_ptr<Function> clone() const override;
+    double getMinValue() const override;
+    VectorX getMinimizer() const override;
+    double getDomainBound() const override;
+
+protected:
+    VectorX calcHessVec(const VectorX &x, const VectorX &v) const override;
+    double compute(const double *x, double *grad) const override;
+
+private:
+    std::shared_ptr<const std::vector<double>> weights; ///< The diagonal of the Hessian.
+};
+
+/**
+ * \brief Create a scalable function by name.
+ *
+ * \param name rosenbrock, rastrigin, ackley, griewank, styblinskitang or quadratic.
+ * \param dim The dimension.
+ * \return The function.
+ * \throw std::invalid_argument If the name is unknown or the dimension is too small.
+ */
+std::shared_ptr<ScalableFunction> makeScalableFunction(const std::string &name, size_t dim);
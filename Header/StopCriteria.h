@@ -3,6 +3,23 @@
 #include "Function.h"
 #include "TransferData.h"
 
+/**
+ * \struct IterationSnapshot
+ * \brief Quantities of the current iteration a stopping criterion may look at.
+ *
+ * Used by fixed-dimension optimizers, which keep no trajectory and therefore
+ * pass precomputed quantities instead of TransferData.
+ */
+struct IterationSnapshot
+{
+	size_t iterNum;	  ///< The number of iterations made.
+	size_t pointsNum; ///< The number of points in the trajectory.
+	double gradNorm;  ///< The gradient norm at the current point.
+	double stepNorm;  ///< The distance between the current and the previous point.
+	double currValue; ///< The function value at the current point.
+	double prevValue; ///< The function value at the previous point.
+};
+
 /**
  * \class StopCriteria
  * \brief Abstract base class for stopping criteria in optimization methods.
@@ -33,6 +50,15 @@ public:
 	 * \return True if the optimization should be stopped, false otherwise.
 	 */
 	virtual bool check(TransferData &data) const = 0;
+	/**
+	 * \brief Checks if the optimization process should be stopped.
+	 *
+	 * Same rule as check(TransferData &), applied to precomputed quantities.
+	 *
+	 * \param snapshot The quantities of the current iteration.
+	 * \return True if the optimization should be stopped, false otherwise.
+	 */
+	virtual bool check(const IterationSnapshot &snapshot) const = 0;
 	virtual std::string getName() const = 0;
 
 protected:
@@ -45,6 +71,8 @@ protected:
  * \brief Implementation of stopping criteria based on gradient norm.
  *
  * This class checks if the optimization process should be stopped based on the norm of the gradient.
+ * For methods that keep their points within bounds, such as LBFGSB and NewtonCG, the gradient is
+ * projected onto the bounds first (see TransferData::getGradNorm()), so a minimum on a bound is detected.
  */
 class GradNormStopCriteria : public StopCriteria
 {
@@ -52,6 +80,7 @@ public:
 	GradNormStopCriteria(double eps, size_t max_iter);
 	~GradNormStopCriteria();
 	virtual bool check(TransferData &data) const override;
+	virtual bool check(const IterationSnapshot &snapshot) const override;
 	virtual std::string getName() const override;
 
 private:
@@ -69,6 +98,7 @@ public:
 	DifferenceNormStopCriteria(double eps, size_t max_iter);
 	~DifferenceNormStopCriteria();
 	virtual bool check(TransferData &data) const override;
+	virtual bool check(const IterationSnapshot &snapshot) const override;
 	virtual std::string getName() const override;
 
 private:
@@ -86,6 +116,7 @@ public:
 	FuncDifferenceNormStopCriteria(double eps, size_t max_iter);
 	~FuncDifferenceNormStopCriteria();
 	virtual bool check(TransferData &data) const override;
+	virtual bool check(const IterationSnapshot &snapshot) const override;
 	virtual std::string getName() const override;
 
 private:
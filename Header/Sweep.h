@@ -0,0 +1,127 @@
+#pragma once
+#include "OptimizationMethod.h"
+#include "WorkStealingScheduler.h"
+#include <functional>
+#include <ostream>
+
+/**
+ * \struct SweepResult
+ * \brief Outcome of one job of a parameter sweep.
+ */
+struct SweepResult
+{
+    size_t jobIndex;      ///< The position of the job in the expanded grid.
+    std::string function; ///< The name of the function.
+    std::string method;   ///< The label of the method.
+    std::string criteria; ///< The name of the stopping criteria.
+    VectorX startPoint;   ///< The point the run started from.
+    VectorX bestPoint;    ///< The best point found.
+    double value;         ///< The function value at the best point.
+    size_t iterNum;       ///< The number of iterations made.
+    double seconds;       ///< The wall time of the run.
+    std::string error;    ///< The error message if the run failed, empty otherwise.
+};
+
+/**
+ * \class Sweep
+ * \brief Runs every combination of function, method, criteria and start point.
+ *
+ * The grid is expanded into one job per combination and executed on a
+ * WorkStealingScheduler. Results are passed to a callback as the jobs finish,
+ * one at a time, so they can be streamed into a table.
+ */
+class Sweep
+{
+public:
+    Sweep();
+    ~Sweep();
+    /**
+     * \brief Add a function with the area to search it in.
+     *
+     * \param f The function.
+     * \param area The search area, of the function's dimension.
+     */
+    void addFunction(std::shared_ptr<Function> f, const Area &area);
+    /**
+     * \brief Add a method configuration.
+     *
+     * Hyperparameter variants are added as separate method objects and are
+     * told apart by their label.
+     *
+     * \param method The prototype of the method.
+     * \param label The label in the results; the method name if empty.
+     */
+    void addMethod(std::shared_ptr<OptimizationMethod> method, const std::string &label = "");
+    /**
+     * \brief Add stopping criteria.
+     *
+     * \param criteria The stopping criteria.
+     */
+    void addCriteria(std::shared_ptr<StopCriteria> criteria);
+    /**
+     * \brief Set how many start points are drawn from the area of each function.
+     *
+     * Every method and criteria is run from the same start points.
+     *
+     * \param startsNum The number of start points per function.
+     * \param seed The seed used to draw the start points.
+     * \param sampling How the start points are drawn.
+     */
+    void setStarts(size_t startsNum, unsigned int seed, Sampling sampling = Sampling::Random);
+    /**
+     * \brief Get the number of jobs in the expanded grid.
+     *
+     * \return The number of jobs.
+     */
+    size_t getJobsNum() const;
+    /**
+     * \brief Run all jobs.
+     *
+     * \param threads The number of threads; 0 selects the number of hardware threads.
+     * \param onResult Called once per finished job, never concurrently.
+     */
+    void run(size_t threads, const std::function<void(const SweepResult &)> &onResult);
+
+private:
+    /**
+     * \struct FunctionEntry
+     * \brief A function of the grid with its area and start points.
+     */
+    struct FunctionEntry
+    {
+        std::shared_ptr<Function> f;      ///< The function.
+        Area area;                        ///< The search area.
+        std::vector<VectorX> startPoints; ///< The start points drawn from the area.
+    };
+
+    std::vector<FunctionEntry> functions;                                         ///< The functions of the grid.
+    std::vector<std::pair<std::shared_ptr<OptimizationMethod>, std::string>> methods; ///< The methods and their labels.
+    std::vector<std::shared_ptr<StopCriteria>> criteria;                         ///< The stopping criteria of the grid.
+    size_t startsNum;                                                             ///< Start points per function.
+    unsigned int seed;                                                            ///< Seed of the start points.
+    Sampling sampling;                                                            ///< How the start points are drawn.
+};
+
+/**
+ * \class SweepTable
+ * \brief Writes sweep results as CSV rows.
+ */
+class SweepTable
+{
+public:
+    /**
+     * \brief Constructor for SweepTable. Writes the header row.
+     *
+     * \param os The stream to write to.
+     */
+    explicit SweepTable(std::ostream &os);
+    /**
+     * \brief Write one result as a row and flush it.
+     *
+     * \param result The result to write.
+     */
+    void write(const SweepResult &result);
+
+private:
+    std::ostream &os; ///< The output stream.
+};
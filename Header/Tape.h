@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * \class Arena
+ * \brief Bump-pointer allocator for memory that is released all at once.
+ *
+ * Memory is carved out of large blocks by advancing an offset. Nothing is
+ * freed individually; reset() rewinds to the first block and keeps every
+ * block for reuse, so an arena that is filled and reset repeatedly stops
+ * touching the heap once it has grown to its working size.
+ */
+class Arena
+{
+public:
+    /**
+     * \brief Constructor for Arena.
+     *
+     * \param blockSize The size in bytes of the blocks requested from the heap.
+     * \throw std::invalid_argument If blockSize is zero.
+     */
+    explicit Arena(size_t blockSize = 1 << 16);
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    /**
+     * \brief Allocate uninitialized memory.
+     *
+     * \param bytes The number of bytes.
+     * \param alignment The alignment, a power of two.
+     * \return A pointer valid until the next reset().
+     */
+    void *allocate(size_t bytes, size_t alignment);
+    /**
+     * \brief Allocate an uninitialized array of a trivially destructible type.
+     *
+     * \param n The number of elements.
+     * \return A pointer valid until the next reset().
+     */
+    template <typename T>
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(allocate(n * sizeof(T), alignof(T)));
+    }
+    /**
+     * \brief Release everything allocated so far, keeping the blocks.
+     */
+    void reset();
+    /**
+     * \brief Get the number of bytes held in blocks.
+     *
+     * \return The total size of the blocks.
+     */
+    size_t capacity() const;
+
+private:
+    /**
+     * \struct Block
+     * \brief A chunk of memory obtained from the heap.
+     */
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data; ///< The memory.
+        size_t size;                       ///< The size of the memory in bytes.
+    };
+
+    size_t blockSize;          ///< The size of a regular block.
+    std::vector<Block> blocks; ///< All blocks, in the order they are filled.
+    size_t current;            ///< The index of the block being filled.
+    size_t offset;             ///< The first free byte of the current block.
+};
+
+/**
+ * \brief The operation of a node of a Tape.
+ *
+ * The constant of Constant and of the operations with "Const" in their name
+ * is kept in the constant pool of the tape, and rhs holds its index there.
+ */
+enum class TapeOp : uint8_t
+{
+    Input,    ///< An independent variable; lhs is its index.
+    Constant, ///< A constant.
+    Add,      ///< lhs + rhs.
+    Sub,      ///< lhs - rhs.
+    Mul,      ///< lhs * rhs.
+    Div,      ///< lhs / rhs.
+    Neg,      ///< -lhs.
+    AddConst, ///< lhs + constant.
+    MulConst, ///< lhs * constant.
+    ConstSub, ///< constant - lhs.
+    ConstDiv, ///< constant / lhs.
+    PowConst, ///< lhs raised to the power constant.
+    Sin,      ///< sin(lhs).
+    Cos,      ///< cos(lhs).
+    Exp,      ///< exp(lhs).
+    Log,      ///< log(lhs).
+    Sqrt,     ///< sqrt(lhs).
+};
+
+/**
+ * \struct TapeNode
+ * \brief One recorded operation. Operands are indices of earlier nodes.
+ *
+ * The sweeps over a long tape are limited by memory bandwidth, so the node
+ * keeps its constant out of line and takes 12 bytes.
+ */
+struct TapeNode
+{
+    TapeOp op;    ///< The operation.
+    uint32_t lhs; ///< The first operand.
+    uint32_t rhs; ///< The second operand or the index of the constant, unused by the other unary operations.
+};
+
+class TapeVar;
+
+/**
+ * \class Tape
+ * \brief A recorded computation for reverse-mode automatic differentiation.
+ *
+ * Operations on TapeVar append nodes to the tape. The nodes hold no values,
+ * so a tape whose control flow does not depend on the point can be recorded
+ * once and replayed at any point: forward() recomputes the values of all
+ * nodes and reverse() propagates adjoints back to the inputs in a single
+ * sweep. Values and adjoints live in caller-owned contiguous arrays indexed
+ * by node, so one tape can be replayed by several threads at once.
+ *
+ * Nodes and constants are stored in fixed-size pages taken from an Arena,
+ * so recording performs no heap allocation per node and clear() keeps the
+ * pages for the next recording.
+ */
+class Tape
+{
+public:
+    Tape();
+    ~Tape();
+    Tape(const Tape &) = delete;
+    Tape &operator=(const Tape &) = delete;
+    /**
+     * \brief Forget all nodes and inputs, keeping the memory.
+     */
+    void clear();
+    /**
+     * \brief Record an independent variable.
+     *
+     * \param value The value of the variable while recording.
+     * \return The variable; inputs are numbered in the order they are created.
+     */
+    TapeVar input(double value);
+    /**
+     * \brief Record a constant.
+     */
+    TapeVar constant(double value);
+    /**
+     * \brief Append a node.
+     *
+     * \return The index of the node.
+     * \throw std::length_error If the tape has 2^32 nodes already.
+     */
+    uint32_t push(TapeOp op, uint32_t lhs, uint32_t rhs);
+    /**
+     * \brief Append a node that takes a constant.
+     *
+     * \return The index of the node.
+     * \throw std::length_error If the tape has 2^32 nodes already.
+     */
+    uint32_t pushConstant(TapeOp op, uint32_t lhs, double constant);
+    /**
+     * \brief Get the number of nodes.
+     */
+    size_t size() const { return nodesNum; }
+    /**
+     * \brief Get the number of inputs.
+     */
+    size_t getInputsNum() const { return inputsNum; }
+    /**
+     * \brief Recompute the values of all nodes.
+     *
+     * \param inputs getInputsNum() values of the inputs.
+     * \param values Receives size() node values.
+     */
+    void forward(const double *inputs, double *values) const;
+    /**
+     * \brief Propagate adjoints from one node back to the inputs.
+     *
+     * \param output The index of the node to differentiate.
+     * \param values The node values computed by forward() or while recording.
+     * \param adjoints size() elements of scratch space.
+     * \param grad Receives getInputsNum() partial derivatives of the output.
+     */
+    void reverse(uint32_t output, const double *values, double *adjoints, double *grad) const;
+
+private:
+    static constexpr size_t pageShift = 12;                    ///< Log2 of the number of nodes in a page.
+    static constexpr size_t pageSize = size_t(1) << pageShift; ///< The number of nodes in a page.
+
+    /**
+     * \brief Get a constant of the pool.
+     */
+    double constantAt(uint32_t index) const { return constantPages[index >> pageShift][index & (pageSize - 1)]; }
+
+    Arena arena;                         ///< The memory of the pages.
+    std::vector<TapeNode *> pages;       ///< The pages of nodes in recording order.
+    std::vector<double *> constantPages; ///< The pages of the constant pool.
+    size_t nodesNum;                     ///< The number of nodes.
+    size_t constantsNum;                 ///< The number of constants in the pool.
+    size_t inputsNum;                    ///< The number of inputs.
+};
+
+/**
+ * \class TapeVar
+ * \brief A scalar whose operations are recorded on a Tape.
+ *
+ * The value is computed eagerly while recording, so a formula may branch on
+ * it. A tape recorded that way is only valid for points that take the same
+ * branches.
+ */
+class TapeVar
+{
+public:
+    TapeVar() : tape(nullptr), index(0), val(0) {}
+    TapeVar(Tape *tape, uint32_t index, double value) : tape(tape), index(index), val(value) {}
+    /**
+     * \brief Get the value computed while recording.
+     */
+    double value() const { return val; }
+    /**
+     * \brief Get the index of the node.
+     */
+    uint32_t getIndex() const { return index; }
+    /**
+     * \brief Get the tape the variable is recorded on.
+     */
+    Tape *getTape() const { return tape; }
+
+    TapeVar &operator+=(const TapeVar &other);
+    TapeVar &operator-=(const TapeVar &other);
+    TapeVar &operator*=(const TapeVar &other);
+    TapeVar &operator/=(const TapeVar &other);
+    TapeVar &operator+=(double other);
+    TapeVar &operator-=(double other);
+    TapeVar &operator*=(double other);
+    TapeVar &operator/=(double other);
+
+private:
+    Tape *tape;     ///< The tape, null for a default-constructed variable.
+    uint32_t index; ///< The node on the tape.
+    double val;     ///< The value at the point of recording.
+};
+
+TapeVar operator-(const TapeVar &a);
+TapeVar operator+(const TapeVar &a, const TapeVar &b);
+TapeVar operator-(const TapeVar &a, const TapeVar &b);
+TapeVar operator*(const TapeVar &a, const TapeVar &b);
+TapeVar operator/(const TapeVar &a, const TapeVar &b);
+TapeVar operator+(const TapeVar &a, double b);
+TapeVar operator+(double a, const TapeVar &b);
+TapeVar operator-(const TapeVar &a, double b);
+TapeVar operator-(double a, const TapeVar &b);
+TapeVar operator*(const TapeVar &a, double b);
+TapeVar operator*(double a, const TapeVar &b);
+TapeVar operator/(const TapeVar &a, double b);
+TapeVar operator/(double a, const TapeVar &b);
+TapeVar sin(const TapeVar &a);
+TapeVar cos(const TapeVar &a);
+TapeVar exp(const TapeVar &a);
+TapeVar log(const TapeVar &a);
+TapeVar sqrt(const TapeVar &a);
+TapeVar pow(const TapeVar &a, double p);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Function.h"
+#include "Tape.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \class TapeFunction
+ * \brief A function of any dimension differentiated by reverse-mode AD.
+ *
+ * The formula is written once over TapeVar. Its gradient costs a small
+ * constant multiple of its value regardless of the dimension, which makes the
+ * class suitable for objectives with thousands to millions of variables.
+ *
+ * By default the formula is recorded once, at construction, and the tape is
+ * replayed at every point, so an evaluation allocates nothing but the
+ * returned gradient. This is only valid when the operations the formula
+ * performs do not depend on the point. Formulas that branch on the values of
+ * their variables must be constructed with retape set, and are then recorded
+ * anew at every point into a per-thread tape that keeps its memory.
+ *
+ * The recorded tape is immutable and shared by the clones, and the values
+ * and adjoints of a replay are kept per thread, so one object can be
+ * evaluated from several threads at once.
+ */
+class TapeFunction : public Function
+{
+public:
+    /**
+     * \brief The formula: takes getDim() variables and returns the value.
+     */
+    using Formula = std::function<TapeVar(const std::vector<TapeVar> &x)>;
+
+    /**
+     * \brief Constructor for TapeFunction.
+     *
+     * \param name The name of the function.
+     * \param dim The dimension of the function.
+     * \param formula The formula of the function.
+     * \param retape Whether to record the formula at every point instead of once.
+     * \throw std::invalid_argument If dim is zero or formula is empty.
+     */
+    TapeFunction(const std::string &name, size_t dim, Formula formula, bool retape = false);
+    ~TapeFunction();
+    std::shared_ptr<Function> clone() const override;
+    /**
+     * \brief Get the number of nodes of the tape recorded at construction.
+     *
+     * \return The size of the tape, 0 if the function is recorded at every point.
+     */
+    size_t getTapeSize() const;
+
+protected:
+    double calcValue(const VectorX &x) const override;
+    VectorX calcGrad(const VectorX &x) const override;
+    Evaluation calcEvaluation(const VectorX &x, bool wantGrad) const override;
+
+private:
+    /**
+     * \brief Calculate the values of all nodes at a point.
+     *
+     * \param x The point, of dimension getDim().
+     * \param output Receives the index of the node holding the value.
+     * \return The tape whose node values are in the workspace of the calling thread.
+     */
+    const Tape &replay(const VectorX &x, uint32_t &output) const;
+
+    Formula formula;                  ///< The formula of the function.
+    bool retape;                      ///< Whether the formula is recorded at every point.
+    std::shared_ptr<const Tape> tape; ///< The tape recorded at construction, null if retape is set.
+    uint32_t output;                  ///< The node of tape holding the value.
+};
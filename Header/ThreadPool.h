@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * \class ThreadPool
+ * \brief A fixed set of worker threads executing queued tasks.
+ *
+ * The threads are created once and reused for every submitted task, so the
+ * cost of starting a thread is not paid per optimization run.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * \brief Start the worker threads.
+     *
+     * \param threads The number of worker threads; 0 selects the number of hardware threads.
+     */
+    explicit ThreadPool(size_t threads = 0);
+    /**
+     * \brief Wait for the queued tasks and stop the worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * \brief Queue a task for execution on one of the workers.
+     *
+     * Tasks must not throw; exceptions have to be handled inside the task.
+     *
+     * \param task The task to execute.
+     */
+    void submit(std::function<void()> task);
+    /**
+     * \brief Block until every submitted task has finished.
+     */
+    void wait();
+    /**
+     * \brief Get the number of worker threads.
+     *
+     * \return The number of worker threads.
+     */
+    size_t getThreadsNum() const;
+
+private:
+    /**
+     * \brief Main loop of a worker thread.
+     */
+    void workerLoop();
+
+    std::vector<std::thread> workers;        ///< The worker threads.
+    std::queue<std::function<void()>> tasks; ///< Tasks waiting for a worker.
+    std::mutex mutex;                        ///< Guards tasks, running and stopping.
+    std::condition_variable taskAvailable;   ///< Signalled when a task is queued or the pool stops.
+    std::condition_variable allDone;         ///< Signalled when the last running task finishes.
+    size_t running;                          ///< The number of tasks being executed.
+    bool stopping;                           ///< Set when the pool is destroyed.
+};
@@ -2,6 +2,7 @@
 #include "Function.h"
 #include "VectorX.h"
 #include <memory>
+#include <cstdint>
 
 /**
  * \class TransferData
@@ -16,18 +17,107 @@ public:
     TransferData();
     ~TransferData();
 
-    std::shared_ptr<std::vector<VectorX>> getPoints() const;
+    /**
+     * \brief Get the trajectory the optimizer has built so far.
+     *
+     * The returned reference is a view into the optimizer's own storage, so it
+     * always reflects the latest appended point without any copying.
+     *
+     * \return The points visited during optimization, the current one last.
+     */
+    const std::vector<VectorX> &getPoints() const;
     const VectorX &getCurrPoint() const;
     const VectorX &getPrevPoint() const;
     std::shared_ptr<Function> getFunc() const;
     size_t getIterNum();
+    /**
+     * \brief Get the function value at the current point.
+     *
+     * The value is taken from the evaluation record of the current point and
+     * is calculated only if no record exists yet.
+     *
+     * \return The function value at the current point.
+     */
+    double getCurrValue();
+    /**
+     * \brief Get the function value at the previous point.
+     *
+     * \return The function value at the previous point.
+     */
+    double getPrevValue();
+    /**
+     * \brief Get the gradient at the current point.
+     *
+     * The gradient is calculated together with the value on first request and
+     * reused afterwards. The reference stays valid until the next evaluation
+     * record is created.
+     *
+     * \return The gradient at the current point.
+     */
+    const VectorX &getCurrGrad();
+    /**
+     * \brief Get the norm of the gradient at the current point, projected onto the bounds.
+     *
+     * Without bounds this is the norm of the gradient. With bounds it is the
+     * norm of P(x - g) - x, where P clamps onto the bounds, which vanishes at
+     * a minimum on a bound where the gradient itself does not.
+     *
+     * \return The norm of the projected gradient at the current point.
+     */
+    double getGradNorm();
 
+    /**
+     * \brief Attach the optimizer's trajectory.
+     *
+     * Only the address of the vector is stored. The caller keeps ownership and
+     * must keep the vector alive while the data is used; points appended later
+     * are seen through the view automatically.
+     *
+     * \param points The trajectory owned by the optimizer.
+     */
     void setPoints(const std::vector<VectorX> &points);
     void setFunc(const Function &f);
     void setIterNum(const size_t iter);
+    /**
+     * \brief Attach the bounds the optimizer keeps its points in.
+     *
+     * Only the address of the vector is stored, as for the trajectory.
+     *
+     * \param bounds The lower and upper bound of every coordinate.
+     */
+    void setBounds(const std::vector<std::pair<double, double>> &bounds);
+    /**
+     * \brief Record an evaluation of the current point made by the optimizer.
+     *
+     * Lets stop criteria reuse a value or gradient the optimizer has already
+     * calculated. Must be called after the point is appended to the trajectory.
+     *
+     * \param eval The evaluation of the current point.
+     */
+    void setCurrEval(const Evaluation &eval);
 
 private:
-    std::shared_ptr<std::vector<VectorX>> points;
+    const std::vector<VectorX> *points; ///< Non-owning view of the optimizer's trajectory.
+    const std::vector<std::pair<double, double>> *bounds; ///< Non-owning view of the bounds, null if there are none.
     std::shared_ptr<Function> func;
     size_t currIter;
+
+    /**
+     * \brief Find or calculate the evaluation record of a trajectory point.
+     *
+     * \param index The index of the point in the trajectory.
+     * \param wantGrad Whether the record must contain the gradient.
+     * \return The evaluation record of the point.
+     */
+    const Evaluation &evalAt(size_t index, bool wantGrad);
+    /**
+     * \brief Choose the record slot for a trajectory point.
+     *
+     * \param index The index of the point in the trajectory.
+     * \return The slot already holding the point, or the one to overwrite.
+     */
+    size_t slotFor(size_t index) const;
+
+    Evaluation evals[2];  ///< Evaluation records of the two most recent points.
+    size_t evalIndex[2];  ///< Trajectory indices the records belong to.
 };
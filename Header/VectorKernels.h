@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \struct AdamCoefficients
+ * \brief Per-step coefficients of the Adam update.
+ */
+struct AdamCoefficients
+{
+    double beta1;           ///< The decay rate for the first moment.
+    double beta2;           ///< The decay rate for the second moment.
+    double biasCorrection1; ///< 1 - beta1^t.
+    double biasCorrection2; ///< 1 - beta2^t.
+    double alpha;           ///< The learning rate.
+    double epsilon;         ///< Small constant to prevent division by zero.
+};
+
+/**
+ * \struct VectorKernels
+ * \brief Table of dense vector kernels for one instruction set.
+ *
+ * Implementations exist for plain scalar code, SSE2, AVX2 and AVX-512F. The
+ * widest one supported by the CPU and the operating system is selected once,
+ * on first use, from CPUID.
+ *
+ * Accuracy relative to the scalar table:
+ * - add, sub, scale, axpy and adamStep perform the same IEEE operations in
+ *   the same order for every element, without fused multiply-add, so their
+ *   results are bit-identical (0 ULP).
+ * - sumSquares accumulates in several lanes and adds them at the end. The
+ *   reordering keeps the result within (n - 1) ULP of the sequential sum, and
+ *   norm() within n / 2 + 1 ULP.
+ * - philoxUniform uses integer arithmetic and one exact subtraction, so its
+ *   results are bit-identical.
+ */
+struct VectorKernels
+{
+    const char *name; ///< The name of the instruction set.
+
+    /**
+     * \brief Sum of squares of x[0..n).
+     */
+    double (*sumSquares)(const double *x, size_t n);
+    /**
+     * \brief y[i] += x[i].
+     */
+    void (*add)(double *y, const double *x, size_t n);
+    /**
+     * \brief y[i] -= x[i].
+     */
+    void (*sub)(double *y, const double *x, size_t n);
+    /**
+     * \brief y[i] *= a.
+     */
+    void (*scale)(double *y, double a, size_t n);
+    /**
+     * \brief y[i] += x[i] * a.
+     */
+    void (*axpy)(double *y, double a, const double *x, size_t n);
+    /**
+     * \brief Fused Adam step: updates the moments m and v with the gradient g
+     * and moves x by the bias-corrected step.
+     */
+    void (*adamStep)(double *x, double *m, double *v, const double *g, size_t n, const AdamCoefficients &c);
+    /**
+     * \brief Philox4x32-10 blocks firstBlock, firstBlock + 1, ... of a stream,
+     * as two uniform numbers in [0, 1) per block written to u[0..2 * blocks).
+     */
+    void (*philoxUniform)(double *u, size_t blocks, uint64_t firstBlock, uint64_t stream, const uint32_t *key);
+};
+
+/**
+ * \brief Get the kernels selected for the running CPU.
+ *
+ * \return The fastest kernel table the CPU supports.
+ */
+const VectorKernels &vectorKernels();
+
+/**
+ * \brief Get every kernel table the running CPU supports.
+ *
+ * \return The tables from the widest instruction set to the scalar table,
+ * which is always last.
+ */
+std::vector<const VectorKernels *> supportedVectorKernels();
+
+/**
+ * \brief Get the portable scalar kernels.
+ *
+ * The scalar table is the reference the vectorized tables are measured
+ * against.
+ *
+ * \return The scalar kernel table.
+ */
+const VectorKernels &scalarVectorKernels();
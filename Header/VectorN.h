@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include "vectorX.h"
+
+/**
+ * \class VectorN
+ * \brief A stack-allocated vector of doubles with the dimension fixed at compile time.
+ *
+ * VectorN is the fixed-size counterpart of VectorX for low-dimensional
+ * problems. All loops run over the constant N, so the compiler unrolls them
+ * into register code; nothing is allocated, and only the
+ * initializer-list constructor checks its size.
+ *
+ * \tparam N The dimension of the vector.
+ */
+template <size_t N>
+class VectorN : public std::array<double, N>
+{
+public:
+    VectorN() : std::array<double, N>{} {}
+
+    /**
+     * \brief Construct the vector from its coordinates.
+     *
+     * \param values Exactly N coordinates.
+     * \throw std::invalid_argument If values does not hold N coordinates.
+     */
+    VectorN(std::initializer_list<double> values) : std::array<double, N>{}
+    {
+        if (values.size() != N)
+            throw std::invalid_argument("Input vector must have exactly " + std::to_string(N) + " elements.");
+        size_t i = 0;
+        for (double value : values)
+            (*this)[i++] = value;
+    }
+
+    /**
+     * \brief Copy the coordinates of a VectorX.
+     *
+     * The caller is responsible for x having exactly N elements.
+     *
+     * \param x The vector to copy.
+     */
+    explicit VectorN(const VectorX &x)
+    {
+        for (size_t i = 0; i < N; ++i)
+            (*this)[i] = x[i];
+    }
+
+    /**
+     * \brief Convert to a heap-allocated VectorX.
+     *
+     * \return A VectorX with the same coordinates.
+     */
+    VectorX toVectorX() const
+    {
+        return VectorX(this->begin(), this->end());
+    }
+
+    VectorN &operator+=(const VectorN &other)
+    {
+        for (size_t i = 0; i < N; ++i)
+            (*this)[i] += other[i];
+        return *this;
+    }
+
+    VectorN &operator-=(const VectorN &other)
+    {
+        for (size_t i = 0; i < N; ++i)
+            (*this)[i] -= other[i];
+        return *this;
+    }
+
+    VectorN &operator*=(double scalar)
+    {
+        for (size_t i = 0; i < N; ++i)
+            (*this)[i] *= scalar;
+        return *this;
+    }
+};
+
+template <size_t N>
+VectorN<N> operator+(VectorN<N> vec1, const VectorN<N> &vec2)
+{
+    return vec1 += vec2;
+}
+
+template <size_t N>
+VectorN<N> operator-(VectorN<N> vec1, const VectorN<N> &vec2)
+{
+    return vec1 -= vec2;
+}
+
+template <size_t N>
+VectorN<N> operator*(VectorN<N> vec, double scalar)
+{
+    return vec *= scalar;
+}
+
+template <size_t N>
+VectorN<N> operator*(double scalar, VectorN<N> vec)
+{
+    return vec *= scalar;
+}
+
+template <size_t N>
+double norm(const VectorN<N> &x)
+{
+    double norm = 0;
+    for (size_t i = 0; i < N; ++i)
+        norm += x[i] * x[i];
+    return sqrt(norm);
+}
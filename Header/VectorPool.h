@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+// Tells the compiler that a buffer from the pool aliases nothing else, as it
+// knows for operator new, so that copies into it are still vectorized.
+#if defined(_MSC_VER)
+#define VECTOR_POOL_MALLOC __declspec(restrict)
+#else
+#define VECTOR_POOL_MALLOC __attribute__((malloc))
+#endif
+
+/**
+ * \class VectorPoolScope
+ * \brief Recycles the buffers of VectorX on the calling thread while it exists.
+ *
+ * An optimization run creates and destroys vectors of the same few sizes on
+ * every iteration. While a scope is open, a freed buffer is kept on a free
+ * list of its thread instead of being returned to the heap, and the next
+ * allocation of the same size takes it back, so the iterations of a run do
+ * not touch the heap once the lists are warm. Scopes nest; the buffers left
+ * on the lists are released together when the outermost scope of the thread
+ * closes.
+ *
+ * A buffer may outlive the scope it was allocated in, and may be freed on
+ * another thread: every buffer comes from the heap, so it is either kept by
+ * the scope open on the freeing thread or returned to the heap.
+ */
+class VectorPoolScope
+{
+public:
+    VectorPoolScope();
+    ~VectorPoolScope();
+    VectorPoolScope(const VectorPoolScope &) = delete;
+    VectorPoolScope &operator=(const VectorPoolScope &) = delete;
+};
+
+/**
+ * \brief Get a buffer from the pool of the calling thread, or from the heap.
+ *
+ * Counts a reuse or a heap allocation in threadRunStats.
+ *
+ * \param bytes The size of the buffer.
+ * \return The buffer, aligned for any fundamental type.
+ * \throw std::bad_alloc If the heap is exhausted.
+ */
+VECTOR_POOL_MALLOC void *acquireVectorBuffer(size_t bytes);
+
+/**
+ * \brief Give a buffer back to the pool of the calling thread, or to the heap.
+ *
+ * \param buffer A buffer returned by acquireVectorBuffer().
+ * \param bytes The size it was acquired with.
+ */
+void releaseVectorBuffer(void *buffer, size_t bytes) noexcept;
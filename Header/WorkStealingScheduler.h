@@ -0,0 +1,66 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * \class WorkStealingScheduler
+ * \brief Runs a set of independent tasks on threads that steal each other's work.
+ *
+ * The tasks are dealt out to per-thread queues up front. A thread takes work
+ * from the back of its own queue and, once it runs dry, steals from the front
+ * of another thread's queue. A few very long tasks therefore do not leave the
+ * remaining threads idle while short tasks are still queued elsewhere.
+ */
+class WorkStealingScheduler
+{
+public:
+    /**
+     * \brief Constructor for WorkStealingScheduler.
+     *
+     * \param threads The number of threads; 0 selects the number of hardware threads.
+     */
+    explicit WorkStealingScheduler(size_t threads = 0);
+    ~WorkStealingScheduler();
+    /**
+     * \brief Execute all tasks and return when the last one has finished.
+     *
+     * A thread whose task throws runs no further tasks; the others go on and
+     * may steal its queued ones. Once every thread has stopped, the
+     * exception of the lowest-numbered failed thread is rethrown.
+     *
+     * \param tasks The tasks to execute.
+     * \throw Any exception thrown by a task.
+     */
+    void run(std::vector<std::function<void()>> &tasks);
+    /**
+     * \brief Get the number of threads.
+     *
+     * \return The number of threads used by run().
+     */
+    size_t getThreadsNum() const;
+
+private:
+    /**
+     * \struct WorkQueue
+     * \brief Indices of the tasks owned by one thread.
+     */
+    struct WorkQueue
+    {
+        std::mutex mutex;         ///< Guards tasks.
+        std::deque<size_t> tasks; ///< Indices of the queued tasks.
+    };
+
+    /**
+     * \brief Take the next task for a thread, stealing if its own queue is empty.
+     *
+     * \param self The index of the calling thread.
+     * \param task Receives the index of the task.
+     * \return False if no queue has work left.
+     */
+    bool next(size_t self, size_t &task);
+
+    size_t threads;                 ///< The number of threads.
+    std::vector<WorkQueue> queues; ///< One queue per thread.
+};
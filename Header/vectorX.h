@@ -3,6 +3,45 @@
 #include <vector>
 #include <iostream>
 #include <stdexcept>
+#include <cmath>
+#include <type_traits>
+#include "RunStats.h"
+
+class VectorX;
+
+template <typename E>
+class VectorScaled;
+
+/**
+ * \class VectorExpr
+ * \brief Base class of lazily evaluated vector expressions.
+ *
+ * Arithmetic on vectors builds a tree of expression nodes instead of
+ * allocating intermediate results. The tree is evaluated element by element
+ * in a single loop when it is assigned to a VectorX.
+ *
+ * \tparam E The derived expression type.
+ */
+template <typename E>
+class VectorExpr
+{
+public:
+    /**
+     * \brief Access the derived expression.
+     *
+     * \return A reference to the derived expression.
+     */
+    const E &self() const { return static_cast<const E &>(*this); }
+};
+
+/**
+ * \brief Storage of an expression operand.
+ *
+ * Vectors are held by reference, nested expressions by value, since they are
+ * temporaries that do not outlive the full expression.
+ */
+template <typename E>
+using VectorExprOperand = std::conditional_t<std::is_same_v<E, VectorX>, const VectorX &, const E>;
 
 /**
  * \class VectorX
@@ -10,27 +49,212 @@
  *
  * This class extends `std::vector<double>` to include vector arithmetic
  * operations such as addition, subtraction, and scalar multiplication.
+ * Storage comes from a CountingAllocator, so the allocations of a run show up
+ * in its RunStats, and is recycled while a VectorPoolScope is open.
  */
-class VectorX : public std::vector<double>
+class VectorX : public std::vector<double, CountingAllocator<double>>, public VectorExpr<VectorX>
 {
 public:
-    using std::vector<double>::vector;
+    using std::vector<double, CountingAllocator<double>>::vector;
+
+    VectorX() = default;
+
+    VectorX(const VectorX &other) = default;
+
+    VectorX(VectorX &&other) noexcept = default;
+
+    /**
+     * \brief Construct a vector by evaluating an expression.
+     *
+     * \param expr The expression to evaluate.
+     */
+    template <typename E>
+    VectorX(const VectorExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        resize(e.size());
+        for (size_t i = 0; i < size(); ++i)
+            (*this)[i] = e[i];
+    }
+
+    VectorX &operator=(const VectorX &other) = default;
+
+    VectorX &operator=(VectorX &&other) noexcept = default;
+
+    /**
+     * \brief Assign the result of an expression.
+     *
+     * The expression may refer to this vector, since every element only
+     * depends on the operand elements with the same index.
+     *
+     * \param expr The expression to evaluate.
+     * \return A reference to this vector.
+     */
+    template <typename E>
+    VectorX &operator=(const VectorExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        resize(e.size());
+        for (size_t i = 0; i < size(); ++i)
+            (*this)[i] = e[i];
+        return *this;
+    }
 
     VectorX &operator+=(const VectorX &other);
 
     VectorX &operator-=(const VectorX &other);
 
+    /**
+     * \brief Add a scaled vector in a single axpy pass.
+     */
+    VectorX &operator+=(const VectorScaled<VectorX> &scaled);
+
+    /**
+     * \brief Subtract a scaled vector in a single axpy pass.
+     */
+    VectorX &operator-=(const VectorScaled<VectorX> &scaled);
+
+    template <typename E>
+    VectorX &operator+=(const VectorExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        if (size() != e.size())
+            throw std::invalid_argument("Vectors must be of the same size.");
+
+        for (size_t i = 0; i < size(); ++i)
+            (*this)[i] += e[i];
+
+        return *this;
+    }
+
+    template <typename E>
+    VectorX &operator-=(const VectorExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        if (size() != e.size())
+            throw std::invalid_argument("Vectors must be of the same size.");
+
+        for (size_t i = 0; i < size(); ++i)
+            (*this)[i] -= e[i];
+
+        return *this;
+    }
+
     VectorX &operator*=(double scalar);
 
     friend std::ostream &operator<<(std::ostream &os, const VectorX &vec);
 };
 
-VectorX operator+(const VectorX &vec1, const VectorX &vec2);
+/**
+ * \class VectorSum
+ * \brief Expression node for the element-wise sum of two expressions.
+ */
+template <typename L, typename R>
+class VectorSum : public VectorExpr<VectorSum<L, R>>
+{
+public:
+    VectorSum(const L &l, const R &r) : l(l), r(r)
+    {
+        if (l.size() != r.size())
+            throw std::invalid_argument("Vectors must be of the same size.");
+    }
 
-VectorX operator-(const VectorX &vec1, const VectorX &vec2);
+    size_t size() const { return l.size(); }
 
-VectorX operator*(const VectorX &vec, double scalar);
+    double operator[](size_t i) const { return l[i] + r[i]; }
 
-VectorX operator*(double scalar, const VectorX &vec);
+private:
+    VectorExprOperand<L> l; ///< The left operand.
+    VectorExprOperand<R> r; ///< The right operand.
+};
+
+/**
+ * \class VectorDiff
+ * \brief Expression node for the element-wise difference of two expressions.
+ */
+template <typename L, typename R>
+class VectorDiff : public VectorExpr<VectorDiff<L, R>>
+{
+public:
+    VectorDiff(const L &l, const R &r) : l(l), r(r)
+    {
+        if (l.size() != r.size())
+            throw std::invalid_argument("Vectors must be of the same size.");
+    }
+
+    size_t size() const { return l.size(); }
+
+    double operator[](size_t i) const { return l[i] - r[i]; }
+
+private:
+    VectorExprOperand<L> l; ///< The left operand.
+    VectorExprOperand<R> r; ///< The right operand.
+};
+
+/**
+ * \class VectorScaled
+ * \brief Expression node for an expression multiplied by a scalar.
+ */
+template <typename E>
+class VectorScaled : public VectorExpr<VectorScaled<E>>
+{
+public:
+    VectorScaled(const E &e, double scalar) : e(e), scalar(scalar) {}
+
+    size_t size() const { return e.size(); }
+
+    double operator[](size_t i) const { return e[i] * scalar; }
+
+    const E &getOperand() const { return e; }
+
+    double getScalar() const { return scalar; }
+
+private:
+    VectorExprOperand<E> e; ///< The scaled expression.
+    double scalar;          ///< The scale factor.
+};
+
+template <typename L, typename R>
+VectorSum<L, R> operator+(const VectorExpr<L> &vec1, const VectorExpr<R> &vec2)
+{
+    return VectorSum<L, R>(vec1.self(), vec2.self());
+}
+
+template <typename L, typename R>
+VectorDiff<L, R> operator-(const VectorExpr<L> &vec1, const VectorExpr<R> &vec2)
+{
+    return VectorDiff<L, R>(vec1.self(), vec2.self());
+}
+
+template <typename E>
+VectorScaled<E> operator*(const VectorExpr<E> &vec, double scalar)
+{
+    return VectorScaled<E>(vec.self(), scalar);
+}
+
+template <typename E>
+VectorScaled<E> operator*(double scalar, const VectorExpr<E> &vec)
+{
+    return VectorScaled<E>(vec.self(), scalar);
+}
 
 double norm(const VectorX &x);
+
+/**
+ * \brief Euclidean norm of an expression, evaluated without a temporary vector.
+ *
+ * \param expr The expression.
+ * \return The norm of the expression.
+ */
+template <typename E>
+double norm(const VectorExpr<E> &expr)
+{
+    const E &e = expr.self();
+    double norm = 0;
+    for (size_t i = 0; i < e.size(); ++i)
+    {
+        double el = e[i];
+        norm += el * el;
+    }
+    return sqrt(norm);
+}
@@ -1,16 +1,20 @@
 ﻿#include "Area.h"
 
-Area::Area(const std::vector<std::pair<double, double>> &bounds) : bounds(bounds), dimension(bounds.size()), isRandInitialized(false)
+Area::Area() : dimension(0)
+{
+}
+
+Area::Area(const std::vector<std::pair<double, double>> &bounds) : bounds(bounds), dimension(bounds.size())
 {
 }
 
 Area::~Area() {}
 
-Area::Area(const Area &other) : bounds(other.bounds), dimension(other.dimension), isRandInitialized(false)
+Area::Area(const Area &other) : bounds(other.bounds), dimension(other.dimension)
 {
 }
 
-Area::Area(Area &&other) noexcept : bounds(std::move(other.bounds)), dimension(other.dimension), isRandInitialized(false)
+Area::Area(Area &&other) noexcept : bounds(std::move(other.bounds)), dimension(other.dimension)
 {
     other.dimension = 0;
 }
@@ -31,7 +35,6 @@ Area &Area::operator=(const Area &other)
 
     bounds = other.bounds;
     dimension = other.dimension;
-    isRandInitialized = other.isRandInitialized;
     return *this;
 }
 
@@ -43,12 +46,10 @@ Area &Area::operator=(Area &&other) noexcept
     bounds = std::move(other.bounds);
     dimension = other.dimension;
     other.dimension = 0;
-    isRandInitialized = other.isRandInitialized;
-    other.isRandInitialized = false;
     return *this;
 }
 
-std::vector<std::pair<double, double>> Area::getBounds() const
+const std::vector<std::pair<double, double>> &Area::getBounds() const
 {
     return bounds;
 }
@@ -69,23 +70,18 @@ bool Area::inArea(const VectorX &x) const
     return true;
 }
 
-void Area::genRandPoint(VectorX &x, std::mt19937 gen)
+void Area::genRandPoint(VectorX &x, RandomEngine &engine) const
 {
-    if (!isRandInitialized)
-    {
-        for (int i = 0; i < dimension; ++i)
-            dis.push_back(std::uniform_real_distribution<>(bounds[i].first, bounds[i].second));
-        isRandInitialized = true;
-    }
-    for (int i = 0; i < dimension; ++i)
-        x[i] = dis[i](gen);
+    double *u = x.data();
+    engine.nextPoint(u, dimension);
+    for (size_t i = 0; i < dimension; ++i)
+        u[i] = bounds[i].first + (bounds[i].second - bounds[i].first) * u[i];
 }
 
 void Area::change(const std::vector<std::pair<double, double>> &newBounds)
 {
     bounds = newBounds;
     dimension = bounds.size();
-    isRandInitialized = false;
 }
 
 void Neighborhood::change(double new_delta, const VectorX &x)
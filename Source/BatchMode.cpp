@@ -0,0 +1,360 @@
+#include "BatchMode.h"
+#include "ParsedFunction.h"
+#include "ScalableFunction.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <sstream>
+
+static std::vector<std::string> split(const std::string &text, char separator)
+{
+	std::vector<std::string> parts;
+	std::stringstream stream(text);
+	std::string part;
+	while (std::getline(stream, part, separator))
+		parts.push_back(part);
+	return parts;
+}
+
+static double toDouble(const std::string &text, const std::string &key)
+{
+	size_t pos = 0;
+	double value;
+	try
+	{
+		value = std::stod(text, &pos);
+	}
+	catch (const std::exception &)
+	{
+		pos = 0;
+	}
+	if (pos == 0 || pos != text.size())
+		throw std::invalid_argument("Field " + key + " is not a number: " + text);
+	return value;
+}
+
+static const std::string &field(const std::map<std::string, std::string> &fields, const std::string &key)
+{
+	auto it = fields.find(key);
+	if (it == fields.end())
+		throw std::invalid_argument("Missing field " + key + ".");
+	return it->second;
+}
+
+static double numberField(const std::map<std::string, std::string> &fields, const std::string &key)
+{
+	return toDouble(field(fields, key), key);
+}
+
+static std::shared_ptr<Function> makeFunction(const std::map<std::string, std::string> &fields)
+{
+	const std::string &id = field(fields, "function");
+	auto dim = fields.find("dim");
+	if (dim != fields.end())
+	{
+		double n = toDouble(dim->second, "dim");
+		if (n < 1 || n != std::floor(n))
+			throw std::invalid_argument("Field dim must be a positive integer.");
+		return makeScalableFunction(id, static_cast<size_t>(n));
+	}
+	if (id == "1")
+		return std::make_shared<Function1>();
+	if (id == "2")
+		return std::make_shared<Function2>();
+	if (id == "3")
+		return std::make_shared<Function3>();
+	if (id == "4")
+		return std::make_shared<Function4>();
+	if (id == "5")
+		return std::make_shared<Function5>();
+	if (id == "6")
+		return std::make_shared<Function6>();
+	throw std::invalid_argument("Unknown function " + id + ".");
+}
+
+static std::shared_ptr<StopCriteria> makeCriteria(const std::map<std::string, std::string> &fields)
+{
+	const std::string &id = field(fields, "criterion");
+	double eps = numberField(fields, "eps");
+	double maxIter = numberField(fields, "maxiter");
+	if (maxIter < 1)
+		throw std::invalid_argument("Field maxiter must be positive.");
+	if (id == "1" || id == "grad")
+		return std::make_shared<GradNormStopCriteria>(eps, static_cast<size_t>(maxIter));
+	if (id == "2" || id == "difference")
+		return std::make_shared<DifferenceNormStopCriteria>(eps, static_cast<size_t>(maxIter));
+	if (id == "3" || id == "funcdifference")
+		return std::make_shared<FuncDifferenceNormStopCriteria>(eps, static_cast<size_t>(maxIter));
+	throw std::invalid_argument("Unknown criterion " + id + ".");
+}
+
+static std::shared_ptr<LineSearch> makeLineSearch(const std::map<std::string, std::string> &fields)
+{
+	auto it = fields.find("linesearch");
+	if (it == fields.end() || it->second == "ternary")
+		return std::make_shared<TernaryLineSearch>();
+	if (it->second == "golden")
+		return std::make_shared<GoldenSectionLineSearch>();
+	if (it->second == "brent")
+		return std::make_shared<BrentLineSearch>();
+	if (it->second == "wolfe")
+		return std::make_shared<StrongWolfeLineSearch>();
+	throw std::invalid_argument("Unknown line search " + it->second + ".");
+}
+
+template <typename F>
+static std::shared_ptr<OptimizationMethod> makeFixedAdam(const std::map<std::string, std::string> &fields)
+{
+	return std::make_shared<FixedAdamGradientDescent<F>>(numberField(fields, "alpha"), numberField(fields, "beta1"),
+														 numberField(fields, "beta2"), numberField(fields, "epsilon"));
+}
+
+static std::shared_ptr<OptimizationMethod> makeFixedAdam(const std::map<std::string, std::string> &fields)
+{
+	auto function = fields.find("function");
+	if (function == fields.end() || fields.count("dim"))
+		throw std::invalid_argument("Method fixedadam needs one of the functions 1-6.");
+	if (function->second == "1")
+		return makeFixedAdam<Function1>(fields);
+	if (function->second == "2")
+		return makeFixedAdam<Function2>(fields);
+	if (function->second == "3")
+		return makeFixedAdam<Function3>(fields);
+	if (function->second == "4")
+		return makeFixedAdam<Function4>(fields);
+	if (function->second == "5")
+		return makeFixedAdam<Function5>(fields);
+	if (function->second == "6")
+		return makeFixedAdam<Function6>(fields);
+	throw std::invalid_argument("Method fixedadam needs one of the functions 1-6.");
+}
+
+static std::shared_ptr<OptimizationMethod> makeMethod(const std::map<std::string, std::string> &fields)
+{
+	const std::string &id = field(fields, "method");
+	if (id == "1" || id == "adam")
+		return std::make_shared<AdamGradientDescent>(numberField(fields, "alpha"), numberField(fields, "beta1"),
+													 numberField(fields, "beta2"), numberField(fields, "epsilon"));
+	if (id == "2" || id == "classic")
+		return std::make_shared<ClassicGradientDescent>(makeLineSearch(fields));
+	if (id == "3" || id == "random")
+	{
+		auto method = std::make_shared<RandomSearch>(numberField(fields, "alpha"), numberField(fields, "p"), numberField(fields, "delta"));
+		auto it = fields.find("sampling");
+		if (it != fields.end())
+			method->setSampling(parseSampling(it->second));
+		return method;
+	}
+	if (id == "4" || id == "lbfgsb")
+	{
+		double memory = numberField(fields, "memory");
+		if (memory < 1)
+			throw std::invalid_argument("Field memory must be positive.");
+		return std::make_shared<LBFGSB>(static_cast<size_t>(memory));
+	}
+	if (id == "5" || id == "newtoncg")
+		return std::make_shared<NewtonCG>();
+	if (id == "6" || id == "fixedadam")
+		return makeFixedAdam(fields);
+	throw std::invalid_argument("Unknown method " + id + ".");
+}
+
+/**
+ * \brief Passes the iterations of a batch job to its tracer and histogram.
+ */
+class JobObserver : public IterationObserver
+{
+public:
+	JobObserver(std::ostream &os, size_t traceEvery, bool histogram)
+	{
+		if (traceEvery)
+			tracer = std::make_unique<SampledTracer>(os, traceEvery);
+		if (histogram)
+			this->histogram = std::make_unique<PhaseHistogram>();
+	}
+	void onIteration(const IterationInfo &info) override
+	{
+		if (tracer)
+			tracer->onIteration(info);
+		if (histogram)
+			histogram->onIteration(info);
+	}
+	/**
+	 * \brief Print the histogram, if one is collected.
+	 */
+	void print(std::ostream &os) const
+	{
+		if (histogram)
+			histogram->print(os);
+	}
+
+private:
+	std::unique_ptr<SampledTracer> tracer;	   ///< The tracer, null if not requested.
+	std::unique_ptr<PhaseHistogram> histogram; ///< The histogram, null if not requested.
+};
+
+BatchJob parseBatchJob(const std::string &text, size_t line)
+{
+	std::map<std::string, std::string> fields;
+	std::stringstream stream(text);
+	std::string token;
+	while (stream >> token)
+	{
+		size_t eq = token.find('=');
+		if (eq == std::string::npos || eq == 0)
+			throw std::invalid_argument("Expected key=value, got " + token + ".");
+		fields[token.substr(0, eq)] = token.substr(eq + 1);
+	}
+
+	BatchJob job;
+	job.line = line;
+	auto formula = fields.find("formula");
+	if (formula != fields.end() && fields.count("function"))
+		throw std::invalid_argument("Fields function and formula are mutually exclusive.");
+	job.f = formula != fields.end() ? std::make_shared<ParsedFunction>(formula->second) : makeFunction(fields);
+	size_t dim = job.f->getDim();
+
+	std::vector<std::pair<double, double>> bounds;
+	for (const std::string &interval : split(field(fields, "bounds"), ','))
+	{
+		std::vector<std::string> ends = split(interval, ':');
+		if (ends.size() != 2)
+			throw std::invalid_argument("Bounds must be given as min:max, got " + interval + ".");
+		double min = toDouble(ends[0], "bounds");
+		double max = toDouble(ends[1], "bounds");
+		if (min >= max)
+			throw std::invalid_argument("Bound min must be less than max, got " + interval + ".");
+		bounds.emplace_back(min, max);
+	}
+	if (bounds.size() == 1)
+		bounds.resize(dim, bounds[0]);
+	if (bounds.size() != dim)
+		throw std::invalid_argument("Expected " + std::to_string(dim) + " bounds, got " + std::to_string(bounds.size()) + ".");
+	job.area = Area(bounds);
+
+	for (const std::string &coord : split(field(fields, "start"), ','))
+		job.startPoint.push_back(toDouble(coord, "start"));
+	if (job.startPoint.size() == 1)
+		job.startPoint.resize(dim, job.startPoint[0]);
+	if (job.startPoint.size() != dim)
+		throw std::invalid_argument("Expected " + std::to_string(dim) + " start coordinates, got " + std::to_string(job.startPoint.size()) + ".");
+	if (!job.area.inArea(job.startPoint))
+		throw std::invalid_argument("Start point is outside the bounds.");
+
+	job.criteria = makeCriteria(fields);
+	job.method = makeMethod(fields);
+
+	auto trace = fields.find("trace");
+	if (trace != fields.end())
+	{
+		double every = toDouble(trace->second, "trace");
+		if (every < 1 || every != std::floor(every))
+			throw std::invalid_argument("Field trace must be a positive integer.");
+		job.traceEvery = static_cast<size_t>(every);
+	}
+	auto histogram = fields.find("histogram");
+	if (histogram != fields.end())
+	{
+		if (histogram->second != "0" && histogram->second != "1")
+			throw std::invalid_argument("Field histogram must be 0 or 1.");
+		job.histogram = histogram->second == "1";
+	}
+	return job;
+}
+
+int runBatch(std::istream &jobs, std::ostream &results, size_t threads, std::ostream &traces)
+{
+	SweepTable table(results);
+	std::mutex resultMutex;
+	bool failed = false;
+	auto report = [&](const SweepResult &result)
+	{
+		std::lock_guard<std::mutex> lock(resultMutex);
+		failed = failed || !result.error.empty();
+		table.write(result);
+	};
+
+	std::vector<BatchJob> parsed;
+	std::string text;
+	for (size_t line = 1; std::getline(jobs, text); ++line)
+	{
+		text = text.substr(0, text.find('#'));
+		if (text.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+		try
+		{
+			parsed.push_back(parseBatchJob(text, line));
+		}
+		catch (const std::exception &exc)
+		{
+			report({line, "", "", "", VectorX(), VectorX(), 0, 0, 0, exc.what()});
+		}
+	}
+
+	std::vector<std::function<void()>> tasks;
+	tasks.reserve(parsed.size());
+	for (BatchJob &job : parsed)
+	{
+		tasks.push_back([&job, &report, &resultMutex, &traces]
+						{
+			SweepResult result{job.line, job.f->getName(), job.method->getName(), job.criteria->getName(), job.startPoint, VectorX(), 0, 0, 0, ""};
+			bool observed = job.traceEvery || job.histogram;
+			std::ostringstream trace;
+			JobObserver observer(trace, job.traceEvery, job.histogram);
+			if (observed)
+				job.method->setObserver(&observer);
+			try
+			{
+				auto start = std::chrono::steady_clock::now();
+				job.method->optimise(job.startPoint, job.area, *job.f, *job.criteria);
+				auto end = std::chrono::steady_clock::now();
+				result.bestPoint = job.method->getBestPoint();
+				result.value = (*job.f)(result.bestPoint);
+				result.iterNum = job.method->getIterNum();
+				result.seconds = std::chrono::duration<double>(end - start).count();
+			}
+			catch (const std::exception &exc)
+			{
+				result.error = exc.what();
+			}
+			if (observed)
+			{
+				job.method->setObserver(nullptr);
+				observer.print(trace);
+				std::lock_guard<std::mutex> lock(resultMutex);
+				traces << "# job " << job.line << "\n" << trace.str() << std::flush;
+			}
+			report(result); });
+	}
+	WorkStealingScheduler scheduler(threads);
+	scheduler.run(tasks);
+	return failed ? 1 : 0;
+}
+
+int runSweep(std::ostream &results, size_t startsNum, size_t threads)
+{
+	Sweep sweep;
+	sweep.addFunction(std::make_shared<Function1>(), Area({{-2, 2}, {-2, 2}}));
+	sweep.addFunction(std::make_shared<Function2>(), Area({{-2, 2}, {-2, 2}, {-2, 2}}));
+	sweep.addFunction(std::make_shared<Function3>(), Area({{-3, 3}, {-3, 3}}));
+	sweep.addFunction(std::make_shared<Function4>(), Area({{-2, 2}, {-2, 2}}));
+	sweep.addFunction(std::make_shared<Function5>(), Area({{-2, 2}, {-2, 2}, {-2, 2}, {-2, 2}}));
+	sweep.addFunction(std::make_shared<Function6>(), Area({{-3, 3}, {-3, 3}}));
+	sweep.addMethod(std::make_shared<AdamGradientDescent>(0.01, 0.9, 0.999, 1e-8));
+	sweep.addMethod(std::make_shared<ClassicGradientDescent>());
+	sweep.addMethod(std::make_shared<RandomSearch>(0.9, 0.5, 1));
+	sweep.addMethod(std::make_shared<LBFGSB>());
+	sweep.addMethod(std::make_shared<NewtonCG>());
+	sweep.addCriteria(std::make_shared<GradNormStopCriteria>(1e-6, 10000));
+	sweep.addCriteria(std::make_shared<DifferenceNormStopCriteria>(1e-6, 10000));
+	sweep.addCriteria(std::make_shared<FuncDifferenceNormStopCriteria>(1e-6, 10000));
+	sweep.setStarts(startsNum, 228, Sampling::ScrambledSobol);
+
+	SweepTable table(results);
+	bool failed = false;
+	sweep.run(threads, [&](const SweepResult &result)
+			  {
+		failed = failed || !result.error.empty();
+		table.write(result); });
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,317 @@
+#include "FiniteDifferenceFunction.h"
+#include <exception>
+#include <latch>
+#include <limits>
+
+/**
+ * \brief Run body over [0, count), split between the calling thread and a pool.
+ *
+ * The calling thread takes the first chunk and then waits for the others, so
+ * a pool of p threads runs p + 1 chunks at once. The first exception thrown
+ * by any chunk is rethrown after all of them have finished.
+ *
+ * \param pool The pool, or null to run everything on the calling thread.
+ * \param count The number of items.
+ * \param body Called with the bounds [begin, end) of a chunk.
+ */
+static void forEachChunk(ThreadPool *pool, size_t count, const std::function<void(size_t begin, size_t end)> &body)
+{
+    size_t chunks = pool ? std::min(count, pool->getThreadsNum() + 1) : 1;
+    if (chunks <= 1)
+    {
+        body(0, count);
+        return;
+    }
+    std::vector<std::exception_ptr> errors(chunks);
+    std::latch done(static_cast<std::ptrdiff_t>(chunks - 1));
+    for (size_t c = 1; c < chunks; ++c)
+    {
+        pool->submit([&, c]
+                     {
+            try
+            {
+                body(c * count / chunks, (c + 1) * count / chunks);
+            }
+            catch (...)
+            {
+                errors[c] = std::current_exception();
+            }
+            done.count_down(); });
+    }
+    try
+    {
+        body(0, count / chunks);
+    }
+    catch (...)
+    {
+        errors[0] = std::current_exception();
+    }
+    done.wait();
+    for (const std::exception_ptr &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+/**
+ * \brief Check the arguments shared by the constructors.
+ */
+static void checkArguments(size_t dim, bool hasFormula, DifferenceScheme scheme)
+{
+    if (dim == 0)
+        throw std::invalid_argument("Dimension must be positive.");
+    if (!hasFormula)
+        throw std::invalid_argument("Formula must not be empty.");
+    if (scheme == DifferenceScheme::ComplexStep)
+        throw std::invalid_argument("The complex step requires a formula of complex arguments.");
+}
+
+FiniteDifferenceFunction::FiniteDifferenceFunction(const std::string &name, size_t dim, Formula formula, DifferenceScheme scheme)
+    : formula(std::move(formula)), scheme(scheme), relativeStep(0.0)
+{
+    checkArguments(dim, static_cast<bool>(this->formula), scheme);
+    dimension = dim;
+    this->name = name;
+}
+
+FiniteDifferenceFunction::FiniteDifferenceFunction(const std::string &name, size_t dim, BatchFormula formula, DifferenceScheme scheme)
+    : batchFormula(std::move(formula)), scheme(scheme), relativeStep(0.0)
+{
+    checkArguments(dim, static_cast<bool>(batchFormula), scheme);
+    dimension = dim;
+    this->name = name;
+}
+
+FiniteDifferenceFunction::FiniteDifferenceFunction(const std::string &name, size_t dim, ComplexFormula formula)
+    : complexFormula(std::move(formula)), scheme(DifferenceScheme::ComplexStep), relativeStep(0.0)
+{
+    checkArguments(dim, static_cast<bool>(complexFormula), DifferenceScheme::Central);
+    dimension = dim;
+    this->name = name;
+}
+
+FiniteDifferenceFunction::~FiniteDifferenceFunction()
+{
+}
+
+void FiniteDifferenceFunction::setThreadPool(std::shared_ptr<ThreadPool> pool)
+{
+    this->pool = std::move(pool);
+}
+
+void FiniteDifferenceFunction::setRelativeStep(double relativeStep)
+{
+    if (relativeStep < 0.0)
+        throw std::invalid_argument("Relative step must not be negative.");
+    this->relativeStep = relativeStep;
+}
+
+DifferenceScheme FiniteDifferenceFunction::getScheme() const
+{
+    return scheme;
+}
+
+double FiniteDifferenceFunction::step(double xi) const
+{
+    double relative = relativeStep;
+    if (relative == 0.0)
+    {
+        constexpr double eps = std::numeric_limits<double>::epsilon();
+        switch (scheme)
+        {
+        case DifferenceScheme::Forward:
+            relative = std::sqrt(eps);
+            break;
+        case DifferenceScheme::Central:
+            relative = std::cbrt(eps);
+            break;
+        case DifferenceScheme::ComplexStep:
+            relative = 1e-20;
+            break;
+        }
+    }
+    double h = relative * std::max(std::abs(xi), 1.0);
+    if (scheme == DifferenceScheme::ComplexStep)
+        return h;
+    // Differentiate with the step actually taken, not the one requested.
+    double shifted = xi + h;
+    return shifted - xi;
+}
+
+void FiniteDifferenceFunction::evaluatePoints(const PointBatch &points, double *values) const
+{
+    size_t count = points.getCount();
+    if (batchFormula)
+    {
+        batchFormula(points, values);
+        return;
+    }
+    forEachChunk(pool.get(), count, [&](size_t begin, size_t end)
+                 {
+        VectorX x(dimension);
+        for (size_t k = begin; k < end; ++k)
+        {
+            for (size_t d = 0; d < dimension; ++d)
+                x[d] = points.coord(d)[k];
+            values[k] = formula(x);
+        } });
+}
+
+VectorX FiniteDifferenceFunction::complexStepGrad(const VectorX &x, double *value) const
+{
+    VectorX grad(dimension);
+    size_t count = dimension + (value ? 1 : 0);
+    // The value, if asked for, is counted by the caller of the function.
+    threadRunStats.valueCalls += dimension;
+    forEachChunk(pool.get(), count, [&](size_t begin, size_t end)
+                 {
+        std::vector<std::complex<double>> z(x.begin(), x.end());
+        for (size_t k = begin; k < end; ++k)
+        {
+            if (k == dimension)
+            {
+                *value = complexFormula(z).real();
+                continue;
+            }
+            double h = step(x[k]);
+            z[k] = std::complex<double>(x[k], h);
+            grad[k] = complexFormula(z).imag() / h;
+            z[k] = x[k];
+        } });
+    return grad;
+}
+
+void FiniteDifferenceFunction::differences(const PointBatch &points, double *values, PointBatch &grads) const
+{
+    size_t n = dimension;
+    size_t m = points.getCount();
+    grads.resize(n, m);
+    if (scheme == DifferenceScheme::ComplexStep)
+    {
+        for (size_t k = 0; k < m; ++k)
+        {
+            VectorX grad = complexStepGrad(points.getPoint(k), values ? values + k : nullptr);
+            for (size_t d = 0; d < n; ++d)
+                grads.coord(d)[k] = grad[d];
+        }
+        return;
+    }
+
+    // Each point expands into a block of the stencil: the point itself if
+    // needed, x + h e_i for every i and, for central differences, x - h e_i.
+    bool central = scheme == DifferenceScheme::Central;
+    bool withBase = values || !central;
+    size_t plus = withBase ? 1 : 0;
+    size_t minus = plus + n;
+    size_t block = plus + (central ? 2 : 1) * n;
+    PointBatch stencil(n, m * block);
+    PointBatch steps(n, m);
+    for (size_t d = 0; d < n; ++d)
+    {
+        const double *x = points.coord(d);
+        double *coord = stencil.coord(d);
+        double *h = steps.coord(d);
+        for (size_t k = 0; k < m; ++k)
+        {
+            double *first = coord + k * block;
+            std::fill(first, first + block, x[k]);
+            h[k] = step(x[k]);
+            first[plus + d] += h[k];
+            if (central)
+                first[minus + d] -= h[k];
+        }
+    }
+    std::vector<double> stencilValues(m * block);
+    evaluatePoints(stencil, stencilValues.data());
+    // The values asked for are counted by the caller of the function.
+    threadRunStats.valueCalls += m * block - (values ? m : 0);
+
+    for (size_t d = 0; d < n; ++d)
+    {
+        const double *h = steps.coord(d);
+        double *grad = grads.coord(d);
+        for (size_t k = 0; k < m; ++k)
+        {
+            const double *f = stencilValues.data() + k * block;
+            if (central)
+                grad[k] = (f[plus + d] - f[minus + d]) / (2.0 * h[k]);
+            else
+                grad[k] = (f[plus + d] - f[0]) / h[k];
+        }
+    }
+    if (values)
+    {
+        for (size_t k = 0; k < m; ++k)
+            values[k] = stencilValues[k * block];
+    }
+}
+
+double FiniteDifferenceFunction::differentiate(const VectorX &x, VectorX *grad, bool wantValue) const
+{
+    if (x.size() != dimension)
+    {
+        throw std::invalid_argument("Input vector must have exactly " + std::to_string(dimension) + " elements.");
+    }
+    double value = 0.0;
+    if (grad)
+    {
+        PointBatch point(dimension, 1), pointGrad;
+        point.setPoint(0, x);
+        differences(point, wantValue ? &value : nullptr, pointGrad);
+        *grad = pointGrad.getPoint(0);
+        return value;
+    }
+    if (formula)
+        return formula(x);
+    if (complexFormula)
+        return complexFormula(std::vector<std::complex<double>>(x.begin(), x.end())).real();
+    PointBatch point(dimension, 1);
+    point.setPoint(0, x);
+    evaluatePoints(point, &value);
+    return value;
+}
+
+double FiniteDifferenceFunction::calcValue(const VectorX &x) const
+{
+    return differentiate(x, nullptr, true);
+}
+
+VectorX FiniteDifferenceFunction::calcGrad(const VectorX &x) const
+{
+    VectorX g;
+    differentiate(x, &g, false);
+    return g;
+}
+
+Evaluation FiniteDifferenceFunction::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+    Evaluation eval;
+    eval.value = differentiate(x, wantGrad ? &eval.grad : nullptr, true);
+    return eval;
+}
+
+void FiniteDifferenceFunction::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+    if (points.getDim() != dimension)
+    {
+        throw std::invalid_argument("Points of the batch must have exactly " + std::to_string(dimension) + " elements.");
+    }
+    if (grads)
+    {
+        differences(points, values, *grads);
+        return;
+    }
+    if (complexFormula)
+    {
+        for (size_t k = 0; k < points.getCount(); ++k)
+            values[k] = differentiate(points.getPoint(k), nullptr, true);
+        return;
+    }
+    evaluatePoints(points, values);
+}
+
+std::shared_ptr<Function> FiniteDifferenceFunction::clone() const
+{
+    return std::make_shared<FiniteDifferenceFunction>(*this);
+}
@@ -1,24 +1,88 @@
 #include "Function.h"
+#include <limits>
 
-double Function1::operator()(const VectorX &x) const
+Evaluation Function::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+	Evaluation eval{calcValue(x), VectorX()};
+	if (wantGrad)
+		eval.grad = calcGrad(x);
+	return eval;
+}
+
+VectorX Function::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+	if (v.size() != x.size())
+	{
+		throw std::invalid_argument("Vector must have the dimension of the point.");
+	}
+	double vNorm = norm(v);
+	if (vNorm == 0)
+		return VectorX(x.size(), 0.0);
+	// The cube root of the machine epsilon balances the truncation error of
+	// the central difference against the rounding error of the gradients.
+	double h = std::cbrt(std::numeric_limits<double>::epsilon()) * (1 + norm(x)) / vNorm;
+	VectorX hv = grad(x + h * v);
+	hv -= grad(x - h * v);
+	hv *= 1 / (2 * h);
+	return hv;
+}
+
+void Function::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+	if (grads)
+		grads->resize(points.getDim(), points.getCount());
+	for (size_t k = 0; k < points.getCount(); ++k)
+	{
+		Evaluation eval = calcEvaluation(points.getPoint(k), grads != nullptr);
+		values[k] = eval.value;
+		if (grads)
+			grads->setPoint(k, eval.grad);
+	}
+}
+
+double Function1::calcValue(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	return pow(x[0], 2) * sin(x[1]);
+	return (*this)(VectorN<Dim>(x));
 }
 
-VectorX Function1::grad(const VectorX &x) const
+VectorX Function1::calcGrad(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	VectorX grad(dimension);
-	grad[0] = 2 * x[0] * sin(x[1]);
-	grad[1] = pow(x[0], 2) * cos(x[1]);
-	return grad;
+	return grad(VectorN<Dim>(x)).toVectorX();
+}
+
+Evaluation Function1::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+	if (x.size() != dimension)
+	{
+		throw std::invalid_argument("Input vector must have exactly 2 elements.");
+	}
+	if (!wantGrad)
+		return {(*this)(VectorN<Dim>(x)), VectorX()};
+	VectorN<Dim> grad;
+	double value = evaluate(VectorN<Dim>(x), grad);
+	return {value, grad.toVectorX()};
+}
+
+VectorX Function1::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+	if (x.size() != dimension || v.size() != dimension)
+	{
+		throw std::invalid_argument("Input vectors must have exactly 2 elements.");
+	}
+	return hessVec(VectorN<Dim>(x), VectorN<Dim>(v)).toVectorX();
+}
+
+void Function1::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+	evaluateBatchFixed(*this, points, values, grads);
 }
 
 std::shared_ptr<Function> Function1::clone() const
@@ -26,26 +90,49 @@ std::shared_ptr<Function> Function1::clone() const
 	return std::make_shared<Function1>(*this);
 }
 
-double Function2::operator()(const VectorX &x) const
+double Function2::calcValue(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 3 elements.");
 	}
-	return sin(x[0]) * cos(x[1]) * sin(x[2]);
+	return (*this)(VectorN<Dim>(x));
 }
 
-VectorX Function2::grad(const VectorX &x) const
+VectorX Function2::calcGrad(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 3 elements.");
 	}
-	VectorX grad(dimension);
-	grad[0] = cos(x[0]) * cos(x[1]) * sin(x[2]);
-	grad[1] = -sin(x[0]) * sin(x[1]) * sin(x[2]);
-	grad[1] = sin(x[0]) * cos(x[1]) * cos(x[2]);
-	return grad;
+	return grad(VectorN<Dim>(x)).toVectorX();
+}
+
+Evaluation Function2::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+	if (x.size() != dimension)
+	{
+		throw std::invalid_argument("Input vector must have exactly 3 elements.");
+	}
+	if (!wantGrad)
+		return {(*this)(VectorN<Dim>(x)), VectorX()};
+	VectorN<Dim> grad;
+	double value = evaluate(VectorN<Dim>(x), grad);
+	return {value, grad.toVectorX()};
+}
+
+VectorX Function2::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+	if (x.size() != dimension || v.size() != dimension)
+	{
+		throw std::invalid_argument("Input vectors must have exactly 3 elements.");
+	}
+	return hessVec(VectorN<Dim>(x), VectorN<Dim>(v)).toVectorX();
+}
+
+void Function2::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+	evaluateBatchFixed(*this, points, values, grads);
 }
 
 std::shared_ptr<Function> Function2::clone() const
@@ -53,25 +140,49 @@ std::shared_ptr<Function> Function2::clone() const
 	return std::make_shared<Function2>(*this);
 }
 
-double Function3::operator()(const VectorX &x) const
+double Function3::calcValue(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	return pow(0.1 * x[0] - x[1], 4) + pow(x[1], 2);
+	return (*this)(VectorN<Dim>(x));
 }
 
-VectorX Function3::grad(const VectorX &x) const
+VectorX Function3::calcGrad(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	VectorX grad(dimension);
-	grad[0] = 0.4 * pow(0.1 * x[0] - x[1], 3);
-	grad[1] = -4 * pow(0.1 * x[0] - x[1], 3) + 2 * x[1];
-	return grad;
+	return grad(VectorN<Dim>(x)).toVectorX();
+}
+
+Evaluation Function3::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+	if (x.size() != dimension)
+	{
+		throw std::invalid_argument("Input vector must have exactly 2 elements.");
+	}
+	if (!wantGrad)
+		return {(*this)(VectorN<Dim>(x)), VectorX()};
+	VectorN<Dim> grad;
+	double value = evaluate(VectorN<Dim>(x), grad);
+	return {value, grad.toVectorX()};
+}
+
+VectorX Function3::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+	if (x.size() != dimension || v.size() != dimension)
+	{
+		throw std::invalid_argument("Input vectors must have exactly 2 elements.");
+	}
+	return hessVec(VectorN<Dim>(x), VectorN<Dim>(v)).toVectorX();
+}
+
+void Function3::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+	evaluateBatchFixed(*this, points, values, grads);
 }
 
 std::shared_ptr<Function> Function3::clone() const
@@ -79,25 +190,49 @@ std::shared_ptr<Function> Function3::clone() const
 	return std::make_shared<Function3>(*this);
 }
 
-double Function4::operator()(const VectorX &x) const
+double Function4::calcValue(const VectorX &x) const
+{
+	if (x.size() != dimension)
+	{
+		throw std::invalid_argument("Input vector must have exactly 2 elements.");
+	}
+	return (*this)(VectorN<Dim>(x));
+}
+
+VectorX Function4::calcGrad(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	return pow(1 - x[0], 2) + 100 * pow(x[1] - x[0] * x[0], 2);
+	return grad(VectorN<Dim>(x)).toVectorX();
 }
 
-VectorX Function4::grad(const VectorX &x) const
+Evaluation Function4::calcEvaluation(const VectorX &x, bool wantGrad) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	VectorX grad(dimension);
-	grad[0] = 2 * (200 * pow(x[0], 3) - 200 * x[0] * x[1] + x[0] - 1);
-	grad[1] = 200 * (x[1] - pow(x[0], 2));
-	return grad;
+	if (!wantGrad)
+		return {(*this)(VectorN<Dim>(x)), VectorX()};
+	VectorN<Dim> grad;
+	double value = evaluate(VectorN<Dim>(x), grad);
+	return {value, grad.toVectorX()};
+}
+
+VectorX Function4::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+	if (x.size() != dimension || v.size() != dimension)
+	{
+		throw std::invalid_argument("Input vectors must have exactly 2 elements.");
+	}
+	return hessVec(VectorN<Dim>(x), VectorN<Dim>(v)).toVectorX();
+}
+
+void Function4::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+	evaluateBatchFixed(*this, points, values, grads);
 }
 
 std::shared_ptr<Function> Function4::clone() const
@@ -105,27 +240,49 @@ std::shared_ptr<Function> Function4::clone() const
 	return std::make_shared<Function4>(*this);
 }
 
-double Function5::operator()(const VectorX &x) const
+double Function5::calcValue(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 4 elements.");
 	}
-	return 100 * pow(x[0] * x[0] - x[1], 2) + pow(x[0] - 1, 2) + 100 * pow(x[2] * x[2] - x[3], 2) + pow(x[2] - 1, 2);
+	return (*this)(VectorN<Dim>(x));
 }
 
-VectorX Function5::grad(const VectorX &x) const
+VectorX Function5::calcGrad(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 4 elements.");
 	}
-	VectorX grad(dimension);
-	grad[0] = 2 * (200 * x[0] * (x[0] * x[0] - x[1]) + x[0] - 1);
-	grad[1] = 200 * (x[1] - pow(x[0], 2));
-	grad[2] = 2 * (200 * x[2] * (x[2] * x[2] - x[3]) + x[2] - 1);
-	grad[3] = 200 * (x[3] - x[2] * x[2]);
-	return grad;
+	return grad(VectorN<Dim>(x)).toVectorX();
+}
+
+Evaluation Function5::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+	if (x.size() != dimension)
+	{
+		throw std::invalid_argument("Input vector must have exactly 4 elements.");
+	}
+	if (!wantGrad)
+		return {(*this)(VectorN<Dim>(x)), VectorX()};
+	VectorN<Dim> grad;
+	double value = evaluate(VectorN<Dim>(x), grad);
+	return {value, grad.toVectorX()};
+}
+
+VectorX Function5::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+	if (x.size() != dimension || v.size() != dimension)
+	{
+		throw std::invalid_argument("Input vectors must have exactly 4 elements.");
+	}
+	return hessVec(VectorN<Dim>(x), VectorN<Dim>(v)).toVectorX();
+}
+
+void Function5::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+	evaluateBatchFixed(*this, points, values, grads);
 }
 
 std::shared_ptr<Function> Function5::clone() const
@@ -133,25 +290,49 @@ std::shared_ptr<Function> Function5::clone() const
 	return std::make_shared<Function5>(*this);
 }
 
-double Function6::operator()(const VectorX &x) const
+double Function6::calcValue(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	return x[0] * x[0] + x[1] * x[1];
+	return (*this)(VectorN<Dim>(x));
 }
 
-VectorX Function6::grad(const VectorX &x) const
+VectorX Function6::calcGrad(const VectorX &x) const
 {
 	if (x.size() != dimension)
 	{
 		throw std::invalid_argument("Input vector must have exactly 2 elements.");
 	}
-	VectorX grad(dimension);
-	grad[0] = 2 * x[0];
-	grad[1] = 2 * x[1];
-	return grad;
+	return grad(VectorN<Dim>(x)).toVectorX();
+}
+
+Evaluation Function6::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+	if (x.size() != dimension)
+	{
+		throw std::invalid_argument("Input vector must have exactly 2 elements.");
+	}
+	if (!wantGrad)
+		return {(*this)(VectorN<Dim>(x)), VectorX()};
+	VectorN<Dim> grad;
+	double value = evaluate(VectorN<Dim>(x), grad);
+	return {value, grad.toVectorX()};
+}
+
+VectorX Function6::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+	if (x.size() != dimension || v.size() != dimension)
+	{
+		throw std::invalid_argument("Input vectors must have exactly 2 elements.");
+	}
+	return hessVec(VectorN<Dim>(x), VectorN<Dim>(v)).toVectorX();
+}
+
+void Function6::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+	evaluateBatchFixed(*this, points, values, grads);
 }
 
 std::shared_ptr<Function> Function6::clone() const
@@ -0,0 +1,92 @@
+#include "IterationObserver.h"
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+static const char *const phaseNames[iterationPhasesNum] = {"evaluation", "line search", "criteria", "other"};
+
+IterationObserver::~IterationObserver()
+{
+}
+
+SampledTracer::SampledTracer(std::ostream &os, size_t every) : os(os), every(every)
+{
+    if (every == 0)
+        throw std::invalid_argument("Sampling period must be positive.");
+    os << "iteration,value,step,ns,evaluation_ns,line_search_ns,criteria_ns,other_ns" << std::endl;
+}
+
+SampledTracer::~SampledTracer()
+{
+}
+
+void SampledTracer::onIteration(const IterationInfo &info)
+{
+    if (info.iterNum != 1 && info.iterNum % every != 0)
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    os << info.iterNum << "," << info.value << "," << info.stepNorm << "," << info.elapsedNs;
+    for (uint64_t ns : info.phaseNs)
+        os << "," << ns;
+    os << "\n";
+}
+
+PhaseHistogram::PhaseHistogram() : counts{}, totalNs{}, iterNum(0)
+{
+}
+
+PhaseHistogram::~PhaseHistogram()
+{
+}
+
+void PhaseHistogram::onIteration(const IterationInfo &info)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++iterNum;
+    for (size_t phase = 0; phase < iterationPhasesNum; ++phase)
+    {
+        uint64_t ns = info.phaseNs[phase];
+        size_t bucket = ns == 0 ? 0 : std::bit_width(ns) - 1;
+        ++counts[phase][bucket];
+        totalNs[phase] += ns;
+    }
+}
+
+size_t PhaseHistogram::getCount(IterationPhase phase, size_t bucket) const
+{
+    if (bucket >= bucketsNum)
+        throw std::invalid_argument("Bucket index is out of range.");
+    std::lock_guard<std::mutex> lock(mutex);
+    return counts[static_cast<size_t>(phase)][bucket];
+}
+
+uint64_t PhaseHistogram::getTotalNs(IterationPhase phase) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return totalNs[static_cast<size_t>(phase)];
+}
+
+size_t PhaseHistogram::getIterNum() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return iterNum;
+}
+
+void PhaseHistogram::print(std::ostream &os) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t phase = 0; phase < iterationPhasesNum; ++phase)
+    {
+        os << phaseNames[phase] << ": total " << totalNs[phase] << " ns";
+        if (iterNum > 0)
+            os << ", mean " << totalNs[phase] / iterNum << " ns per iteration";
+        os << std::endl;
+        for (size_t bucket = 0; bucket < bucketsNum; ++bucket)
+        {
+            if (counts[phase][bucket] == 0)
+                continue;
+            os << "  [" << (bucket == 0 ? 0 : uint64_t(1) << bucket) << ", " << (bucket + 1 < bucketsNum ? std::to_string(uint64_t(1) << (bucket + 1)) : "inf")
+               << ") ns: " << counts[phase][bucket] << std::endl;
+        }
+    }
+}
@@ -0,0 +1,337 @@
+#include "LineSearch.h"
+#include <algorithm>
+#include <limits>
+
+static double dot(const VectorX &a, const VectorX &b)
+{
+    double sum = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+static const double notEvaluated = std::numeric_limits<double>::quiet_NaN();
+
+LineSearch::LineSearch()
+{
+}
+
+LineSearch::~LineSearch()
+{
+}
+
+TernaryLineSearch::TernaryLineSearch(double eps, size_t maxIter) : eps(eps), maxIter(maxIter)
+{
+}
+
+TernaryLineSearch::~TernaryLineSearch()
+{
+}
+
+LineSearchResult TernaryLineSearch::search(const Function &f, const VectorX &point, double, const VectorX &grad,
+                                           double maxAlpha, double) const
+{
+    double l = 0;
+    double r = maxAlpha;
+    double lNext, rNext;
+    size_t evaluations = 0;
+    auto g = [&f, &point, &grad, &evaluations](double alpha) -> double
+    {
+        ++evaluations;
+        return f(point - alpha * grad);
+    };
+    for (size_t i = 0; (r - l > eps) && (i < maxIter); ++i)
+    {
+        lNext = (2 * l + r) / 3;
+        rNext = (l + 2 * r) / 3;
+        if (g(lNext) < g(rNext))
+            r = rNext;
+        else
+            l = lNext;
+    }
+    return {(l + r) / 2, evaluations, {notEvaluated, VectorX()}};
+}
+
+std::string TernaryLineSearch::getName() const
+{
+    return "Ternary";
+}
+
+GoldenSectionLineSearch::GoldenSectionLineSearch(double tolerance, size_t maxIter) : tolerance(tolerance), maxIter(maxIter)
+{
+}
+
+GoldenSectionLineSearch::~GoldenSectionLineSearch()
+{
+}
+
+LineSearchResult GoldenSectionLineSearch::search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                                                 double maxAlpha, double) const
+{
+    if (!(maxAlpha > 0) || !std::isfinite(maxAlpha))
+        return {0, 0, {value, VectorX()}};
+    const double invPhi = (std::sqrt(5.0) - 1) / 2;
+    size_t evaluations = 0;
+    auto phi = [&f, &point, &grad, &evaluations](double alpha) -> double
+    {
+        ++evaluations;
+        return f(point - alpha * grad);
+    };
+    double a = 0;
+    double b = maxAlpha;
+    double c = b - invPhi * (b - a);
+    double d = a + invPhi * (b - a);
+    double fc = phi(c);
+    double fd = phi(d);
+    while (b - a > tolerance * maxAlpha && evaluations < maxIter)
+    {
+        if (fc < fd)
+        {
+            b = d;
+            d = c;
+            fd = fc;
+            c = b - invPhi * (b - a);
+            fc = phi(c);
+        }
+        else
+        {
+            a = c;
+            c = d;
+            fc = fd;
+            d = a + invPhi * (b - a);
+            fd = phi(d);
+        }
+    }
+    // The probes never reach alpha = 0, so the current point may still be the best.
+    if (std::min(fc, fd) >= value)
+        return {0, evaluations, {value, VectorX()}};
+    if (fc < fd)
+        return {c, evaluations, {fc, VectorX()}};
+    return {d, evaluations, {fd, VectorX()}};
+}
+
+std::string GoldenSectionLineSearch::getName() const
+{
+    return "GoldenSection";
+}
+
+BrentLineSearch::BrentLineSearch(double tolerance, size_t maxIter) : tolerance(tolerance), maxIter(maxIter)
+{
+}
+
+BrentLineSearch::~BrentLineSearch()
+{
+}
+
+LineSearchResult BrentLineSearch::search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                                         double maxAlpha, double) const
+{
+    if (!(maxAlpha > 0) || !std::isfinite(maxAlpha))
+        return {0, 0, {value, VectorX()}};
+    const double cGold = (3 - std::sqrt(5.0)) / 2;
+    // Keeps the tolerance positive when the minimum is at a step of zero.
+    const double absTolerance = 1e-10 * maxAlpha;
+    size_t evaluations = 0;
+    auto phi = [&f, &point, &grad, &evaluations](double alpha) -> double
+    {
+        ++evaluations;
+        return f(point - alpha * grad);
+    };
+
+    // x is the best point so far, w the second best, v the previous w;
+    // d is the last step and e the step before it.
+    double a = 0;
+    double b = maxAlpha;
+    double x = a + cGold * (b - a);
+    double w = x, v = x;
+    double fx = phi(x);
+    double fw = fx, fv = fx;
+    double d = 0, e = 0;
+    while (evaluations < maxIter)
+    {
+        double xm = (a + b) / 2;
+        double tol1 = tolerance * std::abs(x) + absTolerance;
+        double tol2 = 2 * tol1;
+        if (std::abs(x - xm) <= tol2 - (b - a) / 2)
+            break;
+        bool golden = true;
+        if (std::abs(e) > tol1)
+        {
+            double r = (x - w) * (fx - fv);
+            double q = (x - v) * (fx - fw);
+            double p = (x - v) * q - (x - w) * r;
+            q = 2 * (q - r);
+            if (q > 0)
+                p = -p;
+            q = std::abs(q);
+            double eTmp = e;
+            e = d;
+            if (std::abs(p) < std::abs(q * eTmp / 2) && p > q * (a - x) && p < q * (b - x))
+            {
+                d = p / q;
+                double u = x + d;
+                if (u - a < tol2 || b - u < tol2)
+                    d = xm > x ? tol1 : -tol1;
+                golden = false;
+            }
+        }
+        if (golden)
+        {
+            e = x >= xm ? a - x : b - x;
+            d = cGold * e;
+        }
+        double u = std::abs(d) >= tol1 ? x + d : x + (d > 0 ? tol1 : -tol1);
+        double fu = phi(u);
+        if (fu <= fx)
+        {
+            if (u >= x)
+                a = x;
+            else
+                b = x;
+            v = w;
+            fv = fw;
+            w = x;
+            fw = fx;
+            x = u;
+            fx = fu;
+        }
+        else
+        {
+            if (u < x)
+                a = u;
+            else
+                b = u;
+            if (fu <= fw || w == x)
+            {
+                v = w;
+                fv = fw;
+                w = u;
+                fw = fu;
+            }
+            else if (fu <= fv || v == x || v == w)
+            {
+                v = u;
+                fv = fu;
+            }
+        }
+    }
+    if (fx >= value)
+        return {0, evaluations, {value, VectorX()}};
+    return {x, evaluations, {fx, VectorX()}};
+}
+
+std::string BrentLineSearch::getName() const
+{
+    return "Brent";
+}
+
+StrongWolfeLineSearch::StrongWolfeLineSearch(double c1, double c2, size_t maxIter) : c1(c1), c2(c2), maxIter(maxIter)
+{
+    if (!(0 < c1 && c1 < c2 && c2 < 1))
+        throw std::invalid_argument("Wolfe constants must satisfy 0 < c1 < c2 < 1.");
+}
+
+StrongWolfeLineSearch::~StrongWolfeLineSearch()
+{
+}
+
+LineSearchResult StrongWolfeLineSearch::search(const Function &f, const VectorX &point, double value, const VectorX &grad,
+                                               double maxAlpha, double prevAlpha) const
+{
+    double gradNorm2 = dot(grad, grad);
+    if (!(maxAlpha > 0) || gradNorm2 == 0)
+        return {0, 0, {value, grad}};
+
+    // A trial step with phi(alpha) and its derivative phi'(alpha).
+    struct Trial
+    {
+        double alpha;
+        double phi;
+        double dphi;
+        Evaluation eval;
+    };
+    size_t evaluations = 0;
+    double dphi0 = -gradNorm2;
+    // The trial point is formed like the update of the method, so the
+    // returned evaluation belongs to exactly the point the method moves to.
+    auto probe = [&f, &point, &grad, &evaluations](double alpha) -> Trial
+    {
+        ++evaluations;
+        VectorX x(point);
+        x -= alpha * grad;
+        Evaluation eval = f.evaluate(x, true);
+        double dphi = -dot(eval.grad, grad);
+        return {alpha, eval.value, dphi, std::move(eval)};
+    };
+    auto sufficientDecrease = [this, value, dphi0](const Trial &t)
+    {
+        return t.phi <= value + c1 * t.alpha * dphi0;
+    };
+    auto curvature = [this, dphi0](const Trial &t)
+    {
+        return std::abs(t.dphi) <= -c2 * dphi0;
+    };
+    // Minimizer of the cubic interpolating both ends, kept away from the ends.
+    auto interpolate = [](const Trial &lo, const Trial &hi)
+    {
+        double left = std::min(lo.alpha, hi.alpha);
+        double right = std::max(lo.alpha, hi.alpha);
+        double d1 = lo.dphi + hi.dphi - 3 * (lo.phi - hi.phi) / (lo.alpha - hi.alpha);
+        double d2Square = d1 * d1 - lo.dphi * hi.dphi;
+        if (d2Square >= 0)
+        {
+            double d2 = (hi.alpha > lo.alpha ? 1 : -1) * std::sqrt(d2Square);
+            double alpha = hi.alpha - (hi.alpha - lo.alpha) * (hi.dphi + d2 - d1) / (hi.dphi - lo.dphi + 2 * d2);
+            double margin = 0.1 * (right - left);
+            if (alpha >= left + margin && alpha <= right - margin)
+                return alpha;
+        }
+        return (left + right) / 2;
+    };
+    // lo satisfies sufficient decrease and has the lowest value seen; the
+    // interval between lo and hi contains a point satisfying both conditions.
+    auto zoom = [&](Trial lo, Trial hi) -> Trial
+    {
+        while (evaluations < maxIter && std::abs(hi.alpha - lo.alpha) > 1e-12 * std::max(lo.alpha, hi.alpha))
+        {
+            Trial t = probe(interpolate(lo, hi));
+            if (!sufficientDecrease(t) || t.phi >= lo.phi)
+            {
+                hi = std::move(t);
+                continue;
+            }
+            if (curvature(t))
+                return t;
+            if (t.dphi * (hi.alpha - lo.alpha) >= 0)
+                hi = std::move(lo);
+            lo = std::move(t);
+        }
+        return lo;
+    };
+    auto result = [&evaluations](Trial t) -> LineSearchResult
+    {
+        return {t.alpha, evaluations, std::move(t.eval)};
+    };
+
+    Trial prev{0, value, dphi0, {value, grad}};
+    Trial curr = probe(std::min(prevAlpha > 0 ? prevAlpha : 1 / std::sqrt(gradNorm2), maxAlpha));
+    for (bool first = true;; first = false)
+    {
+        if (!sufficientDecrease(curr) || (!first && curr.phi >= prev.phi))
+            return result(zoom(std::move(prev), std::move(curr)));
+        if (curvature(curr))
+            return result(std::move(curr));
+        if (curr.dphi >= 0)
+            return result(zoom(std::move(curr), std::move(prev)));
+        if (curr.alpha >= maxAlpha || evaluations >= maxIter)
+            return result(std::move(curr));
+        double alpha = std::min(2 * curr.alpha, maxAlpha);
+        prev = std::move(curr);
+        curr = probe(alpha);
+    }
+}
+
+std::string StrongWolfeLineSearch::getName() const
+{
+    return "StrongWolfe";
+}
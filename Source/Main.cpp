@@ -1,6 +1,10 @@
 ﻿#include "Function.h"
+#include "ParsedFunction.h"
 #include "OptimizationMethod.h"
+#include "MultiStart.h"
+#include "BatchMode.h"
 #include <chrono>
+#include <fstream>
 
 using namespace std;
 
@@ -17,6 +21,14 @@ string printStat(const std::shared_ptr<OptimizationMethod> method, const std::sh
 	output << "Best point: " << method->getBestPoint() << endl;
 	output << "Value of " + f->getName() + " function: " << (*f)(method->getBestPoint()) << endl;
 	output << method->getIterNum() << " iteration made" << endl;
+	RunStats stats = method->getRunStats();
+	output << stats.valueCalls << " function values (" << stats.criteriaValueCalls << " by the stopping criterion)" << endl;
+	output << stats.gradCalls << " gradients (" << stats.criteriaGradCalls << " by the stopping criterion)" << endl;
+	if (stats.lineSearchValueCalls + stats.lineSearchGradCalls > 0)
+		output << stats.lineSearchValueCalls << " function values and " << stats.lineSearchGradCalls << " gradients by the line search" << endl;
+	if (stats.hessVecCalls > 0)
+		output << stats.hessVecCalls << " Hessian-vector products" << endl;
+	output << stats.vectorAllocations << " vector allocations (" << stats.vectorReuses << " buffers reused)" << endl;
 	std::chrono::duration<double> duration = end - start;
 	output << "Execution time: " << duration.count() << " seconds" << endl
 		   << "OPTIMIZATION" << endl
@@ -25,6 +37,29 @@ string printStat(const std::shared_ptr<OptimizationMethod> method, const std::sh
 	return output.str();
 }
 
+string printMultiStartStat(const std::shared_ptr<OptimizationMethod> method, const std::shared_ptr<Function> &f, Area &area, const std::shared_ptr<StopCriteria> cr, size_t startsNum, size_t threads)
+{
+	std::stringstream output;
+	output << endl
+		   << "MULTI-START OPTIMIZATION" << endl;
+	MultiStart multiStart(threads);
+	auto start = std::chrono::high_resolution_clock::now();
+	MultiStartResult result = multiStart.run(*method, startsNum, 228, area, *f, *cr);
+	auto end = std::chrono::high_resolution_clock::now();
+	const StartResult &best = result.starts[result.bestIndex];
+	output << method->getName() << ", " << startsNum << " starts on " << threads << " threads" << endl;
+	output << "Best start point: " << best.startPoint << endl;
+	output << "Best point: " << best.bestPoint << endl;
+	output << "Value of " + f->getName() + " function: " << best.value << endl;
+	output << best.iterNum << " iteration made" << endl;
+	std::chrono::duration<double> duration = end - start;
+	output << "Execution time: " << duration.count() << " seconds" << endl
+		   << "MULTI-START OPTIMIZATION" << endl
+		   << endl;
+	cout << output.str();
+	return output.str();
+}
+
 class InvalidInputException : public std::runtime_error
 {
 public:
@@ -82,6 +117,29 @@ double safeInputDouble(const string &prompt)
 	}
 }
 
+std::shared_ptr<Function> inputParsedFunction()
+{
+	while (true)
+	{
+		cout << "Enter the formula, for example (1 - x)^2 + 100(y - x^2)^2: ";
+		string formula;
+		getline(cin, formula);
+		try
+		{
+			auto f = std::make_shared<ParsedFunction>(formula);
+			cout << "Variables in coordinate order:";
+			for (const string &variable : f->getVariables())
+				cout << " " << variable;
+			cout << endl;
+			return f;
+		}
+		catch (const std::invalid_argument &exc)
+		{
+			cout << exc.what() << " Try again." << endl;
+		}
+	}
+}
+
 std::shared_ptr<Function> chooseFunction()
 {
 	cout << "Select the function to optimize:" << endl;
@@ -99,8 +157,9 @@ std::shared_ptr<Function> chooseFunction()
 	cout << "4. " << func4.getName() << ": dim = " << func4.getDim() << endl;
 	cout << "5. " << func5.getName() << ": dim = " << func5.getDim() << endl;
 	cout << "6. " << func6.getName() << ": dim = " << func6.getDim() << endl;
+	cout << "7. Enter a formula" << endl;
 
-	int funcChoice = safeInputInt("Your choice: ", 1, 6);
+	int funcChoice = safeInputInt("Your choice: ", 1, 7);
 
 	switch (funcChoice)
 	{
@@ -116,6 +175,8 @@ std::shared_ptr<Function> chooseFunction()
 		return std::make_shared<Function5>();
 	case 6:
 		return std::make_shared<Function6>();
+	case 7:
+		return inputParsedFunction();
 	default:
 		cout << "Incorrect function selection." << endl;
 	}
@@ -190,8 +251,10 @@ shared_ptr<OptimizationMethod> inputOptimizationMethod()
 	cout << "1. AdamGradientDescent" << endl;
 	cout << "2. ClassicGradientDescent" << endl;
 	cout << "3. RandomSearch" << endl;
+	cout << "4. LBFGSB" << endl;
+	cout << "5. NewtonCG" << endl;
 
-	int methodChoice = safeInputInt("Your choice ", 1, 3);
+	int methodChoice = safeInputInt("Your choice ", 1, 5);
 	std::shared_ptr<OptimizationMethod> method;
 
 	switch (methodChoice)
@@ -206,24 +269,150 @@ shared_ptr<OptimizationMethod> inputOptimizationMethod()
 		break;
 	}
 	case 2:
-		method = make_shared<ClassicGradientDescent>();
+	{
+		cout << "Select a line search:" << endl;
+		cout << "1. Ternary" << endl;
+		cout << "2. Golden section" << endl;
+		cout << "3. Brent" << endl;
+		cout << "4. Strong Wolfe" << endl;
+		int searchChoice = safeInputInt("Your choice ", 1, 4);
+		std::shared_ptr<LineSearch> lineSearch;
+		switch (searchChoice)
+		{
+		case 1:
+			lineSearch = make_shared<TernaryLineSearch>();
+			break;
+		case 2:
+			lineSearch = make_shared<GoldenSectionLineSearch>();
+			break;
+		case 3:
+			lineSearch = make_shared<BrentLineSearch>();
+			break;
+		default:
+			lineSearch = make_shared<StrongWolfeLineSearch>();
+			break;
+		}
+		method = make_shared<ClassicGradientDescent>(lineSearch);
 		break;
+	}
 	case 3:
 	{
 		double randAlpha = safeInputDouble("Input alpha: ");
 		double p = safeInputDouble("Input p: ");
 		double delta = safeInputDouble("Input delta: ");
-		method = make_shared<RandomSearch>(randAlpha, p, delta);
+		size_t threads = safeInputInt("Input number of threads (1 for serial search): ", 1, 1024);
+		method = make_shared<RandomSearch>(randAlpha, p, delta, threads);
+		break;
+	}
+	case 4:
+	{
+		size_t memory = safeInputInt("Input the number of correction pairs to keep: ", 1, 100);
+		method = make_shared<LBFGSB>(memory);
 		break;
 	}
+	case 5:
+		method = make_shared<NewtonCG>();
+		break;
 	default:
 		throw InvalidInputException("Incorrect choice of optimization method.");
 	}
 	return method;
 }
 
-int main()
+/**
+ * \brief Run a job file or the built-in sweep without prompts.
+ *
+ * Usage: FunctionMinimization (--batch <jobs> | --sweep <starts>) [--output <results.csv>] [--threads <n>]
+ *
+ * \return 0 if every job ran, 1 if any job failed, 2 on invalid usage or unreadable files.
+ */
+int runBatchMode(int argc, char *argv[])
 {
+	string jobsPath, outputPath;
+	size_t threads = 0;
+	size_t sweepStarts = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			cerr << "Missing value for " << arg << endl;
+			return 2;
+		}
+		string value = argv[++i];
+		if (arg == "--batch")
+			jobsPath = value;
+		else if (arg == "--output")
+			outputPath = value;
+		else if (arg == "--threads")
+		{
+			try
+			{
+				threads = std::stoul(value);
+			}
+			catch (const std::exception &)
+			{
+				cerr << "Invalid number of threads: " << value << endl;
+				return 2;
+			}
+		}
+		else if (arg == "--sweep")
+		{
+			try
+			{
+				sweepStarts = std::stoul(value);
+			}
+			catch (const std::exception &)
+			{
+				sweepStarts = 0;
+			}
+			if (sweepStarts == 0)
+			{
+				cerr << "Invalid number of start points: " << value << endl;
+				return 2;
+			}
+		}
+		else
+		{
+			cerr << "Unknown option " << arg << endl;
+			return 2;
+		}
+	}
+	if (jobsPath.empty() == (sweepStarts == 0))
+	{
+		cerr << "Usage: " << argv[0] << " (--batch <jobs> | --sweep <starts>) [--output <results.csv>] [--threads <n>]" << endl;
+		return 2;
+	}
+
+	std::ifstream jobs;
+	if (!jobsPath.empty())
+	{
+		jobs.open(jobsPath);
+		if (!jobs)
+		{
+			cerr << "Cannot open job file " << jobsPath << endl;
+			return 2;
+		}
+	}
+	std::ofstream file;
+	if (!outputPath.empty())
+	{
+		file.open(outputPath);
+		if (!file)
+		{
+			cerr << "Cannot open output file " << outputPath << endl;
+			return 2;
+		}
+	}
+	std::ostream &results = outputPath.empty() ? cout : file;
+	return sweepStarts ? runSweep(results, sweepStarts, threads) : runBatch(jobs, results, threads, cerr);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1)
+		return runBatchMode(argc, argv);
+
 	std::shared_ptr<Function> f = chooseFunction();
 
 	size_t dim = f->getDim();
@@ -253,9 +442,10 @@ int main()
 		cout << "5. Optimization Method: " << method->getName() << endl;
 		cout << "6. Start optimization" << endl;
 		cout << "7. Print all results" << endl;
+		cout << "8. Start multi-start optimization" << endl;
 		cout << "0. Exit" << endl;
 
-		int choice = safeInputInt("Select what you want to change (0-6): ", 0, 7);
+		int choice = safeInputInt("Select what you want to change (0-8): ", 0, 8);
 
 		switch (choice)
 		{
@@ -298,6 +488,14 @@ int main()
 					cout << result;
 				}
 			}
+			break;
+		case 8:
+		{
+			size_t startsNum = safeInputInt("Enter the number of start points: ", 1, 1000000);
+			size_t threads = safeInputInt("Enter the number of threads: ", 1, 1024);
+			results.push_back(printMultiStartStat(method, f, area, criteria, startsNum, threads));
+			break;
+		}
 		}
 	}
 }
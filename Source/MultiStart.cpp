@@ -0,0 +1,79 @@
+#include "MultiStart.h"
+#include <atomic>
+#include <exception>
+
+MultiStart::MultiStart(size_t threads) : pool(threads), target(-std::numeric_limits<double>::infinity())
+{
+}
+
+MultiStart::~MultiStart()
+{
+}
+
+void MultiStart::setTarget(double target)
+{
+    this->target = target;
+}
+
+MultiStartResult MultiStart::run(const OptimizationMethod &method, const std::vector<VectorX> &startPoints, const Area &area, const Function &f, const StopCriteria &criteria)
+{
+    MultiStartResult result;
+    result.starts.resize(startPoints.size());
+    result.bestIndex = 0;
+    std::atomic<bool> targetReached(false);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    for (size_t i = 0; i < startPoints.size(); ++i)
+    {
+        pool.submit([&, i]
+                    {
+            StartResult &start = result.starts[i];
+            start.startPoint = startPoints[i];
+            start.value = std::numeric_limits<double>::infinity();
+            start.iterNum = 0;
+            start.completed = false;
+            if (targetReached.load(std::memory_order_relaxed))
+                return;
+            try
+            {
+                std::shared_ptr<OptimizationMethod> local = method.clone();
+                local->setCancelFlag(&targetReached);
+                Area localArea(area);
+                local->optimise(startPoints[i], localArea, f, criteria);
+                start.bestPoint = local->getBestPoint();
+                start.value = f(start.bestPoint);
+                start.iterNum = local->getIterNum();
+                start.completed = true;
+                if (start.value <= target)
+                    targetReached.store(true, std::memory_order_relaxed);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            } });
+    }
+    pool.wait();
+    if (error)
+        std::rethrow_exception(error);
+
+    for (size_t i = 0; i < result.starts.size(); ++i)
+    {
+        const StartResult &start = result.starts[i];
+        if (start.completed && (!result.starts[result.bestIndex].completed || start.value < result.starts[result.bestIndex].value))
+            result.bestIndex = i;
+    }
+    return result;
+}
+
+MultiStartResult MultiStart::run(const OptimizationMethod &method, size_t startsNum, unsigned int seed, const Area &area, const Function &f, const StopCriteria &criteria,
+                                 Sampling sampling)
+{
+    std::shared_ptr<RandomEngine> sampler = makeSampler(sampling, f.getDim(), seed);
+    std::vector<VectorX> startPoints(startsNum, VectorX(f.getDim()));
+    for (VectorX &startPoint : startPoints)
+        area.genRandPoint(startPoint, *sampler);
+    return run(method, startPoints, area, f, criteria);
+}
@@ -1,6 +1,12 @@
 ﻿#include "OptimizationMethod.h"
+#include "VectorKernels.h"
+#include "VectorPool.h"
+#include <atomic>
+#include <barrier>
+#include <exception>
+#include <thread>
 
-OptimizationMethod::OptimizationMethod() : iterMade(0)
+OptimizationMethod::OptimizationMethod() : iterMade(0), observer(nullptr), cancel(nullptr)
 {
 }
 
@@ -18,6 +24,38 @@ size_t OptimizationMethod::getIterNum()
 	return iterMade;
 }
 
+RunStats OptimizationMethod::getRunStats() const
+{
+	return stats;
+}
+
+void OptimizationMethod::setObserver(IterationObserver *observer)
+{
+	this->observer = observer;
+}
+
+void OptimizationMethod::setCancelFlag(const std::atomic<bool> *cancel)
+{
+	this->cancel = cancel;
+}
+
+bool OptimizationMethod::checkCriteria(const StopCriteria &criteria, TransferData &data)
+{
+	if (isCancelled())
+		return true;
+	size_t valueCalls = threadRunStats.valueCalls;
+	size_t gradCalls = threadRunStats.gradCalls;
+	bool stop = criteria.check(data);
+	threadRunStats.criteriaValueCalls += threadRunStats.valueCalls - valueCalls;
+	threadRunStats.criteriaGradCalls += threadRunStats.gradCalls - gradCalls;
+	return stop;
+}
+
+bool OptimizationMethod::isCancelled() const
+{
+	return cancel && cancel->load(std::memory_order_relaxed);
+}
+
 AdamGradientDescent::AdamGradientDescent(double alpha, double beta1, double beta2, double epsilon)
 	: OptimizationMethod(), alpha(alpha), beta1(beta1), beta2(beta2), epsilon(epsilon)
 {
@@ -27,16 +65,22 @@ AdamGradientDescent::~AdamGradientDescent()
 {
 }
 
-RandomSearch::RandomSearch(double alpha, double p, double delta) : OptimizationMethod(), alpha(alpha), p(p), delta(delta), gen(228)
+RandomSearch::RandomSearch(double alpha, double p, double delta, size_t threads, unsigned int seed, size_t batchSize)
+	: OptimizationMethod(), alpha(alpha), p(p), delta(delta), threads(threads), seed(seed), batchSize(batchSize), sampling(Sampling::Random), gen(seed)
 {
+	if (threads == 0 || batchSize == 0)
+		throw std::invalid_argument("RandomSearch needs at least one thread and one candidate per batch.");
 }
 
 RandomSearch::~RandomSearch()
 {
 }
 
-ClassicGradientDescent::ClassicGradientDescent() : OptimizationMethod(), alpha(0)
+ClassicGradientDescent::ClassicGradientDescent(std::shared_ptr<LineSearch> lineSearch)
+	: OptimizationMethod(), lineSearch(lineSearch), alpha(0)
 {
+	if (!lineSearch)
+		throw std::invalid_argument("Line search must not be null.");
 }
 
 ClassicGradientDescent::~ClassicGradientDescent()
@@ -45,6 +89,18 @@ ClassicGradientDescent::~ClassicGradientDescent()
 
 void AdamGradientDescent::optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
 {
+	VectorPoolScope pool;
+	if (observer)
+		optimiseLoop<true>(startPoint, area, f, criteria);
+	else
+		optimiseLoop<false>(startPoint, area, f, criteria);
+}
+
+template <bool Observed>
+void AdamGradientDescent::optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	RunStats begin = threadRunStats;
+	points.clear();
 	points.push_back(startPoint);
 	size_t t = 0;
 	size_t dim = f.getDim();
@@ -56,29 +112,29 @@ void AdamGradientDescent::optimise(const VectorX &startPoint, Area &area, const
 	data.setFunc(f);
 	data.setIterNum(0);
 	data.setPoints(points);
-	while (!criteria.check(data))
+	IterationTimer<Observed> timer(observer);
+	auto describe = [this, &data]
+	{
+		return IterationInfo{data.getIterNum(), data.getPrevValue(), norm(points.back() - points[points.size() - 2])};
+	};
+	while (!checkCriteria(criteria, data))
 	{
+		timer.mark(IterationPhase::Criteria);
 		data.setIterNum(data.getIterNum() + 1);
 		nextPoint = points.back();
-		VectorX grad(f.grad(points.back()));
+		const VectorX &grad = data.getCurrGrad();
+		timer.mark(IterationPhase::Evaluation);
 		++t;
-		for (int i = 0; i < dim; ++i)
-		{
-			m[i] = beta1 * m[i] + (1 - beta1) * grad[i];
-			v[i] = beta2 * v[i] + (1 - beta2) * grad[i] * grad[i];
-			m_hat = m[i] / (1 - pow(beta1, t));
-			v_hat = v[i] / (1 - pow(beta2, t));
-			nextPoint[i] -= alpha * m_hat / (sqrt(v_hat) + epsilon);
-		}
+		AdamCoefficients coeffs{beta1, beta2, 1 - pow(beta1, t), 1 - pow(beta2, t), alpha, epsilon};
+		vectorKernels().adamStep(nextPoint.data(), m.data(), v.data(), grad.data(), dim, coeffs);
 
 		if (area.inArea(nextPoint))
 		{
 			points.push_back(nextPoint);
-			data.setPoints(points);
 		}
 		else
 		{
-			std::vector<std::pair<double, double>> bound = area.getBounds();
+			const std::vector<std::pair<double, double>> &bound = area.getBounds();
 			double alpha_max = INFINITY;
 			VectorX point = points.back();
 			for (int i = 0; i < dim; ++i)
@@ -99,11 +155,13 @@ void AdamGradientDescent::optimise(const VectorX &startPoint, Area &area, const
 				point[i] -= alpha_max * m_hat / (sqrt(v_hat) + epsilon);
 			}
 			points.push_back(point);
-			data.setPoints(points);
+			timer.finish(describe);
 			break;
 		}
+		timer.finish(describe);
 	}
 	iterMade = data.getIterNum();
+	stats = threadRunStats - begin;
 }
 
 std::string AdamGradientDescent::getName()
@@ -111,81 +169,308 @@ std::string AdamGradientDescent::getName()
 	return "AdamGradientDescent";
 }
 
+std::shared_ptr<OptimizationMethod> AdamGradientDescent::clone() const
+{
+	return std::make_shared<AdamGradientDescent>(*this);
+}
+
 void RandomSearch::optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
 {
+	VectorPoolScope pool;
+	if (observer)
+		optimiseLoop<true>(startPoint, area, f, criteria);
+	else
+		optimiseLoop<false>(startPoint, area, f, criteria);
+}
+
+template <bool Observed>
+void RandomSearch::optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	RunStats begin = threadRunStats;
+	points.clear();
 	points.push_back(startPoint);
+	if (threads > 1)
+	{
+		optimiseParallel<Observed>(area, f, criteria);
+		stats = threadRunStats - begin;
+		return;
+	}
 	size_t dim = f.getDim();
-	std::uniform_real_distribution<> _p(0, 1);
-	Area areaIntersected;
-	Neighborhood neighborhood(delta, points.back());
+	double currDelta = delta;
+	Neighborhood neighborhood(currDelta, points.back());
+	Area areaIntersected = intersect(area, neighborhood);
 	VectorX nextPoint(dim, 0.0);
+	// The area and the neighborhood draw from sequences of their own: a
+	// sequence split between them by the random choice would leave gaps in
+	// both.
+	std::shared_ptr<RandomEngine> areaSequence, neighborhoodSequence;
+	if (sampling != Sampling::Random)
+	{
+		areaSequence = makeSampler(sampling, dim, seed);
+		neighborhoodSequence = makeSampler(sampling, dim, uint64_t(seed) + 1);
+	}
+	RandomEngine &areaSource = areaSequence ? *areaSequence : static_cast<RandomEngine &>(gen);
+	RandomEngine &neighborhoodSource = neighborhoodSequence ? *neighborhoodSequence : static_cast<RandomEngine &>(gen);
 	TransferData data;
 	data.setFunc(f);
 	data.setIterNum(0);
 	data.setPoints(points);
-	while (!criteria.check(data))
+	IterationTimer<Observed> timer(observer);
+	while (!checkCriteria(criteria, data))
 	{
+		timer.mark(IterationPhase::Criteria);
 		data.setIterNum(data.getIterNum() + 1);
-		if (_p(gen) > p)
+		size_t pointsNum = points.size();
+		double currValue = data.getCurrValue();
+		if (gen.uniform() > p)
 		{
-			area.genRandPoint(nextPoint, gen);
-			if (f(nextPoint) < f(points.back()))
+			area.genRandPoint(nextPoint, areaSource);
+			timer.mark(IterationPhase::Other);
+			double nextValue = f(nextPoint);
+			timer.mark(IterationPhase::Evaluation);
+			if (nextValue < currValue)
 			{
 				points.push_back(nextPoint);
-				data.setPoints(points);
+				data.setCurrEval({nextValue, VectorX()});
 			}
 		}
 		else
 		{
-			areaIntersected = intersect(area, neighborhood);
-			areaIntersected.genRandPoint(nextPoint, gen);
-			if (f(nextPoint) < f(points.back()))
+			areaIntersected.genRandPoint(nextPoint, neighborhoodSource);
+			timer.mark(IterationPhase::Other);
+			double nextValue = f(nextPoint);
+			timer.mark(IterationPhase::Evaluation);
+			if (nextValue < currValue)
 			{
-				delta *= alpha;
+				currDelta *= alpha;
 				points.push_back(nextPoint);
-				data.setPoints(points);
-				neighborhood.change(delta, points.back());
+				data.setCurrEval({nextValue, VectorX()});
+				neighborhood.change(currDelta, points.back());
+				areaIntersected = intersect(area, neighborhood);
 			}
 		}
+		timer.finish([&]
+					 { return IterationInfo{data.getIterNum(), currValue, points.size() > pointsNum ? norm(points.back() - points[pointsNum - 1]) : 0}; });
 	}
 	iterMade = data.getIterNum();
+	stats = threadRunStats - begin;
 }
 
-std::string RandomSearch::getName()
+template <bool Observed>
+void RandomSearch::optimiseParallel(Area &area, const Function &f, const StopCriteria &criteria)
 {
-	return "RandomSearch";
-}
+	size_t dim = f.getDim();
+	double currDelta = delta;
+	Neighborhood neighborhood(currDelta, points.back());
+	std::vector<std::pair<double, double>> globalBounds = area.getBounds();
+	std::vector<std::pair<double, double>> localBounds = intersect(area, neighborhood).getBounds();
 
-double ClassicGradientDescent::alphaOptimization(const Function &func, const VectorX &point, const double maxAlpha)
-{
-	double eps = 1e-15;
-	double l = 0;
-	double r = maxAlpha;
-	double lNext, rNext;
-	size_t maxIter = 100;
-	VectorX grad = func.grad(point);
-	auto g = [&func, &point, &grad](double alpha) -> double
+	// A worker's share of a low-discrepancy sequence: blocks w, w + threads,
+	// w + 2 * threads, ... of batchSize points, drawn in order whatever the
+	// number of points each iteration takes from it.
+	struct SequenceShare
+	{
+		std::shared_ptr<RandomEngine> sequence;
+		size_t used = 0;
+		size_t blockSize = 0;
+		size_t skip = 0;
+
+		void next(double *u, size_t dim)
+		{
+			if (used == blockSize)
+			{
+				sequence->skipPoints(skip, dim);
+				used = 0;
+			}
+			sequence->nextPoint(u, dim);
+			++used;
+		}
+	};
+	struct Worker
 	{
-		return func(point - alpha * grad);
+		Philox4x32 gen;
+		SequenceShare area;
+		SequenceShare neighborhood;
+		std::vector<double> point;
+		PointBatch candidates;
+		std::vector<double> values;
+		std::vector<char> fromNeighborhood;
+		size_t best;
+		RunStats stats;
+		std::exception_ptr error;
 	};
-	for (int i = 0; (r - l > eps) && (i < maxIter); ++i)
+	std::vector<Worker> workers(threads);
+	for (size_t w = 0; w < threads; ++w)
 	{
-		lNext = (2 * l + r) / 3;
-		rNext = (l + 2 * r) / 3;
-		if (g(lNext) < g(rNext))
-			r = rNext;
-		else
-			l = lNext;
+		workers[w].gen = Philox4x32(seed, w);
+		if (sampling != Sampling::Random)
+		{
+			// As in the serial search, the area and the neighborhood draw from
+			// sequences of their own.
+			workers[w].area.sequence = makeSampler(sampling, dim, seed);
+			workers[w].neighborhood.sequence = makeSampler(sampling, dim, uint64_t(seed) + 1);
+			for (SequenceShare *share : {&workers[w].area, &workers[w].neighborhood})
+			{
+				share->sequence->skipPoints(w * batchSize, dim);
+				share->blockSize = batchSize;
+				share->skip = (threads - 1) * batchSize;
+			}
+			workers[w].point.resize(dim);
+		}
+		workers[w].candidates.resize(dim, batchSize);
+		workers[w].values.resize(batchSize);
+		workers[w].fromNeighborhood.resize(batchSize);
+	}
+
+	std::atomic<double> bestValue;
+	bool stop = false;
+	std::barrier start(threads + 1);
+	std::barrier done(threads + 1);
+	auto work = [&](Worker &worker)
+	{
+		RunStats begin = threadRunStats;
+		while (true)
+		{
+			start.arrive_and_wait();
+			if (stop)
+			{
+				worker.stats = threadRunStats - begin;
+				return;
+			}
+			// An exception must not escape the thread, and every worker must
+			// arrive at the barrier, so it is handed to the calling thread.
+			try
+			{
+				// The values are overwritten by the evaluation, so they hold the
+				// draws that choose between the area and the neighborhood first.
+				worker.gen.fillUniform(worker.values.data(), batchSize);
+				for (size_t k = 0; k < batchSize; ++k)
+					worker.fromNeighborhood[k] = worker.values[k] <= p && !localBounds.empty();
+				const std::vector<std::pair<double, double>> &local = localBounds.empty() ? globalBounds : localBounds;
+				bool sequenced = worker.area.sequence != nullptr;
+				if (sequenced)
+				{
+					for (size_t k = 0; k < batchSize; ++k)
+					{
+						SequenceShare &share = worker.fromNeighborhood[k] ? worker.neighborhood : worker.area;
+						share.next(worker.point.data(), dim);
+						for (size_t d = 0; d < dim; ++d)
+							worker.candidates.coord(d)[k] = worker.point[d];
+					}
+				}
+				for (size_t d = 0; d < dim; ++d)
+				{
+					double *coord = worker.candidates.coord(d);
+					if (!sequenced)
+						worker.gen.fillUniform(coord, batchSize);
+					double globalLow = globalBounds[d].first, globalWidth = globalBounds[d].second - globalBounds[d].first;
+					double localLow = local[d].first, localWidth = local[d].second - local[d].first;
+					for (size_t k = 0; k < batchSize; ++k)
+						coord[k] = worker.fromNeighborhood[k] ? localLow + localWidth * coord[k] : globalLow + globalWidth * coord[k];
+				}
+				f.evaluateBatch(worker.candidates, worker.values.data());
+				worker.best = 0;
+				for (size_t k = 1; k < batchSize; ++k)
+					if (worker.values[k] < worker.values[worker.best])
+						worker.best = k;
+				double value = worker.values[worker.best];
+				double seen = bestValue.load(std::memory_order_relaxed);
+				while (value < seen && !bestValue.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+				{
+				}
+			}
+			catch (...)
+			{
+				worker.error = std::current_exception();
+			}
+			done.arrive_and_wait();
+		}
+	};
+	std::vector<std::jthread> pool;
+	for (size_t w = 0; w < threads; ++w)
+		pool.emplace_back(work, std::ref(workers[w]));
+
+	TransferData data;
+	data.setFunc(f);
+	data.setIterNum(0);
+	data.setPoints(points);
+	IterationTimer<Observed> timer(observer);
+	try
+	{
+		while (!checkCriteria(criteria, data))
+		{
+			timer.mark(IterationPhase::Criteria);
+			data.setIterNum(data.getIterNum() + 1);
+			size_t pointsNum = points.size();
+			double currValue = data.getCurrValue();
+			bestValue.store(currValue, std::memory_order_relaxed);
+			start.arrive_and_wait();
+			done.arrive_and_wait();
+			for (Worker &worker : workers)
+			{
+				if (worker.error)
+					std::rethrow_exception(worker.error);
+			}
+			timer.mark(IterationPhase::Evaluation);
+			double roundBest = bestValue.load(std::memory_order_relaxed);
+			if (roundBest < currValue)
+			{
+				for (Worker &worker : workers)
+				{
+					if (worker.values[worker.best] != roundBest)
+						continue;
+					points.push_back(worker.candidates.getPoint(worker.best));
+					data.setCurrEval({roundBest, VectorX()});
+					// As in the serial search, only a win from the neighborhood
+					// shrinks it and moves it to the new point.
+					if (worker.fromNeighborhood[worker.best])
+					{
+						currDelta *= alpha;
+						neighborhood.change(currDelta, points.back());
+						localBounds = intersect(area, neighborhood).getBounds();
+					}
+					break;
+				}
+			}
+			timer.finish([&]
+						 { return IterationInfo{data.getIterNum(), currValue, points.size() > pointsNum ? norm(points.back() - points[pointsNum - 1]) : 0}; });
+		}
 	}
-	return (l + r) / 2;
+	catch (...)
+	{
+		stop = true;
+		start.arrive_and_wait();
+		throw;
+	}
+	stop = true;
+	start.arrive_and_wait();
+	for (std::jthread &thread : pool)
+		thread.join();
+	for (const Worker &worker : workers)
+		threadRunStats += worker.stats;
+	iterMade = data.getIterNum();
+}
+
+void RandomSearch::setSampling(Sampling sampling)
+{
+	this->sampling = sampling;
+}
+
+std::string RandomSearch::getName()
+{
+	return "RandomSearch";
+}
+
+std::shared_ptr<OptimizationMethod> RandomSearch::clone() const
+{
+	return std::make_shared<RandomSearch>(*this);
 }
 
-double ClassicGradientDescent::getMaxAlpha(Area &area, const Function &func, const VectorX &point)
+double ClassicGradientDescent::getMaxAlpha(Area &area, const VectorX &point, const VectorX &grad)
 {
-	std::vector<std::pair<double, double>> bound = area.getBounds();
+	const std::vector<std::pair<double, double>> &bound = area.getBounds();
 	double alphaMax = INFINITY;
 	size_t dim = point.size();
-	VectorX grad = func.grad(point);
 	for (int i = 0; i < dim; ++i)
 	{
 		double alphaTmp = std::max((point[i] - bound[i].first) / grad[i], (point[i] - bound[i].second) / grad[i]);
@@ -197,6 +482,18 @@ double ClassicGradientDescent::getMaxAlpha(Area &area, const Function &func, con
 
 void ClassicGradientDescent::optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
 {
+	VectorPoolScope pool;
+	if (observer)
+		optimiseLoop<true>(startPoint, area, f, criteria);
+	else
+		optimiseLoop<false>(startPoint, area, f, criteria);
+}
+
+template <bool Observed>
+void ClassicGradientDescent::optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	RunStats begin = threadRunStats;
+	points.clear();
 	points.push_back(startPoint);
 	size_t dim = f.getDim();
 	VectorX nextPoint(dim, 0.0);
@@ -204,20 +501,594 @@ void ClassicGradientDescent::optimise(const VectorX &startPoint, Area &area, con
 	data.setFunc(f);
 	data.setIterNum(0);
 	data.setPoints(points);
-	while (!criteria.check(data))
+	alpha = 0;
+	IterationTimer<Observed> timer(observer);
+	while (!checkCriteria(criteria, data))
 	{
+		timer.mark(IterationPhase::Criteria);
 		data.setIterNum(data.getIterNum() + 1);
 		nextPoint = points.back();
-		VectorX grad(f.grad(nextPoint));
-		alpha = alphaOptimization(f, nextPoint, getMaxAlpha(area, f, nextPoint));
+		const VectorX &grad = data.getCurrGrad();
+		double value = data.getCurrValue();
+		timer.mark(IterationPhase::Evaluation);
+		size_t valueCalls = threadRunStats.valueCalls;
+		size_t gradCalls = threadRunStats.gradCalls;
+		LineSearchResult step = lineSearch->search(f, nextPoint, value, grad, getMaxAlpha(area, nextPoint, grad), alpha);
+		threadRunStats.lineSearchValueCalls += threadRunStats.valueCalls - valueCalls;
+		threadRunStats.lineSearchGradCalls += threadRunStats.gradCalls - gradCalls;
+		alpha = step.alpha;
+		timer.mark(IterationPhase::LineSearch);
 		nextPoint -= alpha * grad;
 		points.push_back(nextPoint);
-		data.setPoints(points);
+		if (!step.evaluation.grad.empty())
+			data.setCurrEval(step.evaluation);
+		timer.finish([this, &data]
+					 { return IterationInfo{data.getIterNum(), data.getPrevValue(), norm(points.back() - points[points.size() - 2])}; });
 	}
 	iterMade = data.getIterNum();
+	stats = threadRunStats - begin;
 }
 
 std::string ClassicGradientDescent::getName()
 {
 	return "ClassicGradientDescent";
 }
+
+std::shared_ptr<OptimizationMethod> ClassicGradientDescent::clone() const
+{
+	return std::make_shared<ClassicGradientDescent>(*this);
+}
+
+void ClassicGradientDescent::setLineSearch(std::shared_ptr<LineSearch> lineSearch)
+{
+	if (!lineSearch)
+		throw std::invalid_argument("Line search must not be null.");
+	this->lineSearch = lineSearch;
+}
+
+std::shared_ptr<LineSearch> ClassicGradientDescent::getLineSearch() const
+{
+	return lineSearch;
+}
+
+static double dot(const double *a, const double *b, size_t n)
+{
+	double sum = 0;
+	for (size_t i = 0; i < n; ++i)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+/**
+ * \brief Invert an n x n row-major matrix by Gauss-Jordan elimination with partial pivoting.
+ *
+ * The matrix is overwritten by the elimination.
+ *
+ * \return False if the matrix is singular.
+ */
+static bool invertMatrix(std::vector<double> &a, std::vector<double> &inverse, size_t n)
+{
+	inverse.assign(n * n, 0.0);
+	for (size_t i = 0; i < n; ++i)
+		inverse[i * n + i] = 1;
+	for (size_t col = 0; col < n; ++col)
+	{
+		size_t pivot = col;
+		for (size_t row = col + 1; row < n; ++row)
+			if (std::abs(a[row * n + col]) > std::abs(a[pivot * n + col]))
+				pivot = row;
+		if (a[pivot * n + col] == 0 || !std::isfinite(a[pivot * n + col]))
+			return false;
+		if (pivot != col)
+			for (size_t j = 0; j < n; ++j)
+			{
+				std::swap(a[pivot * n + j], a[col * n + j]);
+				std::swap(inverse[pivot * n + j], inverse[col * n + j]);
+			}
+		double scale = 1 / a[col * n + col];
+		for (size_t j = 0; j < n; ++j)
+		{
+			a[col * n + j] *= scale;
+			inverse[col * n + j] *= scale;
+		}
+		for (size_t row = 0; row < n; ++row)
+		{
+			double factor = a[row * n + col];
+			if (row == col || factor == 0)
+				continue;
+			for (size_t j = 0; j < n; ++j)
+			{
+				a[row * n + j] -= factor * a[col * n + j];
+				inverse[row * n + j] -= factor * inverse[col * n + j];
+			}
+		}
+	}
+	return true;
+}
+
+LBFGSB::LBFGSB(size_t memory, double c1, size_t maxBacktracks)
+	: OptimizationMethod(), memory(memory), c1(c1), maxBacktracks(maxBacktracks), dim(0), head(0), count(0), theta(1)
+{
+	if (memory == 0)
+		throw std::invalid_argument("L-BFGS-B needs to keep at least one correction pair.");
+	if (!(0 < c1 && c1 < 1))
+		throw std::invalid_argument("Sufficient decrease constant must lie in (0, 1).");
+}
+
+LBFGSB::~LBFGSB()
+{
+}
+
+void LBFGSB::optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	VectorPoolScope pool;
+	if (observer)
+		optimiseLoop<true>(startPoint, area, f, criteria);
+	else
+		optimiseLoop<false>(startPoint, area, f, criteria);
+}
+
+template <bool Observed>
+void LBFGSB::optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	RunStats begin = threadRunStats;
+	points.clear();
+	points.push_back(startPoint);
+	dim = f.getDim();
+	const std::vector<std::pair<double, double>> &bounds = area.getBounds();
+	if (bounds.size() != dim)
+		throw std::invalid_argument("The area must bound every coordinate of the function.");
+	sRing.assign(memory * dim, 0.0);
+	yRing.assign(memory * dim, 0.0);
+	ss.assign(memory * memory, 0.0);
+	sy.assign(memory * memory, 0.0);
+	resetMemory();
+	VectorX x(dim, 0.0), grad(dim, 0.0), xBar(dim, 0.0), direction(dim, 0.0), trial(dim, 0.0), s(dim, 0.0), y(dim, 0.0);
+	TransferData data;
+	data.setFunc(f);
+	data.setIterNum(0);
+	data.setPoints(points);
+	data.setBounds(bounds);
+	IterationTimer<Observed> timer(observer);
+	auto describe = [this, &data]
+	{
+		return IterationInfo{data.getIterNum(), data.getPrevValue(), norm(points.back() - points[points.size() - 2])};
+	};
+	while (!checkCriteria(criteria, data))
+	{
+		timer.mark(IterationPhase::Criteria);
+		data.setIterNum(data.getIterNum() + 1);
+		x = points.back();
+		grad = data.getCurrGrad();
+		double value = data.getCurrValue();
+		timer.mark(IterationPhase::Evaluation);
+		modelStep(x, grad, bounds, xBar);
+		direction = xBar - x;
+		double slope = dot(grad.data(), direction.data(), dim);
+		if (!(slope < 0) && count > 0)
+		{
+			// Rounding can spoil the model; restart from steepest descent.
+			resetMemory();
+			modelStep(x, grad, bounds, xBar);
+			direction = xBar - x;
+			slope = dot(grad.data(), direction.data(), dim);
+		}
+		timer.mark(IterationPhase::Other);
+
+		// Both x and xBar lie in the box, so the projection only removes rounding.
+		double step = count == 0 ? std::min(1.0, 1 / norm(direction)) : 1;
+		Evaluation eval;
+		bool accepted = false;
+		for (size_t backtracks = 0; slope < 0 && !accepted && backtracks <= maxBacktracks; ++backtracks)
+		{
+			for (size_t i = 0; i < dim; ++i)
+				trial[i] = std::clamp(x[i] + step * direction[i], bounds[i].first, bounds[i].second);
+			s = trial - x;
+			eval = f.evaluate(trial, true);
+			accepted = std::isfinite(eval.value) && eval.value <= value + c1 * dot(grad.data(), s.data(), dim);
+			step /= 2;
+		}
+		timer.mark(IterationPhase::LineSearch);
+		if (!accepted)
+		{
+			// No descent is possible at this precision: stay, so the criteria see a zero step.
+			resetMemory();
+			points.push_back(x);
+			data.setCurrEval({value, grad});
+			timer.finish(describe);
+			continue;
+		}
+		y = eval.grad - grad;
+		points.push_back(trial);
+		data.setCurrEval(eval);
+		if (dot(s.data(), y.data(), dim) > std::numeric_limits<double>::epsilon() * dot(y.data(), y.data(), dim))
+			storePair(s, y);
+		timer.finish(describe);
+	}
+	iterMade = data.getIterNum();
+	stats = threadRunStats - begin;
+}
+
+void LBFGSB::modelStep(const VectorX &x, const VectorX &g, const std::vector<std::pair<double, double>> &bounds, VectorX &xBar)
+{
+	const size_t k2 = 2 * count;
+	std::vector<double> &breakpoint = work.breakpoint, &d = work.d, &p = work.p, &c = work.c, &mp = work.mp, &mc = work.mc, &w = work.w, &mw = work.mw;
+	std::vector<size_t> &order = work.order;
+	breakpoint.resize(dim);
+	d.resize(dim);
+	p.resize(k2);
+	c.assign(k2, 0.0);
+	mp.resize(k2);
+	mc.resize(k2);
+	w.resize(k2);
+	mw.resize(k2);
+	order.clear();
+	xBar = x;
+
+	// Generalized Cauchy point: the first local minimizer of the model along
+	// the path x - t * g projected onto the box. Coordinates leave the path at
+	// their breakpoints, in increasing order.
+	for (size_t i = 0; i < dim; ++i)
+	{
+		if (g[i] < 0)
+			breakpoint[i] = (x[i] - bounds[i].second) / g[i];
+		else if (g[i] > 0)
+			breakpoint[i] = (x[i] - bounds[i].first) / g[i];
+		else
+			breakpoint[i] = INFINITY;
+		d[i] = breakpoint[i] > 0 ? -g[i] : 0;
+		if (breakpoint[i] > 0 && std::isfinite(breakpoint[i]))
+			order.push_back(i);
+	}
+	double dd = dot(d.data(), d.data(), dim);
+	if (dd == 0)
+		return;
+	std::sort(order.begin(), order.end(), [&breakpoint](size_t a, size_t b)
+			  { return breakpoint[a] < breakpoint[b]; });
+	multiplyWt(d.data(), p.data());
+	multiplyM(p.data(), mp.data());
+	// First and second derivatives of the model along the current segment.
+	double fp = -dd;
+	double fpp = theta * dd - dot(p.data(), mp.data(), k2);
+	const double fppMin = std::numeric_limits<double>::epsilon() * fpp;
+	double dtMin = -fp / fpp;
+	double tOld = 0;
+	for (size_t b : order)
+	{
+		double dt = breakpoint[b] - tOld;
+		if (dtMin < dt)
+			break;
+		xBar[b] = d[b] > 0 ? bounds[b].second : bounds[b].first;
+		double zb = xBar[b] - x[b];
+		double gb = g[b];
+		for (size_t j = 0; j < k2; ++j)
+			c[j] += dt * p[j];
+		rowOfW(b, w.data());
+		multiplyM(c.data(), mc.data());
+		multiplyM(p.data(), mp.data());
+		multiplyM(w.data(), mw.data());
+		fp += dt * fpp + gb * gb + theta * gb * zb - gb * dot(w.data(), mc.data(), k2);
+		fpp -= theta * gb * gb + 2 * gb * dot(w.data(), mp.data(), k2) + gb * gb * dot(w.data(), mw.data(), k2);
+		fpp = std::max(fpp, fppMin);
+		for (size_t j = 0; j < k2; ++j)
+			p[j] += gb * w[j];
+		d[b] = 0;
+		dtMin = -fp / fpp;
+		tOld = breakpoint[b];
+	}
+	dtMin = std::max(dtMin, 0.0);
+	tOld += dtMin;
+	for (size_t i = 0; i < dim; ++i)
+		if (d[i] != 0)
+			xBar[i] = x[i] + tOld * d[i];
+	for (size_t j = 0; j < k2; ++j)
+		c[j] += dtMin * p[j];
+
+	// Subspace minimization: minimize the model over the coordinates the
+	// Cauchy point left strictly inside the box, then step back into the box.
+	std::vector<size_t> &freeVars = work.freeVars;
+	freeVars.clear();
+	for (size_t i = 0; i < dim; ++i)
+		if (xBar[i] > bounds[i].first && xBar[i] < bounds[i].second)
+			freeVars.push_back(i);
+	if (freeVars.empty())
+		return;
+	multiplyM(c.data(), mc.data());
+	std::vector<double> &r = work.r, &wtzr = work.wtzr, &a = work.a, &v = work.v;
+	r.resize(freeVars.size());
+	wtzr.assign(k2, 0.0);
+	a.assign(k2 * k2, 0.0);
+	v.assign(k2, 0.0);
+	for (size_t f = 0; f < freeVars.size(); ++f)
+	{
+		size_t i = freeVars[f];
+		rowOfW(i, w.data());
+		r[f] = g[i] + theta * (xBar[i] - x[i]) - dot(w.data(), mc.data(), k2);
+		for (size_t j = 0; j < k2; ++j)
+		{
+			wtzr[j] += w[j] * r[f];
+			for (size_t l = 0; l < k2; ++l)
+				a[j * k2 + l] += w[j] * w[l];
+		}
+	}
+	if (k2 > 0)
+	{
+		// The reduced model theta * I - Z^T W M W^T Z is inverted with the
+		// Sherman-Morrison-Woodbury formula, leaving a 2k x 2k system.
+		std::vector<double> &n = work.n, &nInverse = work.inverse;
+		n.resize(k2 * k2);
+		for (size_t row = 0; row < k2; ++row)
+			for (size_t col = 0; col < k2; ++col)
+			{
+				double ma = 0;
+				for (size_t l = 0; l < k2; ++l)
+					ma += middle[row * k2 + l] * a[l * k2 + col];
+				n[row * k2 + col] = (row == col ? 1 : 0) - ma / theta;
+			}
+		multiplyM(wtzr.data(), mw.data());
+		if (invertMatrix(n, nInverse, k2))
+			for (size_t row = 0; row < k2; ++row)
+				v[row] = dot(&nInverse[row * k2], mw.data(), k2);
+	}
+	double maxStep = 1;
+	std::vector<double> &du = work.du;
+	du.resize(freeVars.size());
+	for (size_t f = 0; f < freeVars.size(); ++f)
+	{
+		size_t i = freeVars[f];
+		rowOfW(i, w.data());
+		du[f] = -r[f] / theta - dot(w.data(), v.data(), k2) / (theta * theta);
+		if (du[f] > 0)
+			maxStep = std::min(maxStep, (bounds[i].second - xBar[i]) / du[f]);
+		else if (du[f] < 0)
+			maxStep = std::min(maxStep, (bounds[i].first - xBar[i]) / du[f]);
+	}
+	for (size_t f = 0; f < freeVars.size(); ++f)
+		xBar[freeVars[f]] += maxStep * du[f];
+}
+
+bool LBFGSB::storePair(const VectorX &s, const VectorX &y)
+{
+	size_t q = head;
+	std::copy(s.begin(), s.end(), sRing.begin() + q * dim);
+	std::copy(y.begin(), y.end(), yRing.begin() + q * dim);
+	head = (head + 1) % memory;
+	count = std::min(count + 1, memory);
+	const double *sq = &sRing[q * dim];
+	const double *yq = &yRing[q * dim];
+	for (size_t j = 0; j < count; ++j)
+	{
+		size_t r = slot(j);
+		ss[q * memory + r] = ss[r * memory + q] = dot(sq, &sRing[r * dim], dim);
+		sy[q * memory + r] = dot(sq, &yRing[r * dim], dim);
+		sy[r * memory + q] = dot(&sRing[r * dim], yq, dim);
+	}
+	theta = dot(yq, yq, dim) / sy[q * memory + q];
+	if (buildMiddle())
+		return true;
+	resetMemory();
+	return false;
+}
+
+void LBFGSB::resetMemory()
+{
+	head = 0;
+	count = 0;
+	theta = 1;
+	middle.clear();
+}
+
+bool LBFGSB::buildMiddle()
+{
+	// M = [[-D, L^T], [L, theta * S^T S]]^-1 with D the diagonal and L the
+	// strictly lower triangle of S^T Y, pairs ordered from the oldest.
+	size_t k2 = 2 * count;
+	std::vector<double> &k = work.a;
+	k.assign(k2 * k2, 0.0);
+	for (size_t i = 0; i < count; ++i)
+		for (size_t j = 0; j < count; ++j)
+		{
+			double sIyJ = sy[slot(i) * memory + slot(j)];
+			if (i == j)
+				k[i * k2 + i] = -sIyJ;
+			else if (i > j)
+			{
+				k[(count + i) * k2 + j] = sIyJ;
+				k[j * k2 + count + i] = sIyJ;
+			}
+			k[(count + i) * k2 + count + j] = theta * ss[slot(i) * memory + slot(j)];
+		}
+	return invertMatrix(k, middle, k2);
+}
+
+size_t LBFGSB::slot(size_t j) const
+{
+	return (head + memory - count + j) % memory;
+}
+
+void LBFGSB::multiplyWt(const double *v, double *out) const
+{
+	for (size_t j = 0; j < count; ++j)
+	{
+		out[j] = dot(&yRing[slot(j) * dim], v, dim);
+		out[count + j] = theta * dot(&sRing[slot(j) * dim], v, dim);
+	}
+}
+
+void LBFGSB::rowOfW(size_t i, double *out) const
+{
+	for (size_t j = 0; j < count; ++j)
+	{
+		out[j] = yRing[slot(j) * dim + i];
+		out[count + j] = theta * sRing[slot(j) * dim + i];
+	}
+}
+
+void LBFGSB::multiplyM(const double *v, double *out) const
+{
+	size_t k2 = 2 * count;
+	for (size_t row = 0; row < k2; ++row)
+		out[row] = dot(&middle[row * k2], v, k2);
+}
+
+std::string LBFGSB::getName()
+{
+	return "LBFGSB";
+}
+
+std::shared_ptr<OptimizationMethod> LBFGSB::clone() const
+{
+	return std::make_shared<LBFGSB>(*this);
+}
+
+NewtonCG::NewtonCG(size_t maxCgIter, double c1, size_t maxBacktracks)
+	: OptimizationMethod(), maxCgIter(maxCgIter), c1(c1), maxBacktracks(maxBacktracks)
+{
+	if (!(0 < c1 && c1 < 1))
+		throw std::invalid_argument("Sufficient decrease constant must lie in (0, 1).");
+}
+
+NewtonCG::~NewtonCG()
+{
+}
+
+void NewtonCG::optimise(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	VectorPoolScope pool;
+	if (observer)
+		optimiseLoop<true>(startPoint, area, f, criteria);
+	else
+		optimiseLoop<false>(startPoint, area, f, criteria);
+}
+
+template <bool Observed>
+void NewtonCG::optimiseLoop(const VectorX &startPoint, Area &area, const Function &f, const StopCriteria &criteria)
+{
+	RunStats begin = threadRunStats;
+	points.clear();
+	points.push_back(startPoint);
+	size_t dim = f.getDim();
+	const std::vector<std::pair<double, double>> &bounds = area.getBounds();
+	if (bounds.size() != dim)
+		throw std::invalid_argument("The area must bound every coordinate of the function.");
+	VectorX x(dim, 0.0), grad(dim, 0.0), step(dim, 0.0), trial(dim, 0.0), s(dim, 0.0), free(dim, 1.0);
+	TransferData data;
+	data.setFunc(f);
+	data.setIterNum(0);
+	data.setPoints(points);
+	data.setBounds(bounds);
+	IterationTimer<Observed> timer(observer);
+	auto describe = [this, &data]
+	{
+		return IterationInfo{data.getIterNum(), data.getPrevValue(), norm(points.back() - points[points.size() - 2])};
+	};
+	while (!checkCriteria(criteria, data))
+	{
+		timer.mark(IterationPhase::Criteria);
+		data.setIterNum(data.getIterNum() + 1);
+		x = points.back();
+		grad = data.getCurrGrad();
+		double value = data.getCurrValue();
+		// A variable on a bound whose gradient points out of the area is held
+		// there, and the Newton system is solved over the others. The width of
+		// the bound test shrinks with the projected gradient, so near a
+		// minimum only the truly active variables are held.
+		double projected = 0;
+		for (size_t i = 0; i < dim; ++i)
+		{
+			double move = std::clamp(x[i] - grad[i], bounds[i].first, bounds[i].second) - x[i];
+			projected += move * move;
+		}
+		double eps = std::min(1e-3, std::sqrt(projected));
+		for (size_t i = 0; i < dim; ++i)
+		{
+			bool held = (x[i] <= bounds[i].first + eps && grad[i] > 0) || (x[i] >= bounds[i].second - eps && grad[i] < 0);
+			free[i] = held ? 0.0 : 1.0;
+		}
+		solveNewton(f, x, grad, free, step);
+		timer.mark(IterationPhase::Evaluation);
+
+		double t = 1;
+		Evaluation eval;
+		bool accepted = false;
+		for (size_t backtracks = 0; !accepted && backtracks <= maxBacktracks; ++backtracks, t /= 2)
+		{
+			for (size_t i = 0; i < dim; ++i)
+				trial[i] = std::clamp(x[i] + t * step[i], bounds[i].first, bounds[i].second);
+			s = trial - x;
+			// The projection can turn a descent step into an ascent one.
+			double slope = dot(grad.data(), s.data(), dim);
+			if (!(slope < 0))
+				continue;
+			eval = f.evaluate(trial, true);
+			accepted = std::isfinite(eval.value) && eval.value <= value + c1 * slope;
+		}
+		timer.mark(IterationPhase::LineSearch);
+		if (!accepted)
+		{
+			// No descent is possible at this precision: stay, so the criteria see a zero step.
+			points.push_back(x);
+			data.setCurrEval({value, grad});
+			timer.finish(describe);
+			continue;
+		}
+		points.push_back(trial);
+		data.setCurrEval(eval);
+		timer.finish(describe);
+	}
+	iterMade = data.getIterNum();
+	stats = threadRunStats - begin;
+}
+
+void NewtonCG::solveNewton(const Function &f, const VectorX &x, const VectorX &grad, const VectorX &free, VectorX &step) const
+{
+	size_t dim = x.size();
+	const VectorKernels &kernels = vectorKernels();
+	std::fill(step.begin(), step.end(), 0.0);
+	VectorX r(dim, 0.0);
+	for (size_t i = 0; i < dim; ++i)
+		r[i] = grad[i] * free[i];
+	double gradNorm = norm(r);
+	double tolerance = std::min(0.5, gradNorm) * gradNorm;
+	VectorX d(r);
+	kernels.scale(d.data(), -1, dim);
+	double rr = dot(r.data(), r.data(), dim);
+	size_t maxIter = maxCgIter ? maxCgIter : dim;
+	for (size_t j = 0; j < maxIter && std::sqrt(rr) > tolerance; ++j)
+	{
+		VectorX hd = f.hessVec(x, d);
+		for (size_t i = 0; i < dim; ++i)
+			hd[i] *= free[i];
+		double curvature = dot(d.data(), hd.data(), dim);
+		if (!(curvature > 0))
+		{
+			// The model is not convex along d: keep the step found so far, or
+			// fall back to steepest descent if there is none, scaled by the
+			// magnitude of the curvature so the unit step is sensible.
+			if (j == 0)
+			{
+				step = d;
+				if (curvature < 0)
+					kernels.scale(step.data(), rr / -curvature, dim);
+			}
+			return;
+		}
+		double alpha = rr / curvature;
+		kernels.axpy(step.data(), alpha, d.data(), dim);
+		kernels.axpy(r.data(), alpha, hd.data(), dim);
+		double rrNext = dot(r.data(), r.data(), dim);
+		kernels.scale(d.data(), rrNext / rr, dim);
+		kernels.sub(d.data(), r.data(), dim);
+		rr = rrNext;
+	}
+}
+
+std::string NewtonCG::getName()
+{
+	return "NewtonCG";
+}
+
+std::shared_ptr<OptimizationMethod> NewtonCG::clone() const
+{
+	return std::make_shared<NewtonCG>(*this);
+}
@@ -0,0 +1,885 @@
+#include "ParsedFunction.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace
+{
+    /**
+     * \brief The kinds of tokens of a formula.
+     */
+    enum class TokenKind
+    {
+        Number,     ///< A number literal.
+        Identifier, ///< A variable, function or constant name.
+        Operator,   ///< One of + - * / ^.
+        LeftParen,  ///< (.
+        RightParen, ///< ).
+        End,        ///< The end of the formula.
+    };
+
+    /**
+     * \struct Token
+     * \brief A token of a formula.
+     */
+    struct Token
+    {
+        TokenKind kind;   ///< The kind of the token.
+        std::string text; ///< The text of the token.
+        double number;    ///< The value of a number literal.
+        size_t pos;       ///< The position in the formula, for error messages.
+    };
+
+    const uint32_t noNode = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * \brief Whether an operation takes a single operand.
+     */
+    bool isUnary(ExprOp op)
+    {
+        return op >= ExprOp::Neg;
+    }
+
+    /**
+     * \brief Whether a node is a leaf of the graph, computed by no instruction.
+     */
+    bool isLeaf(ExprOp op)
+    {
+        return op == ExprOp::Variable || op == ExprOp::Constant;
+    }
+
+    /**
+     * \brief Apply an operation to numbers. Constant folding and the
+     * interpreters share it, so folded and run-time results agree.
+     */
+    inline double apply(ExprOp op, double a, double b)
+    {
+        switch (op)
+        {
+        case ExprOp::Add:
+            return a + b;
+        case ExprOp::Sub:
+            return a - b;
+        case ExprOp::Mul:
+            return a * b;
+        case ExprOp::Div:
+            return a / b;
+        case ExprOp::Pow:
+            return std::pow(a, b);
+        case ExprOp::Neg:
+            return -a;
+        case ExprOp::Sin:
+            return std::sin(a);
+        case ExprOp::Cos:
+            return std::cos(a);
+        case ExprOp::Tan:
+            return std::tan(a);
+        case ExprOp::Exp:
+            return std::exp(a);
+        case ExprOp::Log:
+            return std::log(a);
+        case ExprOp::Sqrt:
+            return std::sqrt(a);
+        case ExprOp::Abs:
+            return std::abs(a);
+        case ExprOp::Sign:
+            return (a > 0) - (a < 0);
+        case ExprOp::Variable:
+        case ExprOp::Constant:
+            break;
+        }
+        return 0;
+    }
+
+    /**
+     * \struct ExprNode
+     * \brief A node of the expression graph.
+     */
+    struct ExprNode
+    {
+        ExprOp op;    ///< The operation.
+        uint32_t lhs; ///< The first operand, or the index of a variable.
+        uint32_t rhs; ///< The second operand, 0 for unary operations.
+        double value; ///< The value of a constant.
+    };
+
+    /**
+     * \class ExprGraph
+     * \brief Expression graph with constant folding and hash consing.
+     *
+     * Nodes are created through make(), which folds operations on constants,
+     * applies algebraic identities and returns the existing node for an
+     * expression that was built before. Operands always precede the nodes
+     * that use them, so the order of creation is a topological order.
+     */
+    class ExprGraph
+    {
+    public:
+        std::vector<ExprNode> nodes; ///< The nodes in the order of creation.
+
+        uint32_t constant(double value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return intern({ExprOp::Constant, 0, 0, value}, bits);
+        }
+
+        uint32_t variable(uint32_t index)
+        {
+            return intern({ExprOp::Variable, index, 0, 0}, 0);
+        }
+
+        /**
+         * \brief Find the node of a variable.
+         *
+         * \return The node, noNode if the variable is not used.
+         */
+        uint32_t findVariable(uint32_t index) const
+        {
+            auto it = expressions.find({ExprOp::Variable, index, 0, 0});
+            return it == expressions.end() ? noNode : it->second;
+        }
+
+        uint32_t make(ExprOp op, uint32_t lhs, uint32_t rhs = 0)
+        {
+            if (isUnary(op))
+                rhs = 0;
+            bool lhsConstant = nodes[lhs].op == ExprOp::Constant;
+            bool rhsConstant = !isUnary(op) && nodes[rhs].op == ExprOp::Constant;
+            if (lhsConstant && (isUnary(op) || rhsConstant))
+                return constant(apply(op, nodes[lhs].value, isUnary(op) ? 0 : nodes[rhs].value));
+            switch (op)
+            {
+            case ExprOp::Add:
+                if (is(lhs, 0))
+                    return rhs;
+                if (is(rhs, 0))
+                    return lhs;
+                if (lhs > rhs)
+                    std::swap(lhs, rhs);
+                break;
+            case ExprOp::Sub:
+                if (is(rhs, 0))
+                    return lhs;
+                if (is(lhs, 0))
+                    return make(ExprOp::Neg, rhs);
+                if (lhs == rhs)
+                    return constant(0);
+                break;
+            case ExprOp::Mul:
+                if (is(lhs, 0) || is(rhs, 0))
+                    return constant(0);
+                if (is(lhs, 1))
+                    return rhs;
+                if (is(rhs, 1))
+                    return lhs;
+                if (is(lhs, -1))
+                    return make(ExprOp::Neg, rhs);
+                if (is(rhs, -1))
+                    return make(ExprOp::Neg, lhs);
+                if (lhs > rhs)
+                    std::swap(lhs, rhs);
+                break;
+            case ExprOp::Div:
+                if (is(rhs, 1))
+                    return lhs;
+                if (is(lhs, 0))
+                    return constant(0);
+                break;
+            case ExprOp::Pow:
+                if (rhsConstant)
+                    return power(lhs, nodes[rhs].value, rhs);
+                break;
+            case ExprOp::Neg:
+                if (nodes[lhs].op == ExprOp::Neg)
+                    return nodes[lhs].lhs;
+                break;
+            default:
+                break;
+            }
+            return intern({op, lhs, rhs, 0}, 0);
+        }
+
+    private:
+        using Key = std::tuple<ExprOp, uint32_t, uint32_t, uint64_t>;
+
+        std::map<Key, uint32_t> expressions; ///< The node of every expression built so far.
+
+        uint32_t intern(const ExprNode &node, uint64_t valueBits)
+        {
+            auto [it, inserted] = expressions.emplace(Key{node.op, node.lhs, node.rhs, valueBits}, static_cast<uint32_t>(nodes.size()));
+            if (inserted)
+                nodes.push_back(node);
+            return it->second;
+        }
+
+        bool is(uint32_t node, double value) const
+        {
+            return nodes[node].op == ExprOp::Constant && nodes[node].value == value;
+        }
+
+        /**
+         * \brief base ^ exponent for a constant exponent. Small integer powers
+         * become multiplications by repeated squaring and 0.5 a square root.
+         */
+        uint32_t power(uint32_t base, double exponent, uint32_t exponentNode)
+        {
+            if (exponent == 0)
+                return constant(1);
+            if (exponent == 0.5)
+                return make(ExprOp::Sqrt, base);
+            if (exponent != std::trunc(exponent) || std::abs(exponent) > 64)
+                return intern({ExprOp::Pow, base, exponentNode, 0}, 0);
+            uint32_t result = noNode;
+            for (auto k = static_cast<uint64_t>(std::abs(exponent)); k > 0; k >>= 1)
+            {
+                if (k & 1)
+                    result = result == noNode ? base : make(ExprOp::Mul, result, base);
+                if (k > 1)
+                    base = make(ExprOp::Mul, base, base);
+            }
+            return exponent < 0 ? make(ExprOp::Div, constant(1), result) : result;
+        }
+    };
+
+    std::vector<Token> tokenize(const std::string &formula)
+    {
+        std::vector<Token> tokens;
+        size_t i = 0;
+        while (i < formula.size())
+        {
+            char c = formula[i];
+            if (std::isspace(static_cast<unsigned char>(c)))
+            {
+                ++i;
+                continue;
+            }
+            size_t start = i;
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+            {
+                while (i < formula.size() && (std::isdigit(static_cast<unsigned char>(formula[i])) || formula[i] == '.'))
+                    ++i;
+                // An exponent only if digits follow, so that 2e reads as 2 * e.
+                if (i < formula.size() && (formula[i] == 'e' || formula[i] == 'E'))
+                {
+                    size_t j = i + 1;
+                    if (j < formula.size() && (formula[j] == '+' || formula[j] == '-'))
+                        ++j;
+                    if (j < formula.size() && std::isdigit(static_cast<unsigned char>(formula[j])))
+                    {
+                        i = j;
+                        while (i < formula.size() && std::isdigit(static_cast<unsigned char>(formula[i])))
+                            ++i;
+                    }
+                }
+                std::string text = formula.substr(start, i - start);
+                size_t used = 0;
+                double number = 0;
+                try
+                {
+                    number = std::stod(text, &used);
+                }
+                catch (const std::exception &)
+                {
+                    used = 0;
+                }
+                if (used != text.size())
+                    throw std::invalid_argument("Malformed number " + text + " at position " + std::to_string(start + 1) + " of the formula.");
+                tokens.push_back({TokenKind::Number, text, number, start});
+            }
+            else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+            {
+                while (i < formula.size() && (std::isalnum(static_cast<unsigned char>(formula[i])) || formula[i] == '_'))
+                    ++i;
+                tokens.push_back({TokenKind::Identifier, formula.substr(start, i - start), 0, start});
+            }
+            else if (std::strchr("+-*/^", c))
+            {
+                tokens.push_back({TokenKind::Operator, std::string(1, c), 0, start});
+                ++i;
+            }
+            else if (c == '(' || c == ')')
+            {
+                tokens.push_back({c == '(' ? TokenKind::LeftParen : TokenKind::RightParen, std::string(1, c), 0, start});
+                ++i;
+            }
+            else
+                throw std::invalid_argument("Unexpected character '" + std::string(1, c) + "' at position " + std::to_string(start + 1) + " of the formula.");
+        }
+        tokens.push_back({TokenKind::End, "", 0, formula.size()});
+        return tokens;
+    }
+
+    const std::map<std::string, ExprOp> functions = {
+        {"sin", ExprOp::Sin}, {"cos", ExprOp::Cos}, {"tan", ExprOp::Tan}, {"exp", ExprOp::Exp},
+        {"log", ExprOp::Log}, {"sqrt", ExprOp::Sqrt}, {"abs", ExprOp::Abs}};
+
+    const std::map<std::string, double> constants = {{"pi", 3.14159265358979323846}, {"e", 2.71828182845904523536}};
+
+    /**
+     * \brief Order of the automatically detected variables: x, y, z, w first,
+     * then by name, with numeric suffixes compared as numbers.
+     */
+    bool variableLess(const std::string &a, const std::string &b)
+    {
+        static const std::string conventional[] = {"x", "y", "z", "w"};
+        auto rank = [](const std::string &name)
+        {
+            return std::find(std::begin(conventional), std::end(conventional), name) - std::begin(conventional);
+        };
+        if (rank(a) != rank(b))
+            return rank(a) < rank(b);
+        auto split = [](const std::string &name)
+        {
+            size_t digits = name.find_last_not_of("0123456789") + 1;
+            std::string suffix = name.substr(digits);
+            unsigned long long number = !suffix.empty() && suffix.size() <= 18 ? std::stoull(suffix) : 0;
+            return std::make_tuple(name.substr(0, digits), number, name);
+        };
+        return split(a) < split(b);
+    }
+
+    std::vector<std::string> collectVariables(const std::vector<Token> &tokens)
+    {
+        std::vector<std::string> names;
+        for (const Token &token : tokens)
+        {
+            if (token.kind == TokenKind::Identifier && !functions.count(token.text) && !constants.count(token.text) &&
+                std::find(names.begin(), names.end(), token.text) == names.end())
+                names.push_back(token.text);
+        }
+        std::sort(names.begin(), names.end(), variableLess);
+        return names;
+    }
+
+    /**
+     * \class Parser
+     * \brief Recursive descent parser building an ExprGraph.
+     *
+     * expression := term (('+' | '-') term)*
+     * term       := unary (('*' | '/') unary | power)*
+     * unary      := ('+' | '-') unary | power
+     * power      := primary ('^' unary)?
+     * primary    := number | constant | variable | function '(' expression ')' | '(' expression ')'
+     *
+     * A power directly following a factor is an implicit multiplication, so
+     * 100(y - x^2)^2 reads as 100 * (y - x^2)^2 and 2x^2 as 2 * x^2.
+     */
+    class Parser
+    {
+    public:
+        Parser(const std::vector<Token> &tokens, const std::map<std::string, uint32_t> &variables, ExprGraph &graph)
+            : tokens(tokens), variables(variables), graph(graph), pos(0)
+        {
+        }
+
+        uint32_t parse()
+        {
+            uint32_t node = expression();
+            if (peek().kind != TokenKind::End)
+                fail("Unexpected " + describe(peek()));
+            return node;
+        }
+
+    private:
+        const std::vector<Token> &tokens;
+        const std::map<std::string, uint32_t> &variables;
+        ExprGraph &graph;
+        size_t pos;
+
+        const Token &peek() const
+        {
+            return tokens[pos];
+        }
+
+        bool isOperator(const char *op) const
+        {
+            return peek().kind == TokenKind::Operator && peek().text == op;
+        }
+
+        static std::string describe(const Token &token)
+        {
+            return token.kind == TokenKind::End ? "end of the formula" : "'" + token.text + "'";
+        }
+
+        [[noreturn]] void fail(const std::string &message) const
+        {
+            throw std::invalid_argument(message + " at position " + std::to_string(peek().pos + 1) + " of the formula.");
+        }
+
+        uint32_t expression()
+        {
+            uint32_t node = term();
+            while (isOperator("+") || isOperator("-"))
+            {
+                ExprOp op = isOperator("+") ? ExprOp::Add : ExprOp::Sub;
+                ++pos;
+                node = graph.make(op, node, term());
+            }
+            return node;
+        }
+
+        uint32_t term()
+        {
+            uint32_t node = unary();
+            while (true)
+            {
+                if (isOperator("*") || isOperator("/"))
+                {
+                    ExprOp op = isOperator("*") ? ExprOp::Mul : ExprOp::Div;
+                    ++pos;
+                    node = graph.make(op, node, unary());
+                }
+                else if (peek().kind == TokenKind::Number || peek().kind == TokenKind::Identifier || peek().kind == TokenKind::LeftParen)
+                    node = graph.make(ExprOp::Mul, node, power());
+                else
+                    return node;
+            }
+        }
+
+        uint32_t unary()
+        {
+            if (isOperator("-"))
+            {
+                ++pos;
+                return graph.make(ExprOp::Neg, unary());
+            }
+            if (isOperator("+"))
+            {
+                ++pos;
+                return unary();
+            }
+            return power();
+        }
+
+        uint32_t power()
+        {
+            uint32_t base = primary();
+            if (!isOperator("^"))
+                return base;
+            ++pos;
+            return graph.make(ExprOp::Pow, base, unary());
+        }
+
+        uint32_t parenthesized()
+        {
+            if (peek().kind != TokenKind::LeftParen)
+                fail("Expected '(' instead of " + describe(peek()));
+            ++pos;
+            uint32_t node = expression();
+            if (peek().kind != TokenKind::RightParen)
+                fail("Expected ')' instead of " + describe(peek()));
+            ++pos;
+            return node;
+        }
+
+        uint32_t primary()
+        {
+            const Token &token = peek();
+            switch (token.kind)
+            {
+            case TokenKind::Number:
+                ++pos;
+                return graph.constant(token.number);
+            case TokenKind::LeftParen:
+                return parenthesized();
+            case TokenKind::Identifier:
+            {
+                if (auto var = variables.find(token.text); var != variables.end())
+                {
+                    ++pos;
+                    return graph.variable(var->second);
+                }
+                if (auto function = functions.find(token.text); function != functions.end())
+                {
+                    ++pos;
+                    return graph.make(function->second, parenthesized());
+                }
+                if (auto constant = constants.find(token.text); constant != constants.end())
+                {
+                    ++pos;
+                    return graph.constant(constant->second);
+                }
+                fail("Unknown variable '" + token.text + "'");
+            }
+            default:
+                fail("Unexpected " + describe(token));
+            }
+        }
+    };
+
+    /**
+     * \brief Derive the gradient of a node symbolically, in reverse mode.
+     *
+     * The adjoint of every node is built as an expression in the same graph,
+     * so the gradient reuses the subexpressions of the value and of each
+     * other.
+     *
+     * \return The node of each partial derivative.
+     */
+    std::vector<uint32_t> differentiate(ExprGraph &graph, uint32_t output, size_t dim)
+    {
+        std::vector<uint32_t> adjoints(output + 1, noNode);
+        auto accumulate = [&](uint32_t node, uint32_t term)
+        {
+            adjoints[node] = adjoints[node] == noNode ? term : graph.make(ExprOp::Add, adjoints[node], term);
+        };
+        adjoints[output] = graph.constant(1);
+        for (uint32_t i = output + 1; i-- > 0;)
+        {
+            uint32_t a = adjoints[i];
+            if (a == noNode)
+                continue;
+            // make() may grow the vector, so copy the node.
+            ExprNode node = graph.nodes[i];
+            uint32_t l = node.lhs, r = node.rhs;
+            switch (node.op)
+            {
+            case ExprOp::Variable:
+            case ExprOp::Constant:
+                break;
+            case ExprOp::Add:
+                accumulate(l, a);
+                accumulate(r, a);
+                break;
+            case ExprOp::Sub:
+                accumulate(l, a);
+                accumulate(r, graph.make(ExprOp::Neg, a));
+                break;
+            case ExprOp::Mul:
+                accumulate(l, graph.make(ExprOp::Mul, a, r));
+                accumulate(r, graph.make(ExprOp::Mul, a, l));
+                break;
+            case ExprOp::Div:
+                accumulate(l, graph.make(ExprOp::Div, a, r));
+                accumulate(r, graph.make(ExprOp::Neg, graph.make(ExprOp::Div, graph.make(ExprOp::Mul, a, i), r)));
+                break;
+            case ExprOp::Pow:
+            {
+                uint32_t exponentLess = graph.make(ExprOp::Sub, r, graph.constant(1));
+                accumulate(l, graph.make(ExprOp::Mul, a, graph.make(ExprOp::Mul, r, graph.make(ExprOp::Pow, l, exponentLess))));
+                if (graph.nodes[r].op != ExprOp::Constant)
+                    accumulate(r, graph.make(ExprOp::Mul, a, graph.make(ExprOp::Mul, i, graph.make(ExprOp::Log, l))));
+                break;
+            }
+            case ExprOp::Neg:
+                accumulate(l, graph.make(ExprOp::Neg, a));
+                break;
+            case ExprOp::Sin:
+                accumulate(l, graph.make(ExprOp::Mul, a, graph.make(ExprOp::Cos, l)));
+                break;
+            case ExprOp::Cos:
+                accumulate(l, graph.make(ExprOp::Neg, graph.make(ExprOp::Mul, a, graph.make(ExprOp::Sin, l))));
+                break;
+            case ExprOp::Tan:
+                accumulate(l, graph.make(ExprOp::Mul, a, graph.make(ExprOp::Add, graph.constant(1), graph.make(ExprOp::Mul, i, i))));
+                break;
+            case ExprOp::Exp:
+                accumulate(l, graph.make(ExprOp::Mul, a, i));
+                break;
+            case ExprOp::Log:
+                accumulate(l, graph.make(ExprOp::Div, a, l));
+                break;
+            case ExprOp::Sqrt:
+                accumulate(l, graph.make(ExprOp::Div, graph.make(ExprOp::Mul, graph.constant(0.5), a), i));
+                break;
+            case ExprOp::Abs:
+                accumulate(l, graph.make(ExprOp::Mul, a, graph.make(ExprOp::Sign, l)));
+                break;
+            case ExprOp::Sign:
+                break;
+            }
+        }
+        std::vector<uint32_t> partials(dim);
+        for (uint32_t k = 0; k < dim; ++k)
+        {
+            uint32_t node = graph.findVariable(k);
+            partials[k] = node == noNode || node > output || adjoints[node] == noNode ? graph.constant(0) : adjoints[node];
+        }
+        return partials;
+    }
+
+    /**
+     * \brief Compile the nodes the outputs depend on to register bytecode.
+     *
+     * Registers of intermediate results are reused once their last reader
+     * has run. An instruction never writes to the register of its own
+     * operand, so the lanes of the batch interpreter do not alias.
+     */
+    ParsedFunction::Program compile(const ExprGraph &graph, const std::vector<uint32_t> &outputs, size_t dim)
+    {
+        const std::vector<ExprNode> &nodes = graph.nodes;
+        size_t n = nodes.size();
+        std::vector<bool> live(n, false);
+        for (uint32_t output : outputs)
+            live[output] = true;
+        for (size_t i = n; i-- > 0;)
+        {
+            if (!live[i] || isLeaf(nodes[i].op))
+                continue;
+            live[nodes[i].lhs] = true;
+            if (!isUnary(nodes[i].op))
+                live[nodes[i].rhs] = true;
+        }
+
+        const size_t keep = std::numeric_limits<size_t>::max();
+        std::vector<size_t> lastUse(n, 0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (!live[i] || isLeaf(nodes[i].op))
+                continue;
+            lastUse[nodes[i].lhs] = i;
+            if (!isUnary(nodes[i].op))
+                lastUse[nodes[i].rhs] = i;
+        }
+        for (uint32_t output : outputs)
+            lastUse[output] = keep;
+
+        ParsedFunction::Program program;
+        std::vector<uint32_t> reg(n, noNode);
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (!live[i])
+                continue;
+            if (nodes[i].op == ExprOp::Variable)
+                reg[i] = nodes[i].lhs;
+            else if (nodes[i].op == ExprOp::Constant)
+            {
+                reg[i] = static_cast<uint32_t>(dim + program.constants.size());
+                program.constants.push_back(nodes[i].value);
+            }
+        }
+        program.registersNum = dim + program.constants.size();
+
+        std::vector<uint32_t> freeRegisters;
+        auto release = [&](uint32_t node, size_t user)
+        {
+            if (!isLeaf(nodes[node].op) && lastUse[node] == user)
+            {
+                freeRegisters.push_back(reg[node]);
+                lastUse[node] = keep;
+            }
+        };
+        for (size_t i = 0; i < n; ++i)
+        {
+            const ExprNode &node = nodes[i];
+            if (!live[i] || isLeaf(node.op))
+                continue;
+            uint32_t dst;
+            if (freeRegisters.empty())
+                dst = static_cast<uint32_t>(program.registersNum++);
+            else
+            {
+                dst = freeRegisters.back();
+                freeRegisters.pop_back();
+            }
+            reg[i] = dst;
+            uint32_t lhs = reg[node.lhs];
+            uint32_t rhs = isUnary(node.op) ? lhs : reg[node.rhs];
+            program.code.push_back({node.op, dst, lhs, rhs});
+            release(node.lhs, i);
+            if (!isUnary(node.op))
+                release(node.rhs, i);
+        }
+        for (uint32_t output : outputs)
+            program.outputs.push_back(reg[output]);
+        return program;
+    }
+
+    /**
+     * \brief Run a program on one point whose variables and constants are loaded.
+     */
+    void execute(const ParsedFunction::Program &program, double *regs)
+    {
+        for (const ParsedFunction::Instruction &in : program.code)
+            regs[in.dst] = apply(in.op, regs[in.lhs], regs[in.rhs]);
+    }
+
+    constexpr size_t lanes = 64; ///< The number of points the batch interpreter runs each instruction on.
+
+    template <typename Op>
+    inline void lanewise(double *dst, const double *lhs, const double *rhs, Op op)
+    {
+        for (size_t k = 0; k < lanes; ++k)
+            dst[k] = op(lhs[k], rhs[k]);
+    }
+
+    /**
+     * \brief Run a program on a block of points. Register r of point k is
+     * regs[r * lanes + k].
+     */
+    void executeBlock(const ParsedFunction::Program &program, double *regs)
+    {
+        for (const ParsedFunction::Instruction &in : program.code)
+        {
+            double *d = regs + in.dst * lanes;
+            const double *a = regs + in.lhs * lanes;
+            const double *b = regs + in.rhs * lanes;
+            switch (in.op)
+            {
+            case ExprOp::Add:
+                lanewise(d, a, b, [](double u, double v) { return u + v; });
+                break;
+            case ExprOp::Sub:
+                lanewise(d, a, b, [](double u, double v) { return u - v; });
+                break;
+            case ExprOp::Mul:
+                lanewise(d, a, b, [](double u, double v) { return u * v; });
+                break;
+            case ExprOp::Div:
+                lanewise(d, a, b, [](double u, double v) { return u / v; });
+                break;
+            case ExprOp::Neg:
+                lanewise(d, a, b, [](double u, double) { return -u; });
+                break;
+            case ExprOp::Sqrt:
+                lanewise(d, a, b, [](double u, double) { return std::sqrt(u); });
+                break;
+            case ExprOp::Abs:
+                lanewise(d, a, b, [](double u, double) { return std::abs(u); });
+                break;
+            case ExprOp::Sign:
+                lanewise(d, a, b, [](double u, double) { return double((u > 0) - (u < 0)); });
+                break;
+            default:
+                for (size_t k = 0; k < lanes; ++k)
+                    d[k] = apply(in.op, a[k], b[k]);
+                break;
+            }
+        }
+    }
+
+    /**
+     * \brief The registers of the calling thread, grown once and then reused.
+     */
+    thread_local std::vector<double> registers;
+
+    /**
+     * \brief Load a point and the constants and run a program on it.
+     */
+    double *run(const ParsedFunction::Program &program, const VectorX &x)
+    {
+        if (registers.size() < program.registersNum)
+            registers.resize(program.registersNum);
+        double *regs = registers.data();
+        std::copy(x.begin(), x.end(), regs);
+        std::copy(program.constants.begin(), program.constants.end(), regs + x.size());
+        execute(program, regs);
+        return regs;
+    }
+}
+
+ParsedFunction::ParsedFunction(const std::string &formula, const std::vector<std::string> &variables)
+{
+    std::vector<Token> tokens = tokenize(formula);
+    this->variables = variables.empty() ? collectVariables(tokens) : variables;
+    if (this->variables.empty())
+        throw std::invalid_argument("Formula must have at least one variable.");
+    std::map<std::string, uint32_t> indices;
+    for (size_t i = 0; i < this->variables.size(); ++i)
+    {
+        if (!indices.emplace(this->variables[i], static_cast<uint32_t>(i)).second)
+            throw std::invalid_argument("Variable " + this->variables[i] + " is listed twice.");
+    }
+    dimension = this->variables.size();
+    name = formula;
+
+    ExprGraph graph;
+    uint32_t value = Parser(tokens, indices, graph).parse();
+    std::vector<uint32_t> outputs = differentiate(graph, value, dimension);
+    outputs.insert(outputs.begin(), value);
+    valueProgram = std::make_shared<const Program>(compile(graph, {value}, dimension));
+    gradProgram = std::make_shared<const Program>(compile(graph, outputs, dimension));
+}
+
+ParsedFunction::~ParsedFunction()
+{
+}
+
+double ParsedFunction::calcValue(const VectorX &x) const
+{
+    if (x.size() != dimension)
+    {
+        throw std::invalid_argument("Input vector must have exactly " + std::to_string(dimension) + " elements.");
+    }
+    return run(*valueProgram, x)[valueProgram->outputs[0]];
+}
+
+VectorX ParsedFunction::calcGrad(const VectorX &x) const
+{
+    if (x.size() != dimension)
+    {
+        throw std::invalid_argument("Input vector must have exactly " + std::to_string(dimension) + " elements.");
+    }
+    const double *regs = run(*gradProgram, x);
+    VectorX g(dimension);
+    for (size_t i = 0; i < dimension; ++i)
+        g[i] = regs[gradProgram->outputs[i + 1]];
+    return g;
+}
+
+Evaluation ParsedFunction::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+    if (!wantGrad)
+        return {calcValue(x), VectorX()};
+    if (x.size() != dimension)
+    {
+        throw std::invalid_argument("Input vector must have exactly " + std::to_string(dimension) + " elements.");
+    }
+    const double *regs = run(*gradProgram, x);
+    Evaluation eval{regs[gradProgram->outputs[0]], VectorX(dimension)};
+    for (size_t i = 0; i < dimension; ++i)
+        eval.grad[i] = regs[gradProgram->outputs[i + 1]];
+    return eval;
+}
+
+void ParsedFunction::calcBatch(const PointBatch &points, double *values, PointBatch *grads) const
+{
+    if (points.getDim() != dimension)
+    {
+        throw std::invalid_argument("Points of the batch must have exactly " + std::to_string(dimension) + " elements.");
+    }
+    size_t count = points.getCount();
+    if (grads)
+        grads->resize(dimension, count);
+    const Program &program = grads ? *gradProgram : *valueProgram;
+    if (registers.size() < program.registersNum * lanes)
+        registers.resize(program.registersNum * lanes);
+    double *regs = registers.data();
+    for (size_t c = 0; c < program.constants.size(); ++c)
+        std::fill_n(regs + (dimension + c) * lanes, lanes, program.constants[c]);
+    for (size_t begin = 0; begin < count; begin += lanes)
+    {
+        size_t n = std::min(lanes, count - begin);
+        for (size_t d = 0; d < dimension; ++d)
+        {
+            std::copy_n(points.coord(d) + begin, n, regs + d * lanes);
+            std::fill(regs + d * lanes + n, regs + (d + 1) * lanes, 0.0);
+        }
+        executeBlock(program, regs);
+        std::copy_n(regs + program.outputs[0] * lanes, n, values + begin);
+        if (grads)
+        {
+            for (size_t d = 0; d < dimension; ++d)
+                std::copy_n(regs + program.outputs[d + 1] * lanes, n, grads->coord(d) + begin);
+        }
+    }
+}
+
+std::shared_ptr<Function> ParsedFunction::clone() const
+{
+    return std::make_shared<ParsedFunction>(*this);
+}
+
+const std::vector<std::string> &ParsedFunction::getVariables() const
+{
+    return variables;
+}
+
+size_t ParsedFunction::getProgramSize(bool withGrad) const
+{
+    return (withGrad ? gradProgram : valueProgram)->code.size();
+}
@@ -0,0 +1,200 @@
+#include "RandomEngine.h"
+#include "VectorKernels.h"
+#include <vector>
+
+RandomEngine::RandomEngine()
+{
+}
+
+RandomEngine::~RandomEngine()
+{
+}
+
+void RandomEngine::skipPoints(uint64_t count, size_t dim)
+{
+    std::vector<double> u(dim);
+    for (uint64_t i = 0; i < count; ++i)
+        nextPoint(u.data(), dim);
+}
+
+/**
+ * \brief The splitmix64 generator, used to expand a seed into a state.
+ *
+ * \param x The state of splitmix64, advanced by the call.
+ * \return The next output.
+ */
+static uint64_t splitMix64(uint64_t &x)
+{
+    uint64_t z = x += UINT64_C(0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed)
+{
+    for (uint64_t &word : state)
+        word = splitMix64(seed);
+}
+
+Xoshiro256::~Xoshiro256()
+{
+}
+
+void Xoshiro256::fillUniform(double *u, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        u[i] = uniform();
+}
+
+void Xoshiro256::jump(const uint64_t (&polynomial)[4])
+{
+    uint64_t jumped[4] = {0, 0, 0, 0};
+    for (uint64_t word : polynomial)
+    {
+        for (int bit = 0; bit < 64; ++bit)
+        {
+            if (word & (UINT64_C(1) << bit))
+            {
+                for (int i = 0; i < 4; ++i)
+                    jumped[i] ^= state[i];
+            }
+            (*this)();
+        }
+    }
+    for (int i = 0; i < 4; ++i)
+        state[i] = jumped[i];
+}
+
+void Xoshiro256::jump()
+{
+    static constexpr uint64_t polynomial[4] = {UINT64_C(0x180EC6D33CFD0ABA), UINT64_C(0xD5A61266F0C9392C),
+                                               UINT64_C(0xA9582618E03FC9AA), UINT64_C(0x39ABDC4529B1661C)};
+    jump(polynomial);
+}
+
+void Xoshiro256::longJump()
+{
+    static constexpr uint64_t polynomial[4] = {UINT64_C(0x76E15D3EFEFDCBBF), UINT64_C(0xC5004E441C522FB3),
+                                               UINT64_C(0x77710069854EE241), UINT64_C(0x39109BB02ACBE635)};
+    jump(polynomial);
+}
+
+void Xoshiro256::nextPoint(double *u, size_t dim)
+{
+    fillUniform(u, dim);
+}
+
+std::shared_ptr<RandomEngine> Xoshiro256::clone() const
+{
+    return std::make_shared<Xoshiro256>(*this);
+}
+
+std::string Xoshiro256::getName() const
+{
+    return "xoshiro256++";
+}
+
+Philox4x32::Philox4x32(uint64_t seed, uint64_t stream)
+    : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}, stream(stream), position(0), buffer{0, 0}
+{
+}
+
+Philox4x32::~Philox4x32()
+{
+}
+
+void Philox4x32::block(const uint32_t (&counter)[4], const uint32_t (&key)[2], uint32_t (&out)[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round)
+    {
+        uint64_t p0 = uint64_t(0xD2511F53) * c0;
+        uint64_t p1 = uint64_t(0xCD9E8D57) * c2;
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c0 = n0;
+        c1 = static_cast<uint32_t>(p1);
+        c2 = n2;
+        c3 = static_cast<uint32_t>(p0);
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+/**
+ * \brief Compute the two 64-bit outputs of a block of a stream.
+ */
+static inline void philoxOutputs(uint64_t index, uint64_t stream, const uint32_t (&key)[2], uint64_t &first, uint64_t &second)
+{
+    uint32_t counter[4] = {static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32),
+                           static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+    uint32_t out[4];
+    Philox4x32::block(counter, key, out);
+    first = out[0] | uint64_t(out[1]) << 32;
+    second = out[2] | uint64_t(out[3]) << 32;
+}
+
+Philox4x32::result_type Philox4x32::operator()()
+{
+    if ((position & 1) == 0)
+        philoxOutputs(position >> 1, stream, key, buffer[0], buffer[1]);
+    return buffer[position++ & 1];
+}
+
+double Philox4x32::uniform()
+{
+    return toUnit((*this)());
+}
+
+void Philox4x32::fillUniform(double *u, size_t n)
+{
+    size_t i = 0;
+    if ((position & 1) && n > 0)
+        u[i++] = uniform();
+    // The blocks are independent, so the kernel computes several at once.
+    size_t blocks = (n - i) / 2;
+    vectorKernels().philoxUniform(u + i, blocks, position >> 1, stream, key);
+    position += 2 * blocks;
+    i += 2 * blocks;
+    if (i < n)
+        u[i] = uniform();
+}
+
+void Philox4x32::discard(uint64_t n)
+{
+    position += n;
+    // The second output of a block is read from the buffer.
+    if (position & 1)
+        philoxOutputs(position >> 1, stream, key, buffer[0], buffer[1]);
+}
+
+uint64_t Philox4x32::getPosition() const
+{
+    return position;
+}
+
+void Philox4x32::nextPoint(double *u, size_t dim)
+{
+    fillUniform(u, dim);
+}
+
+void Philox4x32::skipPoints(uint64_t count, size_t dim)
+{
+    discard(count * dim);
+}
+
+std::shared_ptr<RandomEngine> Philox4x32::clone() const
+{
+    return std::make_shared<Philox4x32>(*this);
+}
+
+std::string Philox4x32::getName() const
+{
+    return "Philox4x32-10";
+}
@@ -0,0 +1,32 @@
+#include "RunStats.h"
+
+thread_local constinit RunStats threadRunStats;
+
+RunStats &RunStats::operator+=(const RunStats &other)
+{
+    valueCalls += other.valueCalls;
+    gradCalls += other.gradCalls;
+    criteriaValueCalls += other.criteriaValueCalls;
+    criteriaGradCalls += other.criteriaGradCalls;
+    lineSearchValueCalls += other.lineSearchValueCalls;
+    lineSearchGradCalls += other.lineSearchGradCalls;
+    hessVecCalls += other.hessVecCalls;
+    vectorAllocations += other.vectorAllocations;
+    vectorReuses += other.vectorReuses;
+    return *this;
+}
+
+RunStats operator-(const RunStats &end, const RunStats &begin)
+{
+    RunStats diff;
+    diff.valueCalls = end.valueCalls - begin.valueCalls;
+    diff.gradCalls = end.gradCalls - begin.gradCalls;
+    diff.criteriaValueCalls = end.criteriaValueCalls - begin.criteriaValueCalls;
+    diff.criteriaGradCalls = end.criteriaGradCalls - begin.criteriaGradCalls;
+    diff.lineSearchValueCalls = end.lineSearchValueCalls - begin.lineSearchValueCalls;
+    diff.lineSearchGradCalls = end.lineSearchGradCalls - begin.lineSearchGradCalls;
+    diff.hessVecCalls = end.hessVecCalls - begin.hessVecCalls;
+    diff.vectorAllocations = end.vectorAllocations - begin.vectorAllocations;
+    diff.vectorReuses = end.vectorReuses - begin.vectorReuses;
+    return diff;
+}
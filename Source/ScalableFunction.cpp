@@ -0,0 +1,556 @@
+#include "ScalableFunction.h"
+#include <numbers>
+
+/**
+ * \brief Combine term(begin), ..., term(end - 1) in independent lanes.
+ *
+ * The lanes break the dependency between consecutive operations, so the
+ * compiler can keep them in one vector register. The term may also store
+ * per-element results, such as partial derivatives.
+ */
+template <typename Combine, typename Term>
+static double reduceTerms(size_t begin, size_t end, double identity, Combine combine, Term term)
+{
+    constexpr size_t lanes = 4;
+    double acc[lanes] = {identity, identity, identity, identity};
+    size_t i = begin;
+    for (; i + lanes <= end; i += lanes)
+    {
+        for (size_t l = 0; l < lanes; ++l)
+            acc[l] = combine(acc[l], term(i + l));
+    }
+    double tail = identity;
+    for (; i < end; ++i)
+        tail = combine(tail, term(i));
+    return combine(combine(combine(acc[0], acc[1]), combine(acc[2], acc[3])), tail);
+}
+
+template <typename Term>
+static double sumTerms(size_t begin, size_t end, Term term)
+{
+    return reduceTerms(begin, end, 0.0, [](double a, double b)
+                       { return a + b; }, term);
+}
+
+template <typename Term>
+static double multiplyTerms(size_t begin, size_t end, Term term)
+{
+    return reduceTerms(begin, end, 1.0, [](double a, double b)
+                       { return a * b; }, term);
+}
+
+/**
+ * \brief Round to the nearest integer, ties to even, without a library call.
+ */
+static inline double roundToInteger(double v)
+{
+    constexpr double shift = 4503599627370496.0; // 2^52, above which every double is an integer.
+    double magnitude = std::abs(v);
+    double rounded = (magnitude + shift) - shift;
+    return magnitude < shift ? std::copysign(rounded, v) : v;
+}
+
+/**
+ * \brief Calculate sin(2 pi t) and cos(2 pi t).
+ *
+ * The trigonometric functions of the library are calls, which keep the loops
+ * of the periodic test functions scalar. This inline version reduces t to
+ * the nearest quarter turn exactly, evaluates Taylor polynomials on
+ * [-pi/4, pi/4] and selects the quadrant without branches, so loops that
+ * call it vectorize. The error is within a few units in the last place.
+ */
+static inline void sinCosTurns(double t, double &sine, double &cosine)
+{
+    double quarters = 4 * t;
+    double q = roundToInteger(quarters);
+    double theta = (quarters - q) * (std::numbers::pi / 2);
+    double k = q - 4 * roundToInteger(0.25 * q); // In [-2, 2].
+    double t2 = theta * theta;
+    double s = theta * (1 + t2 * (-1.0 / 6 + t2 * (1.0 / 120 + t2 * (-1.0 / 5040 + t2 * (1.0 / 362880 + t2 * (-1.0 / 39916800 + t2 * (1.0 / 6227020800 + t2 * (-1.0 / 1307674368000))))))));
+    double c = 1 + t2 * (-0.5 + t2 * (1.0 / 24 + t2 * (-1.0 / 720 + t2 * (1.0 / 40320 + t2 * (-1.0 / 3628800 + t2 * (1.0 / 479001600 + t2 * (-1.0 / 87178291200 + t2 * (1.0 / 20922789888000))))))));
+    double quadrant = k < 0 ? k + 4 : k;
+    bool odd = std::abs(k) == 1;
+    double sinAbs = odd ? c : s;
+    double cosAbs = odd ? s : c;
+    sine = quadrant >= 2 ? -sinAbs : sinAbs;
+    cosine = std::abs(quadrant - 1.5) < 1 ? -cosAbs : cosAbs;
+}
+
+ScalableFunction::ScalableFunction(const std::string &name, size_t dim, size_t minDim)
+{
+    if (dim < minDim)
+    {
+        throw std::invalid_argument(name + " requires at least " + std::to_string(minDim) + " dimensions.");
+    }
+    dimension = dim;
+    this->name = name + " (n = " + std::to_string(dim) + ")";
+}
+
+ScalableFunction::~ScalableFunction()
+{
+}
+
+void ScalableFunction::checkDim(const VectorX &x) const
+{
+    if (x.size() != dimension)
+    {
+        throw std::invalid_argument("Input vector must have exactly " + std::to_string(dimension) + " elements.");
+    }
+}
+
+double ScalableFunction::calcValue(const VectorX &x) const
+{
+    checkDim(x);
+    return compute(x.data(), nullptr);
+}
+
+VectorX ScalableFunction::calcGrad(const VectorX &x) const
+{
+    checkDim(x);
+    VectorX grad(dimension);
+    compute(x.data(), grad.data());
+    return grad;
+}
+
+Evaluation ScalableFunction::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+    checkDim(x);
+    if (!wantGrad)
+        return {compute(x.data(), nullptr), VectorX()};
+    Evaluation eval{0.0, VectorX(dimension)};
+    eval.value = compute(x.data(), eval.grad.data());
+    return eval;
+}
+
+RosenbrockFunction::RosenbrockFunction(size_t dim) : ScalableFunction("Rosenbrock", dim, 2)
+{
+}
+
+RosenbrockFunction::~RosenbrockFunction()
+{
+}
+
+double RosenbrockFunction::compute(const double *x, double *grad) const
+{
+    // The first term is summed apart in both paths so that they round alike.
+    size_t n = dimension;
+    double a0 = 1 - x[0];
+    double b0 = x[1] - x[0] * x[0];
+    double value = a0 * a0 + 100 * b0 * b0;
+    if (!grad)
+    {
+        return value + sumTerms(1, n - 1, [x](size_t i)
+                                {
+            double a = 1 - x[i];
+            double b = x[i + 1] - x[i] * x[i];
+            return a * a + 100 * b * b; });
+    }
+    // Coordinate i appears in term i as x_i and in term i - 1 as x_{i+1}.
+    // Recomputing the previous term keeps the iterations independent.
+    grad[0] = -400 * x[0] * b0 - 2 * a0;
+    value += sumTerms(1, n - 1, [x, grad](size_t i)
+                      {
+        double a = 1 - x[i];
+        double b = x[i + 1] - x[i] * x[i];
+        double prev = x[i] - x[i - 1] * x[i - 1];
+        grad[i] = -400 * x[i] * b - 2 * a + 200 * prev;
+        return a * a + 100 * b * b; });
+    grad[n - 1] = 200 * (x[n - 1] - x[n - 2] * x[n - 2]);
+    return value;
+}
+
+VectorX RosenbrockFunction::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+    checkDim(x);
+    checkDim(v);
+    size_t n = dimension;
+    VectorX hv(n);
+    hv[0] = (1200 * x[0] * x[0] - 400 * x[1] + 2) * v[0] - 400 * x[0] * v[1];
+    for (size_t i = 1; i + 1 < n; ++i)
+    {
+        double diagonal = 1200 * x[i] * x[i] - 400 * x[i + 1] + 202;
+        hv[i] = diagonal * v[i] - 400 * x[i] * v[i + 1] - 400 * x[i - 1] * v[i - 1];
+    }
+    hv[n - 1] = 200 * v[n - 1] - 400 * x[n - 2] * v[n - 2];
+    return hv;
+}
+
+std::shared_ptr<Function> RosenbrockFunction::clone() const
+{
+    return std::make_shared<RosenbrockFunction>(*this);
+}
+
+double RosenbrockFunction::getMinValue() const
+{
+    return 0.0;
+}
+
+VectorX RosenbrockFunction::getMinimizer() const
+{
+    return VectorX(dimension, 1.0);
+}
+
+double RosenbrockFunction::getDomainBound() const
+{
+    return 2.048;
+}
+
+RastriginFunction::RastriginFunction(size_t dim) : ScalableFunction("Rastrigin", dim)
+{
+}
+
+RastriginFunction::~RastriginFunction()
+{
+}
+
+double RastriginFunction::compute(const double *x, double *grad) const
+{
+    constexpr double omega = 2 * std::numbers::pi;
+    double sum;
+    if (!grad)
+    {
+        sum = sumTerms(0, dimension, [x](size_t i)
+                       {
+            double sine, cosine;
+            sinCosTurns(x[i], sine, cosine);
+            return x[i] * x[i] - 10 * cosine; });
+    }
+    else
+    {
+        sum = sumTerms(0, dimension, [x, grad](size_t i)
+                       {
+            double sine, cosine;
+            sinCosTurns(x[i], sine, cosine);
+            grad[i] = 2 * x[i] + 10 * omega * sine;
+            return x[i] * x[i] - 10 * cosine; });
+    }
+    return 10.0 * dimension + sum;
+}
+
+VectorX RastriginFunction::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+    checkDim(x);
+    checkDim(v);
+    constexpr double omega = 2 * std::numbers::pi;
+    VectorX hv(dimension);
+    for (size_t i = 0; i < dimension; ++i)
+    {
+        double sine, cosine;
+        sinCosTurns(x[i], sine, cosine);
+        hv[i] = (2 + 10 * omega * omega * cosine) * v[i];
+    }
+    return hv;
+}
+
+std::shared_ptr<Function> RastriginFunction::clone() const
+{
+    return std::make_shared<RastriginFunction>(*this);
+}
+
+double RastriginFunction::getMinValue() const
+{
+    return 0.0;
+}
+
+VectorX RastriginFunction::getMinimizer() const
+{
+    return VectorX(dimension, 0.0);
+}
+
+double RastriginFunction::getDomainBound() const
+{
+    return 5.12;
+}
+
+AckleyFunction::AckleyFunction(size_t dim) : ScalableFunction("Ackley", dim)
+{
+}
+
+AckleyFunction::~AckleyFunction()
+{
+}
+
+double AckleyFunction::compute(const double *x, double *grad) const
+{
+    constexpr double omega = 2 * std::numbers::pi;
+    double n = static_cast<double>(dimension);
+    double squares = sumTerms(0, dimension, [x](size_t i)
+                              { return x[i] * x[i]; });
+    double cosines;
+    if (!grad)
+    {
+        cosines = sumTerms(0, dimension, [x](size_t i)
+                           {
+            double sine, cosine;
+            sinCosTurns(x[i], sine, cosine);
+            return cosine; });
+    }
+    else
+    {
+        // The sines wait in grad for the factors that need both sums.
+        cosines = sumTerms(0, dimension, [x, grad](size_t i)
+                           {
+            double cosine;
+            sinCosTurns(x[i], grad[i], cosine);
+            return cosine; });
+    }
+    double radius = std::sqrt(squares / n);
+    double funnel = std::exp(-0.2 * radius);
+    double ripples = std::exp(cosines / n);
+    if (grad)
+    {
+        double radial = radius > 0 ? 4 * funnel / (n * radius) : 0.0;
+        double periodic = omega * ripples / n;
+        for (size_t i = 0; i < dimension; ++i)
+            grad[i] = radial * x[i] + periodic * grad[i];
+    }
+    return 20 * (1 - funnel) + (std::numbers::e - ripples);
+}
+
+std::shared_ptr<Function> AckleyFunction::clone() const
+{
+    return std::make_shared<AckleyFunction>(*this);
+}
+
+double AckleyFunction::getMinValue() const
+{
+    return 0.0;
+}
+
+VectorX AckleyFunction::getMinimizer() const
+{
+    return VectorX(dimension, 0.0);
+}
+
+double AckleyFunction::getDomainBound() const
+{
+    return 32.768;
+}
+
+GriewankFunction::GriewankFunction(size_t dim) : ScalableFunction("Griewank", dim)
+{
+    auto f = std::make_shared<std::vector<double>>(dim);
+    for (size_t i = 0; i < dim; ++i)
+        (*f)[i] = 1 / std::sqrt(i + 1.0);
+    frequencies = std::move(f);
+}
+
+GriewankFunction::~GriewankFunction()
+{
+}
+
+/**
+ * \brief The cosines of the Griewank gradient, per thread so that it is allocated once.
+ */
+static thread_local std::vector<double> griewankCosines;
+
+double GriewankFunction::compute(const double *x, double *grad) const
+{
+    // cos(x_i / sqrt(i)) is calculated in turns, t = x_i / (2 pi sqrt(i)).
+    constexpr double turn = 1 / (2 * std::numbers::pi);
+    const double *w = frequencies->data();
+    double squares = sumTerms(0, dimension, [x](size_t i)
+                              { return x[i] * x[i]; });
+    if (!grad)
+    {
+        double product = multiplyTerms(0, dimension, [x, w](size_t i)
+                                       {
+            double sine, cosine;
+            sinCosTurns(x[i] * w[i] * turn, sine, cosine);
+            return cosine; });
+        return 1 + squares / 4000 - product;
+    }
+    // The derivative of the product with respect to x_i is the product of the
+    // other cosines: the prefix before i times the suffix after i. Scanning
+    // both ways avoids dividing by cosines that may vanish.
+    std::vector<double> &cosines = griewankCosines;
+    if (cosines.size() < dimension)
+        cosines.resize(dimension);
+    double *c = cosines.data();
+    for (size_t i = 0; i < dimension; ++i)
+    {
+        sinCosTurns(x[i] * w[i] * turn, grad[i], c[i]);
+        grad[i] *= w[i];
+    }
+    double product = 1.0;
+    for (size_t i = 0; i < dimension; ++i)
+    {
+        grad[i] *= product;
+        product *= c[i];
+    }
+    double suffix = 1.0;
+    for (size_t i = dimension; i-- > 0;)
+    {
+        grad[i] = x[i] / 2000 + grad[i] * suffix;
+        suffix *= c[i];
+    }
+    return 1 + squares / 4000 - product;
+}
+
+std::shared_ptr<Function> GriewankFunction::clone() const
+{
+    return std::make_shared<GriewankFunction>(*this);
+}
+
+double GriewankFunction::getMinValue() const
+{
+    return 0.0;
+}
+
+VectorX GriewankFunction::getMinimizer() const
+{
+    return VectorX(dimension, 0.0);
+}
+
+double GriewankFunction::getDomainBound() const
+{
+    return 600.0;
+}
+
+/**
+ * \brief The coordinate of the global minimizer of the Styblinski-Tang
+ * function, the smaller root of 4x^3 - 32x + 5 = 0.
+ */
+static constexpr double styblinskiTangArgmin = -2.903534027771178;
+
+StyblinskiTangFunction::StyblinskiTangFunction(size_t dim) : ScalableFunction("Styblinski-Tang", dim)
+{
+}
+
+StyblinskiTangFunction::~StyblinskiTangFunction()
+{
+}
+
+double StyblinskiTangFunction::compute(const double *x, double *grad) const
+{
+    double sum;
+    if (!grad)
+    {
+        sum = sumTerms(0, dimension, [x](size_t i)
+                       {
+            double x2 = x[i] * x[i];
+            return (x2 - 16) * x2 + 5 * x[i]; });
+    }
+    else
+    {
+        sum = sumTerms(0, dimension, [x, grad](size_t i)
+                       {
+            double x2 = x[i] * x[i];
+            grad[i] = (2 * x2 - 16) * x[i] + 2.5;
+            return (x2 - 16) * x2 + 5 * x[i]; });
+    }
+    return 0.5 * sum;
+}
+
+VectorX StyblinskiTangFunction::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+    checkDim(x);
+    checkDim(v);
+    VectorX hv(dimension);
+    for (size_t i = 0; i < dimension; ++i)
+        hv[i] = (6 * x[i] * x[i] - 16) * v[i];
+    return hv;
+}
+
+std::shared_ptr<Function> StyblinskiTangFunction::clone() const
+{
+    return std::make_shared<StyblinskiTangFunction>(*this);
+}
+
+double StyblinskiTangFunction::getMinValue() const
+{
+    double x2 = styblinskiTangArgmin * styblinskiTangArgmin;
+    return 0.5 * ((x2 - 16) * x2 + 5 * styblinskiTangArgmin) * dimension;
+}
+
+VectorX StyblinskiTangFunction::getMinimizer() const
+{
+    return VectorX(dimension, styblinskiTangArgmin);
+}
+
+double StyblinskiTangFunction::getDomainBound() const
+{
+    return 5.0;
+}
+
+QuadraticFunction::QuadraticFunction(size_t dim, double conditionNumber) : ScalableFunction("Quadratic", dim)
+{
+    if (!(conditionNumber >= 1))
+        throw std::invalid_argument("Condition number must be at least 1.");
+    auto w = std::make_shared<std::vector<double>>(dim, 1.0);
+    double logRatio = dim > 1 ? std::log(conditionNumber) / (dim - 1) : 0.0;
+    for (size_t i = 0; i < dim; ++i)
+        (*w)[i] = std::exp(logRatio * i);
+    weights = std::move(w);
+}
+
+QuadraticFunction::~QuadraticFunction()
+{
+}
+
+double QuadraticFunction::compute(const double *x, double *grad) const
+{
+    const double *w = weights->data();
+    double sum;
+    if (!grad)
+    {
+        sum = sumTerms(0, dimension, [x, w](size_t i)
+                       { return w[i] * x[i] * x[i]; });
+    }
+    else
+    {
+        sum = sumTerms(0, dimension, [x, w, grad](size_t i)
+                       {
+            grad[i] = w[i] * x[i];
+            return grad[i] * x[i]; });
+    }
+    return 0.5 * sum;
+}
+
+VectorX QuadraticFunction::calcHessVec(const VectorX &x, const VectorX &v) const
+{
+    checkDim(x);
+    checkDim(v);
+    const double *w = weights->data();
+    VectorX hv(dimension);
+    for (size_t i = 0; i < dimension; ++i)
+        hv[i] = w[i] * v[i];
+    return hv;
+}
+
+std::shared_ptr<Function> QuadraticFunction::clone() const
+{
+    return std::make_shared<QuadraticFunction>(*this);
+}
+
+double QuadraticFunction::getMinValue() const
+{
+    return 0.0;
+}
+
+VectorX QuadraticFunction::getMinimizer() const
+{
+    return VectorX(dimension, 0.0);
+}
+
+double QuadraticFunction::getDomainBound() const
+{
+    return 5.0;
+}
+
+std::shared_ptr<ScalableFunction> makeScalableFunction(const std::string &name, size_t dim)
+{
+    if (name == "rosenbrock")
+        return std::make_shared<RosenbrockFunction>(dim);
+    if (name == "rastrigin")
+        return std::make_shared<RastriginFunction>(dim);
+    if (name == "ackley")
+        return std::make_shared<AckleyFunction>(dim);
+    if (name == "griewank")
+        return std::make_shared<GriewankFunction>(dim);
+    if (name == "styblinskitang")
+        return std::make_shared<StyblinskiTangFunction>(dim);
+    if (name == "quadratic")
+        return std::make_shared<QuadraticFunction>(dim);
+    throw std::invalid_argument("Unknown function " + name + ".");
+}
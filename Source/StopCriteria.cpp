@@ -34,7 +34,12 @@ FuncDifferenceNormStopCriteria::~FuncDifferenceNormStopCriteria()
 
 bool GradNormStopCriteria::check(TransferData &data) const
 {
-	return data.getIterNum() >= max_iter || norm(data.getFunc()->grad(data.getCurrPoint())) < eps && data.getPoints()->size() != 1;
+	return data.getIterNum() >= max_iter || (data.getGradNorm() < eps && data.getPoints().size() != 1);
+}
+
+bool GradNormStopCriteria::check(const IterationSnapshot &snapshot) const
+{
+	return snapshot.iterNum >= max_iter || (snapshot.gradNorm < eps && snapshot.pointsNum != 1);
 }
 
 std::string GradNormStopCriteria::getName() const
@@ -45,11 +50,18 @@ std::string GradNormStopCriteria::getName() const
 bool DifferenceNormStopCriteria::check(TransferData &data) const
 {
 
-	if (data.getPoints()->size() == 1)
+	if (data.getPoints().size() == 1)
 		return false;
 	return data.getIterNum() >= max_iter || norm(data.getCurrPoint() - data.getPrevPoint()) < eps;
 }
 
+bool DifferenceNormStopCriteria::check(const IterationSnapshot &snapshot) const
+{
+	if (snapshot.pointsNum == 1)
+		return false;
+	return snapshot.iterNum >= max_iter || snapshot.stepNorm < eps;
+}
+
 std::string DifferenceNormStopCriteria::getName() const
 {
 	return "Difference norm stop criteria";
@@ -57,10 +69,19 @@ std::string DifferenceNormStopCriteria::getName() const
 
 bool FuncDifferenceNormStopCriteria::check(TransferData &data) const
 {
-	if (data.getPoints()->size() == 1)
+	if (data.getPoints().size() == 1)
+		return false;
+	if (data.getIterNum() >= max_iter)
+		return true;
+	double currValue = data.getCurrValue();
+	return std::abs((currValue - data.getPrevValue()) / currValue) < eps;
+}
+
+bool FuncDifferenceNormStopCriteria::check(const IterationSnapshot &snapshot) const
+{
+	if (snapshot.pointsNum == 1)
 		return false;
-	std::shared_ptr<Function> f = data.getFunc();
-	return data.getIterNum() >= max_iter || std::abs(((*f)(data.getCurrPoint()) - (*f)(data.getPrevPoint())) / (*f)(data.getCurrPoint())) < eps;
+	return snapshot.iterNum >= max_iter || std::abs((snapshot.currValue - snapshot.prevValue) / snapshot.currValue) < eps;
 }
 
 std::string FuncDifferenceNormStopCriteria::getName() const
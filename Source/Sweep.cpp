@@ -0,0 +1,125 @@
+#include "Sweep.h"
+#include <chrono>
+
+Sweep::Sweep() : startsNum(1), seed(228), sampling(Sampling::Random)
+{
+}
+
+Sweep::~Sweep()
+{
+}
+
+void Sweep::addFunction(std::shared_ptr<Function> f, const Area &area)
+{
+    if (area.getBounds().size() != f->getDim())
+        throw std::invalid_argument("Area must have the dimension of the function.");
+    functions.push_back({f, area, {}});
+}
+
+void Sweep::addMethod(std::shared_ptr<OptimizationMethod> method, const std::string &label)
+{
+    methods.emplace_back(method, label.empty() ? method->getName() : label);
+}
+
+void Sweep::addCriteria(std::shared_ptr<StopCriteria> criteria)
+{
+    this->criteria.push_back(criteria);
+}
+
+void Sweep::setStarts(size_t startsNum, unsigned int seed, Sampling sampling)
+{
+    this->startsNum = startsNum;
+    this->seed = seed;
+    this->sampling = sampling;
+}
+
+size_t Sweep::getJobsNum() const
+{
+    return functions.size() * methods.size() * criteria.size() * startsNum;
+}
+
+void Sweep::run(size_t threads, const std::function<void(const SweepResult &)> &onResult)
+{
+    for (FunctionEntry &entry : functions)
+    {
+        std::shared_ptr<RandomEngine> sampler = makeSampler(sampling, entry.f->getDim(), seed);
+        entry.startPoints.assign(startsNum, VectorX(entry.f->getDim()));
+        for (VectorX &startPoint : entry.startPoints)
+            entry.area.genRandPoint(startPoint, *sampler);
+    }
+
+    std::mutex resultMutex;
+    std::vector<std::function<void()>> jobs;
+    jobs.reserve(getJobsNum());
+    for (const FunctionEntry &entry : functions)
+        for (const auto &method : methods)
+            for (const std::shared_ptr<StopCriteria> &cr : criteria)
+                for (const VectorX &startPoint : entry.startPoints)
+                {
+                    size_t jobIndex = jobs.size();
+                    const FunctionEntry *fe = &entry;
+                    const OptimizationMethod *prototype = method.first.get();
+                    const StopCriteria *stop = cr.get();
+                    SweepResult job{jobIndex, entry.f->getName(), method.second, cr->getName(), startPoint, VectorX(), 0, 0, 0, ""};
+                    jobs.push_back([&resultMutex, &onResult, fe, prototype, stop, job]
+                                   {
+                        SweepResult result = job;
+                        try
+                        {
+                            std::shared_ptr<OptimizationMethod> local = prototype->clone();
+                            Area area(fe->area);
+                            auto start = std::chrono::steady_clock::now();
+                            local->optimise(result.startPoint, area, *fe->f, *stop);
+                            auto end = std::chrono::steady_clock::now();
+                            result.bestPoint = local->getBestPoint();
+                            result.value = (*fe->f)(result.bestPoint);
+                            result.iterNum = local->getIterNum();
+                            result.seconds = std::chrono::duration<double>(end - start).count();
+                        }
+                        catch (const std::exception &exc)
+                        {
+                            result.error = exc.what();
+                        }
+                        std::lock_guard<std::mutex> lock(resultMutex);
+                        onResult(result); });
+                }
+
+    WorkStealingScheduler scheduler(threads);
+    scheduler.run(jobs);
+}
+
+SweepTable::SweepTable(std::ostream &os) : os(os)
+{
+    os << "job,function,method,criteria,start_point,best_point,value,iterations,seconds,error" << std::endl;
+}
+
+void SweepTable::write(const SweepResult &result)
+{
+    auto text = [this](const std::string &str)
+    {
+        os << '"';
+        for (char c : str)
+            os << (c == '"' ? "\"\"" : std::string(1, c));
+        os << '"';
+    };
+    auto point = [this](const VectorX &x)
+    {
+        os << '"';
+        for (size_t i = 0; i < x.size(); ++i)
+            os << (i ? " " : "") << x[i];
+        os << '"';
+    };
+    os << result.jobIndex << ",";
+    text(result.function);
+    os << ",";
+    text(result.method);
+    os << ",";
+    text(result.criteria);
+    os << ",";
+    point(result.startPoint);
+    os << ",";
+    point(result.bestPoint);
+    os << "," << result.value << "," << result.iterNum << "," << result.seconds << ",";
+    text(result.error);
+    os << std::endl;
+}
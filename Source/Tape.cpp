@@ -0,0 +1,445 @@
+#include "Tape.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize), current(0), offset(0)
+{
+    if (blockSize == 0)
+        throw std::invalid_argument("Block size must be positive.");
+}
+
+Arena::~Arena()
+{
+}
+
+void *Arena::allocate(size_t bytes, size_t alignment)
+{
+    for (; current < blocks.size(); ++current, offset = 0)
+    {
+        Block &block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        uintptr_t aligned = (base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        if (aligned + bytes <= base + block.size)
+        {
+            offset = aligned + bytes - base;
+            return reinterpret_cast<void *>(aligned);
+        }
+    }
+    // No block has room left: add one that is large enough for the request.
+    size_t size = std::max(blockSize, bytes + alignment);
+    blocks.push_back({std::make_unique<std::byte[]>(size), size});
+    offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void Arena::reset()
+{
+    current = 0;
+    offset = 0;
+}
+
+size_t Arena::capacity() const
+{
+    size_t total = 0;
+    for (const Block &block : blocks)
+        total += block.size;
+    return total;
+}
+
+Tape::Tape() : arena(size_t(1) << 20), nodesNum(0), constantsNum(0), inputsNum(0)
+{
+}
+
+Tape::~Tape()
+{
+}
+
+void Tape::clear()
+{
+    arena.reset();
+    pages.clear();
+    constantPages.clear();
+    nodesNum = 0;
+    constantsNum = 0;
+    inputsNum = 0;
+}
+
+TapeVar Tape::input(double value)
+{
+    uint32_t index = push(TapeOp::Input, static_cast<uint32_t>(inputsNum), 0);
+    ++inputsNum;
+    return TapeVar(this, index, value);
+}
+
+TapeVar Tape::constant(double value)
+{
+    return TapeVar(this, pushConstant(TapeOp::Constant, 0, value), value);
+}
+
+uint32_t Tape::push(TapeOp op, uint32_t lhs, uint32_t rhs)
+{
+    if (nodesNum == std::numeric_limits<uint32_t>::max())
+        throw std::length_error("Tape is full.");
+    if ((nodesNum >> pageShift) == pages.size())
+        pages.push_back(arena.allocate<TapeNode>(pageSize));
+    pages.back()[nodesNum & (pageSize - 1)] = {op, lhs, rhs};
+    return static_cast<uint32_t>(nodesNum++);
+}
+
+uint32_t Tape::pushConstant(TapeOp op, uint32_t lhs, double constant)
+{
+    // There are never more constants than nodes, so push() guards the index.
+    uint32_t index = push(op, lhs, static_cast<uint32_t>(constantsNum));
+    if ((constantsNum >> pageShift) == constantPages.size())
+        constantPages.push_back(arena.allocate<double>(pageSize));
+    constantPages.back()[constantsNum & (pageSize - 1)] = constant;
+    ++constantsNum;
+    return index;
+}
+
+void Tape::forward(const double *inputs, double *values) const
+{
+    for (size_t page = 0; page < pages.size(); ++page)
+    {
+        const TapeNode *nodes = pages[page];
+        size_t begin = page << pageShift;
+        size_t end = std::min(nodesNum, begin + pageSize);
+        for (size_t i = begin; i < end; ++i)
+        {
+            const TapeNode &node = nodes[i - begin];
+            double &v = values[i];
+            if (node.op == TapeOp::Input)
+            {
+                v = inputs[node.lhs];
+                continue;
+            }
+            if (node.op == TapeOp::Constant)
+            {
+                v = constantAt(node.rhs);
+                continue;
+            }
+            double l = values[node.lhs];
+            switch (node.op)
+            {
+            case TapeOp::Input:
+            case TapeOp::Constant:
+                break;
+            case TapeOp::Add:
+                v = l + values[node.rhs];
+                break;
+            case TapeOp::Sub:
+                v = l - values[node.rhs];
+                break;
+            case TapeOp::Mul:
+                v = l * values[node.rhs];
+                break;
+            case TapeOp::Div:
+                v = l / values[node.rhs];
+                break;
+            case TapeOp::Neg:
+                v = -l;
+                break;
+            case TapeOp::AddConst:
+                v = l + constantAt(node.rhs);
+                break;
+            case TapeOp::MulConst:
+                v = l * constantAt(node.rhs);
+                break;
+            case TapeOp::ConstSub:
+                v = constantAt(node.rhs) - l;
+                break;
+            case TapeOp::ConstDiv:
+                v = constantAt(node.rhs) / l;
+                break;
+            case TapeOp::PowConst:
+            {
+                double p = constantAt(node.rhs);
+                v = p == 2 ? l * l : std::pow(l, p);
+                break;
+            }
+            case TapeOp::Sin:
+                v = std::sin(l);
+                break;
+            case TapeOp::Cos:
+                v = std::cos(l);
+                break;
+            case TapeOp::Exp:
+                v = std::exp(l);
+                break;
+            case TapeOp::Log:
+                v = std::log(l);
+                break;
+            case TapeOp::Sqrt:
+                v = std::sqrt(l);
+                break;
+            }
+        }
+    }
+}
+
+void Tape::reverse(uint32_t output, const double *values, double *adjoints, double *grad) const
+{
+    if (output >= nodesNum)
+        throw std::out_of_range("Output node is not on the tape.");
+    for (size_t i = 0; i <= output; ++i)
+        adjoints[i] = 0;
+    for (size_t i = 0; i < inputsNum; ++i)
+        grad[i] = 0;
+    adjoints[output] = 1;
+    // Nodes after the output cannot affect it, so the sweep starts there and
+    // walks each page backwards over contiguous memory.
+    for (size_t page = (output >> pageShift) + 1; page-- > 0;)
+    {
+        const TapeNode *nodes = pages[page];
+        size_t begin = page << pageShift;
+        for (size_t i = std::min<size_t>(output, begin + pageSize - 1) + 1; i-- > begin;)
+        {
+            double a = adjoints[i];
+            if (a == 0)
+                continue;
+            const TapeNode &node = nodes[i - begin];
+            double l = values[node.lhs];
+            switch (node.op)
+            {
+            case TapeOp::Input:
+                grad[node.lhs] += a;
+                break;
+            case TapeOp::Constant:
+                break;
+            case TapeOp::Add:
+                adjoints[node.lhs] += a;
+                adjoints[node.rhs] += a;
+                break;
+            case TapeOp::Sub:
+                adjoints[node.lhs] += a;
+                adjoints[node.rhs] -= a;
+                break;
+            case TapeOp::Mul:
+                adjoints[node.lhs] += a * values[node.rhs];
+                adjoints[node.rhs] += a * l;
+                break;
+            case TapeOp::Div:
+            {
+                double inverse = 1 / values[node.rhs];
+                adjoints[node.lhs] += a * inverse;
+                adjoints[node.rhs] -= a * values[i] * inverse;
+                break;
+            }
+            case TapeOp::Neg:
+                adjoints[node.lhs] -= a;
+                break;
+            case TapeOp::AddConst:
+                adjoints[node.lhs] += a;
+                break;
+            case TapeOp::MulConst:
+                adjoints[node.lhs] += a * constantAt(node.rhs);
+                break;
+            case TapeOp::ConstSub:
+                adjoints[node.lhs] -= a;
+                break;
+            case TapeOp::ConstDiv:
+                adjoints[node.lhs] -= a * values[i] / l;
+                break;
+            case TapeOp::PowConst:
+            {
+                double p = constantAt(node.rhs);
+                adjoints[node.lhs] += a * p * (p == 2 ? l : std::pow(l, p - 1));
+                break;
+            }
+            case TapeOp::Sin:
+                adjoints[node.lhs] += a * std::cos(l);
+                break;
+            case TapeOp::Cos:
+                adjoints[node.lhs] -= a * std::sin(l);
+                break;
+            case TapeOp::Exp:
+                adjoints[node.lhs] += a * values[i];
+                break;
+            case TapeOp::Log:
+                adjoints[node.lhs] += a / l;
+                break;
+            case TapeOp::Sqrt:
+                adjoints[node.lhs] += a * 0.5 / values[i];
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * \brief Get the node of a variable on the given tape.
+ *
+ * A variable that is not recorded anywhere, such as a default-constructed
+ * accumulator, is recorded as a constant.
+ */
+static uint32_t nodeOn(Tape *tape, const TapeVar &v)
+{
+    if (v.getTape() == tape)
+        return v.getIndex();
+    if (!v.getTape())
+        return tape->pushConstant(TapeOp::Constant, 0, v.value());
+    throw std::invalid_argument("Variables are recorded on different tapes.");
+}
+
+static TapeVar binary(TapeOp op, const TapeVar &a, const TapeVar &b, double value)
+{
+    Tape *tape = a.getTape() ? a.getTape() : b.getTape();
+    if (!tape)
+        return TapeVar(nullptr, 0, value);
+    uint32_t lhs = nodeOn(tape, a);
+    uint32_t rhs = nodeOn(tape, b);
+    return TapeVar(tape, tape->push(op, lhs, rhs), value);
+}
+
+static TapeVar unary(TapeOp op, const TapeVar &a, double value)
+{
+    Tape *tape = a.getTape();
+    if (!tape)
+        return TapeVar(nullptr, 0, value);
+    return TapeVar(tape, tape->push(op, a.getIndex(), 0), value);
+}
+
+static TapeVar unaryConstant(TapeOp op, const TapeVar &a, double constant, double value)
+{
+    Tape *tape = a.getTape();
+    if (!tape)
+        return TapeVar(nullptr, 0, value);
+    return TapeVar(tape, tape->pushConstant(op, a.getIndex(), constant), value);
+}
+
+TapeVar &TapeVar::operator+=(const TapeVar &other)
+{
+    return *this = *this + other;
+}
+
+TapeVar &TapeVar::operator-=(const TapeVar &other)
+{
+    return *this = *this - other;
+}
+
+TapeVar &TapeVar::operator*=(const TapeVar &other)
+{
+    return *this = *this * other;
+}
+
+TapeVar &TapeVar::operator/=(const TapeVar &other)
+{
+    return *this = *this / other;
+}
+
+TapeVar &TapeVar::operator+=(double other)
+{
+    return *this = *this + other;
+}
+
+TapeVar &TapeVar::operator-=(double other)
+{
+    return *this = *this - other;
+}
+
+TapeVar &TapeVar::operator*=(double other)
+{
+    return *this = *this * other;
+}
+
+TapeVar &TapeVar::operator/=(double other)
+{
+    return *this = *this / other;
+}
+
+TapeVar operator-(const TapeVar &a)
+{
+    return unary(TapeOp::Neg, a, -a.value());
+}
+
+TapeVar operator+(const TapeVar &a, const TapeVar &b)
+{
+    return binary(TapeOp::Add, a, b, a.value() + b.value());
+}
+
+TapeVar operator-(const TapeVar &a, const TapeVar &b)
+{
+    return binary(TapeOp::Sub, a, b, a.value() - b.value());
+}
+
+TapeVar operator*(const TapeVar &a, const TapeVar &b)
+{
+    return binary(TapeOp::Mul, a, b, a.value() * b.value());
+}
+
+TapeVar operator/(const TapeVar &a, const TapeVar &b)
+{
+    return binary(TapeOp::Div, a, b, a.value() / b.value());
+}
+
+TapeVar operator+(const TapeVar &a, double b)
+{
+    return unaryConstant(TapeOp::AddConst, a, b, a.value() + b);
+}
+
+TapeVar operator+(double a, const TapeVar &b)
+{
+    return b + a;
+}
+
+TapeVar operator-(const TapeVar &a, double b)
+{
+    return unaryConstant(TapeOp::AddConst, a, -b, a.value() - b);
+}
+
+TapeVar operator-(double a, const TapeVar &b)
+{
+    return unaryConstant(TapeOp::ConstSub, b, a, a - b.value());
+}
+
+TapeVar operator*(const TapeVar &a, double b)
+{
+    return unaryConstant(TapeOp::MulConst, a, b, a.value() * b);
+}
+
+TapeVar operator*(double a, const TapeVar &b)
+{
+    return b * a;
+}
+
+TapeVar operator/(const TapeVar &a, double b)
+{
+    return a * (1 / b);
+}
+
+TapeVar operator/(double a, const TapeVar &b)
+{
+    return unaryConstant(TapeOp::ConstDiv, b, a, a / b.value());
+}
+
+TapeVar sin(const TapeVar &a)
+{
+    return unary(TapeOp::Sin, a, std::sin(a.value()));
+}
+
+TapeVar cos(const TapeVar &a)
+{
+    return unary(TapeOp::Cos, a, std::cos(a.value()));
+}
+
+TapeVar exp(const TapeVar &a)
+{
+    return unary(TapeOp::Exp, a, std::exp(a.value()));
+}
+
+TapeVar log(const TapeVar &a)
+{
+    return unary(TapeOp::Log, a, std::log(a.value()));
+}
+
+TapeVar sqrt(const TapeVar &a)
+{
+    return unary(TapeOp::Sqrt, a, std::sqrt(a.value()));
+}
+
+TapeVar pow(const TapeVar &a, double p)
+{
+    return unaryConstant(TapeOp::PowConst, a, p, p == 2 ? a.value() * a.value() : std::pow(a.value(), p));
+}
@@ -0,0 +1,124 @@
+#include "TapeFunction.h"
+
+/**
+ * \struct TapeWorkspace
+ * \brief Per-thread buffers of the evaluations, grown once and then reused.
+ */
+struct TapeWorkspace
+{
+    Tape tape;                    ///< The tape of functions recorded at every point.
+    std::vector<TapeVar> vars;    ///< The inputs while recording.
+    std::vector<double> values;   ///< The values of the nodes.
+    std::vector<double> adjoints; ///< The adjoints of the nodes.
+};
+
+static thread_local TapeWorkspace workspace;
+
+/**
+ * \brief Record a formula at a point.
+ *
+ * \return The node holding the value of the formula.
+ */
+static uint32_t record(const TapeFunction::Formula &formula, Tape &tape, std::vector<TapeVar> &vars, const double *x, size_t dim)
+{
+    tape.clear();
+    vars.resize(dim);
+    for (size_t i = 0; i < dim; ++i)
+        vars[i] = tape.input(x[i]);
+    TapeVar y = formula(vars);
+    if (!y.getTape())
+        return tape.constant(y.value()).getIndex();
+    if (y.getTape() != &tape)
+        throw std::invalid_argument("Formula must return a variable recorded on its own tape.");
+    return y.getIndex();
+}
+
+TapeFunction::TapeFunction(const std::string &name, size_t dim, Formula formula, bool retape)
+    : formula(std::move(formula)), retape(retape), output(0)
+{
+    if (dim == 0)
+        throw std::invalid_argument("Dimension must be positive.");
+    if (!this->formula)
+        throw std::invalid_argument("Formula must not be empty.");
+    dimension = dim;
+    this->name = name;
+    if (!retape)
+    {
+        // The operations do not depend on the point, so any point will do.
+        auto recorded = std::make_shared<Tape>();
+        std::vector<TapeVar> vars;
+        std::vector<double> origin(dim, 0.0);
+        output = record(this->formula, *recorded, vars, origin.data(), dim);
+        tape = std::move(recorded);
+    }
+}
+
+TapeFunction::~TapeFunction()
+{
+}
+
+const Tape &TapeFunction::replay(const VectorX &x, uint32_t &output) const
+{
+    if (x.size() != dimension)
+    {
+        throw std::invalid_argument("Input vector must have exactly " + std::to_string(dimension) + " elements.");
+    }
+    const Tape *t = tape.get();
+    output = this->output;
+    if (retape)
+    {
+        output = record(formula, workspace.tape, workspace.vars, x.data(), dimension);
+        t = &workspace.tape;
+    }
+    if (workspace.values.size() < t->size())
+        workspace.values.resize(t->size());
+    t->forward(x.data(), workspace.values.data());
+    return *t;
+}
+
+double TapeFunction::calcValue(const VectorX &x) const
+{
+    uint32_t out;
+    replay(x, out);
+    return workspace.values[out];
+}
+
+/**
+ * \brief Propagate adjoints from the output of a replayed tape to the inputs.
+ */
+static VectorX backpropagate(const Tape &tape, uint32_t output)
+{
+    if (workspace.adjoints.size() < tape.size())
+        workspace.adjoints.resize(tape.size());
+    VectorX grad(tape.getInputsNum());
+    tape.reverse(output, workspace.values.data(), workspace.adjoints.data(), grad.data());
+    return grad;
+}
+
+VectorX TapeFunction::calcGrad(const VectorX &x) const
+{
+    uint32_t out;
+    const Tape &t = replay(x, out);
+    return backpropagate(t, out);
+}
+
+Evaluation TapeFunction::calcEvaluation(const VectorX &x, bool wantGrad) const
+{
+    uint32_t out;
+    const Tape &t = replay(x, out);
+    Evaluation eval{workspace.values[out], VectorX()};
+    if (!wantGrad)
+        return eval;
+    eval.grad = backpropagate(t, out);
+    return eval;
+}
+
+std::shared_ptr<Function> TapeFunction::clone() const
+{
+    return std::make_shared<TapeFunction>(*this);
+}
+
+size_t TapeFunction::getTapeSize() const
+{
+    return tape ? tape->size() : 0;
+}
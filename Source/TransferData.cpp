@@ -1,6 +1,8 @@
 #include "TransferData.h"
+#include <algorithm>
+#include <cmath>
 
-TransferData::TransferData() : currIter(0), func(nullptr), points(nullptr)
+TransferData::TransferData() : points(nullptr), bounds(nullptr), func(nullptr), currIter(0), evalIndex{SIZE_MAX, SIZE_MAX}
 {
 }
 
@@ -18,6 +20,36 @@ const VectorX &TransferData::getPrevPoint() const
     return (*points)[points->size() - 2];
 }
 
+double TransferData::getCurrValue()
+{
+    return evalAt(points->size() - 1, false).value;
+}
+
+double TransferData::getPrevValue()
+{
+    return evalAt(points->size() - 2, false).value;
+}
+
+const VectorX &TransferData::getCurrGrad()
+{
+    return evalAt(points->size() - 1, true).grad;
+}
+
+double TransferData::getGradNorm()
+{
+    const VectorX &grad = getCurrGrad();
+    if (!bounds)
+        return norm(grad);
+    const VectorX &x = getCurrPoint();
+    double sum = 0;
+    for (size_t i = 0; i < grad.size(); ++i)
+    {
+        double move = std::clamp(x[i] - grad[i], (*bounds)[i].first, (*bounds)[i].second) - x[i];
+        sum += move * move;
+    }
+    return std::sqrt(sum);
+}
+
 std::shared_ptr<Function> TransferData::getFunc() const
 {
     return func;
@@ -28,14 +60,19 @@ size_t TransferData::getIterNum()
     return currIter;
 }
 
-std::shared_ptr<std::vector<VectorX>> TransferData::getPoints() const
+const std::vector<VectorX> &TransferData::getPoints() const
 {
-    return points;
+    return *points;
 }
 
 void TransferData::setPoints(const std::vector<VectorX> &points)
 {
-    this->points = std::make_shared<std::vector<VectorX>>(points);
+    this->points = &points;
+}
+
+void TransferData::setBounds(const std::vector<std::pair<double, double>> &bounds)
+{
+    this->bounds = &bounds;
 }
 
 void TransferData::setFunc(const Function &f)
@@ -46,4 +83,34 @@ void TransferData::setFunc(const Function &f)
 void TransferData::setIterNum(const size_t iter)
 {
     currIter = iter;
-}
\ No newline at end of file
+}
+
+void TransferData::setCurrEval(const Evaluation &eval)
+{
+    size_t index = points->size() - 1;
+    size_t slot = slotFor(index);
+    evals[slot] = eval;
+    evalIndex[slot] = index;
+}
+
+size_t TransferData::slotFor(size_t index) const
+{
+    for (size_t slot = 0; slot < 2; ++slot)
+        if (evalIndex[slot] == index)
+            return slot;
+    for (size_t slot = 0; slot < 2; ++slot)
+        if (evalIndex[slot] == SIZE_MAX)
+            return slot;
+    return evalIndex[0] < evalIndex[1] ? 0 : 1;
+}
+
+const Evaluation &TransferData::evalAt(size_t index, bool wantGrad)
+{
+    size_t slot = slotFor(index);
+    if (evalIndex[slot] != index || (wantGrad && evals[slot].grad.empty()))
+    {
+        evals[slot] = func->evaluate((*points)[index], wantGrad);
+        evalIndex[slot] = index;
+    }
+    return evals[slot];
+}
@@ -0,0 +1,504 @@
+#include "VectorKernels.h"
+#include "RandomEngine.h"
+#include <bit>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VECTOR_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNEL_TARGET(isa)
+#else
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+// Scalar kernels. The vectorized kernels below use them for the tail that
+// does not fill a whole register.
+
+static double sumSquaresScalar(const double *x, size_t n)
+{
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i)
+        sum += x[i] * x[i];
+    return sum;
+}
+
+static void addScalar(double *y, const double *x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        y[i] += x[i];
+}
+
+static void subScalar(double *y, const double *x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        y[i] -= x[i];
+}
+
+static void scaleScalar(double *y, double a, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        y[i] *= a;
+}
+
+static void axpyScalar(double *y, double a, const double *x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        y[i] += x[i] * a;
+}
+
+static void adamStepScalar(double *x, double *m, double *v, const double *g, size_t n, const AdamCoefficients &c)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        m[i] = c.beta1 * m[i] + (1 - c.beta1) * g[i];
+        v[i] = c.beta2 * v[i] + (1 - c.beta2) * g[i] * g[i];
+        double m_hat = m[i] / c.biasCorrection1;
+        double v_hat = v[i] / c.biasCorrection2;
+        x[i] -= c.alpha * m_hat / (sqrt(v_hat) + c.epsilon);
+    }
+}
+
+static double philoxUnit(uint64_t bits)
+{
+    return std::bit_cast<double>(UINT64_C(0x3FF0000000000000) | bits >> 12) - 1.0;
+}
+
+static void philoxUniformScalar(double *u, size_t blocks, uint64_t firstBlock, uint64_t stream, const uint32_t *key)
+{
+    const uint32_t k[2] = {key[0], key[1]};
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        uint64_t index = firstBlock + b;
+        const uint32_t counter[4] = {static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32),
+                                     static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+        uint32_t out[4];
+        Philox4x32::block(counter, k, out);
+        u[2 * b] = philoxUnit(out[0] | uint64_t(out[1]) << 32);
+        u[2 * b + 1] = philoxUnit(out[2] | uint64_t(out[3]) << 32);
+    }
+}
+
+// The vectorized Philox kernels hold one block per 64-bit lane, each 32-bit
+// word of the counter in the low half of a lane: _mm*_mul_epu32 reads only
+// that half and returns the full 64-bit product. The high halves of the
+// words are left unmasked until the outputs are assembled.
+
+#ifdef VECTOR_KERNELS_X86
+
+KERNEL_TARGET("sse2")
+static double sumSquaresSSE2(const double *x, size_t n)
+{
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d a = _mm_loadu_pd(x + i);
+        acc = _mm_add_pd(acc, _mm_mul_pd(a, a));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    return lanes[0] + lanes[1] + sumSquaresScalar(x + i, n - i);
+}
+
+KERNEL_TARGET("sse2")
+static void addSSE2(double *y, const double *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+    addScalar(y + i, x + i, n - i);
+}
+
+KERNEL_TARGET("sse2")
+static void subSSE2(double *y, const double *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(y + i, _mm_sub_pd(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+    subScalar(y + i, x + i, n - i);
+}
+
+KERNEL_TARGET("sse2")
+static void scaleSSE2(double *y, double a, size_t n)
+{
+    __m128d va = _mm_set1_pd(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(y + i, _mm_mul_pd(_mm_loadu_pd(y + i), va));
+    scaleScalar(y + i, a, n - i);
+}
+
+KERNEL_TARGET("sse2")
+static void axpySSE2(double *y, double a, const double *x, size_t n)
+{
+    __m128d va = _mm_set1_pd(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(_mm_loadu_pd(x + i), va)));
+    axpyScalar(y + i, a, x + i, n - i);
+}
+
+KERNEL_TARGET("sse2")
+static void adamStepSSE2(double *x, double *m, double *v, const double *g, size_t n, const AdamCoefficients &c)
+{
+    __m128d beta1 = _mm_set1_pd(c.beta1);
+    __m128d beta2 = _mm_set1_pd(c.beta2);
+    __m128d oneMinusBeta1 = _mm_set1_pd(1 - c.beta1);
+    __m128d oneMinusBeta2 = _mm_set1_pd(1 - c.beta2);
+    __m128d corr1 = _mm_set1_pd(c.biasCorrection1);
+    __m128d corr2 = _mm_set1_pd(c.biasCorrection2);
+    __m128d alpha = _mm_set1_pd(c.alpha);
+    __m128d eps = _mm_set1_pd(c.epsilon);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d gi = _mm_loadu_pd(g + i);
+        __m128d mi = _mm_add_pd(_mm_mul_pd(beta1, _mm_loadu_pd(m + i)), _mm_mul_pd(oneMinusBeta1, gi));
+        __m128d vi = _mm_add_pd(_mm_mul_pd(beta2, _mm_loadu_pd(v + i)), _mm_mul_pd(_mm_mul_pd(oneMinusBeta2, gi), gi));
+        _mm_storeu_pd(m + i, mi);
+        _mm_storeu_pd(v + i, vi);
+        __m128d step = _mm_div_pd(_mm_mul_pd(alpha, _mm_div_pd(mi, corr1)), _mm_add_pd(_mm_sqrt_pd(_mm_div_pd(vi, corr2)), eps));
+        _mm_storeu_pd(x + i, _mm_sub_pd(_mm_loadu_pd(x + i), step));
+    }
+    adamStepScalar(x + i, m + i, v + i, g + i, n - i, c);
+}
+
+KERNEL_TARGET("avx2")
+static double sumSquaresAVX2(const double *x, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256d a = _mm256_loadu_pd(x + i);
+        __m256d b = _mm256_loadu_pd(x + i + 4);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(a, a));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(b, b));
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d a = _mm256_loadu_pd(x + i);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(a, a));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumSquaresScalar(x + i, n - i);
+}
+
+KERNEL_TARGET("avx2")
+static void addAVX2(double *y, const double *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i)));
+    addScalar(y + i, x + i, n - i);
+}
+
+KERNEL_TARGET("avx2")
+static void subAVX2(double *y, const double *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(y + i, _mm256_sub_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i)));
+    subScalar(y + i, x + i, n - i);
+}
+
+KERNEL_TARGET("avx2")
+static void scaleAVX2(double *y, double a, size_t n)
+{
+    __m256d va = _mm256_set1_pd(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(y + i, _mm256_mul_pd(_mm256_loadu_pd(y + i), va));
+    scaleScalar(y + i, a, n - i);
+}
+
+KERNEL_TARGET("avx2")
+static void axpyAVX2(double *y, double a, const double *x, size_t n)
+{
+    __m256d va = _mm256_set1_pd(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(_mm256_loadu_pd(x + i), va)));
+    axpyScalar(y + i, a, x + i, n - i);
+}
+
+KERNEL_TARGET("avx2")
+static void adamStepAVX2(double *x, double *m, double *v, const double *g, size_t n, const AdamCoefficients &c)
+{
+    __m256d beta1 = _mm256_set1_pd(c.beta1);
+    __m256d beta2 = _mm256_set1_pd(c.beta2);
+    __m256d oneMinusBeta1 = _mm256_set1_pd(1 - c.beta1);
+    __m256d oneMinusBeta2 = _mm256_set1_pd(1 - c.beta2);
+    __m256d corr1 = _mm256_set1_pd(c.biasCorrection1);
+    __m256d corr2 = _mm256_set1_pd(c.biasCorrection2);
+    __m256d alpha = _mm256_set1_pd(c.alpha);
+    __m256d eps = _mm256_set1_pd(c.epsilon);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d gi = _mm256_loadu_pd(g + i);
+        __m256d mi = _mm256_add_pd(_mm256_mul_pd(beta1, _mm256_loadu_pd(m + i)), _mm256_mul_pd(oneMinusBeta1, gi));
+        __m256d vi = _mm256_add_pd(_mm256_mul_pd(beta2, _mm256_loadu_pd(v + i)), _mm256_mul_pd(_mm256_mul_pd(oneMinusBeta2, gi), gi));
+        _mm256_storeu_pd(m + i, mi);
+        _mm256_storeu_pd(v + i, vi);
+        __m256d step = _mm256_div_pd(_mm256_mul_pd(alpha, _mm256_div_pd(mi, corr1)), _mm256_add_pd(_mm256_sqrt_pd(_mm256_div_pd(vi, corr2)), eps));
+        _mm256_storeu_pd(x + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), step));
+    }
+    adamStepScalar(x + i, m + i, v + i, g + i, n - i, c);
+}
+
+KERNEL_TARGET("avx2")
+static void philoxUniformAVX2(double *u, size_t blocks, uint64_t firstBlock, uint64_t stream, const uint32_t *key)
+{
+    const __m256i m0 = _mm256_set1_epi64x(0xD2511F53);
+    const __m256i m1 = _mm256_set1_epi64x(0xCD9E8D57);
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i one = _mm256_set1_epi64x(INT64_C(0x3FF0000000000000));
+    const __m256d unit = _mm256_set1_pd(1.0);
+    __m256i k0[10], k1[10];
+    for (int round = 0; round < 10; ++round)
+    {
+        k0[round] = _mm256_set1_epi64x(uint32_t(key[0] + round * 0x9E3779B9u));
+        k1[round] = _mm256_set1_epi64x(uint32_t(key[1] + round * 0xBB67AE85u));
+    }
+    const __m256i streamLow = _mm256_set1_epi64x(uint32_t(stream));
+    const __m256i streamHigh = _mm256_set1_epi64x(uint32_t(stream >> 32));
+    size_t b = 0;
+    for (; b + 4 <= blocks; b += 4)
+    {
+        uint64_t index = firstBlock + b;
+        __m256i c0 = _mm256_set_epi64x(index + 3, index + 2, index + 1, index);
+        __m256i c1 = _mm256_srli_epi64(c0, 32);
+        __m256i c2 = streamLow;
+        __m256i c3 = streamHigh;
+        for (int round = 0; round < 10; ++round)
+        {
+            __m256i p0 = _mm256_mul_epu32(m0, c0);
+            __m256i p1 = _mm256_mul_epu32(m1, c2);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), k0[round]);
+            c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), k1[round]);
+            c1 = p1;
+            c3 = p0;
+        }
+        __m256i a = _mm256_or_si256(_mm256_and_si256(c0, low), _mm256_slli_epi64(c1, 32));
+        __m256i c = _mm256_or_si256(_mm256_and_si256(c2, low), _mm256_slli_epi64(c3, 32));
+        __m256d ua = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(a, 12), one)), unit);
+        __m256d uc = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(c, 12), one)), unit);
+        __m256d even = _mm256_unpacklo_pd(ua, uc);
+        __m256d odd = _mm256_unpackhi_pd(ua, uc);
+        _mm256_storeu_pd(u + 2 * b, _mm256_permute2f128_pd(even, odd, 0x20));
+        _mm256_storeu_pd(u + 2 * b + 4, _mm256_permute2f128_pd(even, odd, 0x31));
+    }
+    philoxUniformScalar(u + 2 * b, blocks - b, firstBlock + b, stream, key);
+}
+
+KERNEL_TARGET("avx512f")
+static double sumSquaresAVX512(const double *x, size_t n)
+{
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512d a = _mm512_loadu_pd(x + i);
+        __m512d b = _mm512_loadu_pd(x + i + 8);
+        acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(a, a));
+        acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(b, b));
+    }
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d a = _mm512_loadu_pd(x + i);
+        acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(a, a));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1)) + sumSquaresScalar(x + i, n - i);
+}
+
+KERNEL_TARGET("avx512f")
+static void addAVX512(double *y, const double *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_loadu_pd(y + i), _mm512_loadu_pd(x + i)));
+    addScalar(y + i, x + i, n - i);
+}
+
+KERNEL_TARGET("avx512f")
+static void subAVX512(double *y, const double *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(y + i, _mm512_sub_pd(_mm512_loadu_pd(y + i), _mm512_loadu_pd(x + i)));
+    subScalar(y + i, x + i, n - i);
+}
+
+KERNEL_TARGET("avx512f")
+static void scaleAVX512(double *y, double a, size_t n)
+{
+    __m512d va = _mm512_set1_pd(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(y + i, _mm512_mul_pd(_mm512_loadu_pd(y + i), va));
+    scaleScalar(y + i, a, n - i);
+}
+
+KERNEL_TARGET("avx512f")
+static void axpyAVX512(double *y, double a, const double *x, size_t n)
+{
+    __m512d va = _mm512_set1_pd(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_loadu_pd(y + i), _mm512_mul_pd(_mm512_loadu_pd(x + i), va)));
+    axpyScalar(y + i, a, x + i, n - i);
+}
+
+KERNEL_TARGET("avx512f")
+static void adamStepAVX512(double *x, double *m, double *v, const double *g, size_t n, const AdamCoefficients &c)
+{
+    __m512d beta1 = _mm512_set1_pd(c.beta1);
+    __m512d beta2 = _mm512_set1_pd(c.beta2);
+    __m512d oneMinusBeta1 = _mm512_set1_pd(1 - c.beta1);
+    __m512d oneMinusBeta2 = _mm512_set1_pd(1 - c.beta2);
+    __m512d corr1 = _mm512_set1_pd(c.biasCorrection1);
+    __m512d corr2 = _mm512_set1_pd(c.biasCorrection2);
+    __m512d alpha = _mm512_set1_pd(c.alpha);
+    __m512d eps = _mm512_set1_pd(c.epsilon);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d gi = _mm512_loadu_pd(g + i);
+        __m512d mi = _mm512_add_pd(_mm512_mul_pd(beta1, _mm512_loadu_pd(m + i)), _mm512_mul_pd(oneMinusBeta1, gi));
+        __m512d vi = _mm512_add_pd(_mm512_mul_pd(beta2, _mm512_loadu_pd(v + i)), _mm512_mul_pd(_mm512_mul_pd(oneMinusBeta2, gi), gi));
+        _mm512_storeu_pd(m + i, mi);
+        _mm512_storeu_pd(v + i, vi);
+        __m512d step = _mm512_div_pd(_mm512_mul_pd(alpha, _mm512_div_pd(mi, corr1)), _mm512_add_pd(_mm512_sqrt_pd(_mm512_div_pd(vi, corr2)), eps));
+        _mm512_storeu_pd(x + i, _mm512_sub_pd(_mm512_loadu_pd(x + i), step));
+    }
+    adamStepScalar(x + i, m + i, v + i, g + i, n - i, c);
+}
+
+KERNEL_TARGET("avx512f")
+static void philoxUniformAVX512(double *u, size_t blocks, uint64_t firstBlock, uint64_t stream, const uint32_t *key)
+{
+    const __m512i m0 = _mm512_set1_epi64(0xD2511F53);
+    const __m512i m1 = _mm512_set1_epi64(0xCD9E8D57);
+    const __m512i low = _mm512_set1_epi64(0xFFFFFFFF);
+    const __m512i one = _mm512_set1_epi64(INT64_C(0x3FF0000000000000));
+    const __m512d unit = _mm512_set1_pd(1.0);
+    const __m512i lanes = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i firstHalf = _mm512_set_epi64(11, 3, 10, 2, 9, 1, 8, 0);
+    const __m512i secondHalf = _mm512_set_epi64(15, 7, 14, 6, 13, 5, 12, 4);
+    __m512i k0[10], k1[10];
+    for (int round = 0; round < 10; ++round)
+    {
+        k0[round] = _mm512_set1_epi64(uint32_t(key[0] + round * 0x9E3779B9u));
+        k1[round] = _mm512_set1_epi64(uint32_t(key[1] + round * 0xBB67AE85u));
+    }
+    const __m512i streamLow = _mm512_set1_epi64(uint32_t(stream));
+    const __m512i streamHigh = _mm512_set1_epi64(uint32_t(stream >> 32));
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8)
+    {
+        __m512i c0 = _mm512_add_epi64(_mm512_set1_epi64(firstBlock + b), lanes);
+        __m512i c1 = _mm512_srli_epi64(c0, 32);
+        __m512i c2 = streamLow;
+        __m512i c3 = streamHigh;
+        for (int round = 0; round < 10; ++round)
+        {
+            __m512i p0 = _mm512_mul_epu32(m0, c0);
+            __m512i p1 = _mm512_mul_epu32(m1, c2);
+            c0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), c1), k0[round]);
+            c2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), c3), k1[round]);
+            c1 = p1;
+            c3 = p0;
+        }
+        __m512i a = _mm512_or_si512(_mm512_and_si512(c0, low), _mm512_slli_epi64(c1, 32));
+        __m512i c = _mm512_or_si512(_mm512_and_si512(c2, low), _mm512_slli_epi64(c3, 32));
+        __m512d ua = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(a, 12), one)), unit);
+        __m512d uc = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(c, 12), one)), unit);
+        _mm512_storeu_pd(u + 2 * b, _mm512_permutex2var_pd(ua, firstHalf, uc));
+        _mm512_storeu_pd(u + 2 * b + 8, _mm512_permutex2var_pd(ua, secondHalf, uc));
+    }
+    philoxUniformScalar(u + 2 * b, blocks - b, firstBlock + b, stream, key);
+}
+
+enum class InstructionSet
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+static InstructionSet detectInstructionSet()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    bool avx512f = false;
+    if (osxsave && avx && maxLeaf >= 7)
+    {
+        unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        avx2 = (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+        avx512f = (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool avx512f = __builtin_cpu_supports("avx512f");
+#endif
+    if (avx512f)
+        return InstructionSet::AVX512;
+    if (avx2)
+        return InstructionSet::AVX2;
+    if (sse2)
+        return InstructionSet::SSE2;
+    return InstructionSet::Scalar;
+}
+
+static const VectorKernels avx512Kernels = {"avx512f", sumSquaresAVX512, addAVX512, subAVX512, scaleAVX512, axpyAVX512, adamStepAVX512, philoxUniformAVX512};
+static const VectorKernels avx2Kernels = {"avx2", sumSquaresAVX2, addAVX2, subAVX2, scaleAVX2, axpyAVX2, adamStepAVX2, philoxUniformAVX2};
+static const VectorKernels sse2Kernels = {"sse2", sumSquaresSSE2, addSSE2, subSSE2, scaleSSE2, axpySSE2, adamStepSSE2, philoxUniformScalar};
+
+#endif
+
+static const VectorKernels scalarKernels = {"scalar", sumSquaresScalar, addScalar, subScalar, scaleScalar, axpyScalar, adamStepScalar, philoxUniformScalar};
+
+std::vector<const VectorKernels *> supportedVectorKernels()
+{
+    std::vector<const VectorKernels *> tables;
+#ifdef VECTOR_KERNELS_X86
+    InstructionSet widest = detectInstructionSet();
+    if (widest >= InstructionSet::AVX512)
+        tables.push_back(&avx512Kernels);
+    if (widest >= InstructionSet::AVX2)
+        tables.push_back(&avx2Kernels);
+    if (widest >= InstructionSet::SSE2)
+        tables.push_back(&sse2Kernels);
+#endif
+    tables.push_back(&scalarKernels);
+    return tables;
+}
+
+const VectorKernels &vectorKernels()
+{
+    static const VectorKernels &kernels = *supportedVectorKernels().front();
+    return kernels;
+}
+
+const VectorKernels &scalarVectorKernels()
+{
+    return scalarKernels;
+}
@@ -0,0 +1,118 @@
+#include "VectorPool.h"
+#include "RunStats.h"
+#include <algorithm>
+#include <new>
+#include <vector>
+
+/**
+ * \brief The free buffers of one size.
+ */
+struct FreeList
+{
+    size_t bytes;                ///< The size of the buffers.
+    size_t lastRelease;          ///< The release count of the thread when a buffer was last added.
+    std::vector<void *> buffers; ///< The buffers ready to be reused.
+};
+
+/**
+ * \brief The most sizes a pool keeps lists for.
+ *
+ * A run uses a handful of sizes: the dimension, and the lengths of a few
+ * work arrays. A buffer of a further size takes over the list that was
+ * added to longest ago, whose buffers go back to the heap, which keeps the
+ * search of the lists short.
+ */
+static constexpr size_t maxFreeLists = 8;
+
+static thread_local constinit size_t scopeDepth = 0; ///< The number of scopes open on the thread.
+static thread_local constinit size_t releases = 0;   ///< The number of buffers released on the thread.
+static thread_local std::vector<FreeList> freeLists; ///< The free lists of the thread, filled while a scope is open.
+
+/**
+ * \brief Return the buffers of a free list to the heap.
+ *
+ * \param list The list, left empty.
+ */
+static void freeBuffers(FreeList &list)
+{
+    for (void *buffer : list.buffers)
+        ::operator delete(buffer, list.bytes);
+    list.buffers.clear();
+}
+
+/**
+ * \brief Find the free list of a size on the calling thread.
+ *
+ * \param bytes The size of the buffers.
+ * \return The list, or null if the thread has none for this size.
+ */
+static FreeList *findFreeList(size_t bytes)
+{
+    for (FreeList &list : freeLists)
+    {
+        if (list.bytes == bytes)
+            return &list;
+    }
+    return nullptr;
+}
+
+VectorPoolScope::VectorPoolScope()
+{
+    ++scopeDepth;
+}
+
+VectorPoolScope::~VectorPoolScope()
+{
+    if (--scopeDepth > 0)
+        return;
+    for (FreeList &list : freeLists)
+        freeBuffers(list);
+    freeLists.clear();
+}
+
+void *acquireVectorBuffer(size_t bytes)
+{
+    if (scopeDepth > 0)
+    {
+        FreeList *list = findFreeList(bytes);
+        if (list && !list->buffers.empty())
+        {
+            void *buffer = list->buffers.back();
+            list->buffers.pop_back();
+            ++threadRunStats.vectorReuses;
+            return buffer;
+        }
+    }
+    void *buffer = ::operator new(bytes);
+    ++threadRunStats.vectorAllocations;
+    return buffer;
+}
+
+void releaseVectorBuffer(void *buffer, size_t bytes) noexcept
+{
+    if (scopeDepth > 0)
+    {
+        try
+        {
+            FreeList *list = findFreeList(bytes);
+            if (!list && freeLists.size() < maxFreeLists)
+            {
+                list = &freeLists.emplace_back(FreeList{bytes, 0, {}});
+            }
+            else if (!list)
+            {
+                list = &*std::min_element(freeLists.begin(), freeLists.end(), [](const FreeList &a, const FreeList &b)
+                                          { return a.lastRelease < b.lastRelease; });
+                freeBuffers(*list);
+                list->bytes = bytes;
+            }
+            list->buffers.push_back(buffer);
+            list->lastRelease = ++releases;
+            return;
+        }
+        catch (const std::bad_alloc &)
+        {
+        }
+    }
+    ::operator delete(buffer, bytes);
+}
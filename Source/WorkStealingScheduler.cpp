@@ -0,0 +1,82 @@
+#include "WorkStealingScheduler.h"
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+WorkStealingScheduler::WorkStealingScheduler(size_t threads) : threads(threads)
+{
+    if (this->threads == 0)
+        this->threads = std::max(1u, std::thread::hardware_concurrency());
+    queues = std::vector<WorkQueue>(this->threads);
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+}
+
+size_t WorkStealingScheduler::getThreadsNum() const
+{
+    return threads;
+}
+
+void WorkStealingScheduler::run(std::vector<std::function<void()>> &tasks)
+{
+    for (size_t i = 0; i < tasks.size(); ++i)
+        queues[i % threads].tasks.push_back(i);
+
+    // A thread whose task throws stops; the others steal its remaining tasks.
+    std::vector<std::exception_ptr> errors(threads);
+    auto work = [this, &tasks, &errors](size_t self)
+    {
+        try
+        {
+            size_t task;
+            while (next(self, task))
+                tasks[task]();
+        }
+        catch (...)
+        {
+            errors[self] = std::current_exception();
+        }
+    };
+    {
+        std::vector<std::jthread> workers;
+        for (size_t i = 1; i < threads; ++i)
+            workers.emplace_back(work, i);
+        work(0);
+    }
+    // Every thread may have failed, so tasks can be left over for the next run.
+    for (WorkQueue &queue : queues)
+        queue.tasks.clear();
+    for (const std::exception_ptr &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+bool WorkStealingScheduler::next(size_t self, size_t &task)
+{
+    {
+        WorkQueue &own = queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < threads; ++offset)
+    {
+        WorkQueue &victim = queues[(self + offset) % threads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,12 +1,12 @@
 #include "vectorX.h"
+#include "VectorKernels.h"
 
 VectorX &VectorX::operator+=(const VectorX &other)
 {
     if (this->size() != other.size())
         throw std::invalid_argument("Vectors must be of the same size.");
 
-    for (size_t i = 0; i < this->size(); ++i)
-        this->at(i) += other[i];
+    vectorKernels().add(data(), other.data(), size());
 
     return *this;
 }
@@ -16,16 +16,36 @@ VectorX &VectorX::operator-=(const VectorX &other)
     if (this->size() != other.size())
         throw std::invalid_argument("Vectors must be of the same size.");
 
-    for (size_t i = 0; i < this->size(); ++i)
-        this->at(i) -= other[i];
+    vectorKernels().sub(data(), other.data(), size());
+
+    return *this;
+}
+
+VectorX &VectorX::operator+=(const VectorScaled<VectorX> &scaled)
+{
+    const VectorX &other = scaled.getOperand();
+    if (this->size() != other.size())
+        throw std::invalid_argument("Vectors must be of the same size.");
+
+    vectorKernels().axpy(data(), scaled.getScalar(), other.data(), size());
+
+    return *this;
+}
+
+VectorX &VectorX::operator-=(const VectorScaled<VectorX> &scaled)
+{
+    const VectorX &other = scaled.getOperand();
+    if (this->size() != other.size())
+        throw std::invalid_argument("Vectors must be of the same size.");
+
+    vectorKernels().axpy(data(), -scaled.getScalar(), other.data(), size());
 
     return *this;
 }
 
 VectorX &VectorX::operator*=(double scalar)
 {
-    for (size_t i = 0; i < this->size(); ++i)
-        this->at(i) *= scalar;
+    vectorKernels().scale(data(), scalar, size());
 
     return *this;
 }
@@ -45,36 +65,7 @@ std::ostream &operator<<(std::ostream &os, const VectorX &vec)
     return os;
 }
 
-VectorX operator+(const VectorX &vec1, const VectorX &vec2)
-{
-    VectorX result = vec1;
-    result += vec2;
-    return result;
-}
-
-VectorX operator-(const VectorX &vec1, const VectorX &vec2)
-{
-    VectorX result = vec1;
-    result -= vec2;
-    return result;
-}
-
-VectorX operator*(const VectorX &vec, double scalar)
-{
-    VectorX result = vec;
-    result *= scalar;
-    return result;
-}
-
-VectorX operator*(double scalar, const VectorX &vec)
-{
-    return vec * scalar;
-}
-
 double norm(const VectorX &x)
 {
-    double norm = 0;
-    for (auto &el : x)
-        norm += el * el;
-    return sqrt(norm);
-}
+    return sqrt(vectorKernels().sumSquares(x.data(), x.size()));
+}
\ No newline at end of file
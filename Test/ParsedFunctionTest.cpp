@@ -0,0 +1,167 @@
+#include "ParsedFunction.h"
+#include "RandomEngine.h"
+#include "TestSupport.h"
+
+/**
+ * \brief Draw a point with coordinates uniform in [low, high).
+ */
+static VectorX randomPoint(Xoshiro256 &gen, size_t dim, double low, double high)
+{
+    VectorX x(dim);
+    for (size_t i = 0; i < dim; ++i)
+        x[i] = low + (high - low) * gen.uniform();
+    return x;
+}
+
+/**
+ * \brief Evaluate a formula of one variable.
+ */
+static double valueAt(const std::string &formula, double x)
+{
+    return ParsedFunction(formula)(VectorX(1, x));
+}
+
+/**
+ * \brief The names of the built-in functions are formulas that give the same values and gradients.
+ */
+static void testBuiltInNames()
+{
+    std::vector<std::shared_ptr<Function>> functions = {std::make_shared<Function1>(), std::make_shared<Function2>(), std::make_shared<Function3>(),
+                                                        std::make_shared<Function4>(), std::make_shared<Function5>(), std::make_shared<Function6>()};
+    Xoshiro256 gen(228);
+    for (const std::shared_ptr<Function> &f : functions)
+    {
+        ParsedFunction parsed(f->getName());
+        check(parsed.getDim() == f->getDim(), f->getName() + ": dimension");
+        if (parsed.getDim() != f->getDim())
+            continue;
+        for (int k = 0; k < 20; ++k)
+        {
+            VectorX x = randomPoint(gen, f->getDim(), -2, 2);
+            checkClose(parsed(x), (*f)(x), 1e-12, f->getName() + ": value");
+            VectorX expected = f->grad(x);
+            Evaluation eval = parsed.evaluate(x, true);
+            checkClose(eval.value, (*f)(x), 1e-12, f->getName() + ": evaluate value");
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                checkClose(parsed.grad(x)[i], expected[i], 1e-10, f->getName() + ": gradient " + std::to_string(i));
+                checkClose(eval.grad[i], expected[i], 1e-10, f->getName() + ": evaluate gradient " + std::to_string(i));
+            }
+        }
+    }
+}
+
+/**
+ * \brief Unary minus binds looser than ^, and ^ is right-associative.
+ */
+static void testPrecedence()
+{
+    checkClose(valueAt("-x^2", 3), -9, 0, "-x^2");
+    checkClose(valueAt("2^x^2", 3), 512, 0, "2^x^2");
+    checkClose(valueAt("x^-1", 4), 0.25, 0, "x^-1");
+    checkClose(valueAt("2^-x^2", 1), 0.5, 0, "2^-x^2");
+    checkClose(valueAt("1 - x - 1", 5), -5, 0, "1 - x - 1");
+    checkClose(valueAt("x / 2 / 4", 16), 2, 0, "x / 2 / 4");
+    checkClose(valueAt("1 + 2 * x^2", 3), 19, 0, "1 + 2 * x^2");
+    checkClose(valueAt("--x", 3), 3, 0, "--x");
+    checkClose(valueAt("(1 - x)^2", 4), 9, 0, "(1 - x)^2");
+}
+
+/**
+ * \brief A factor that follows another multiplies it with the precedence of *.
+ */
+static void testImplicitMultiplication()
+{
+    checkClose(valueAt("2x", 3), 6, 0, "2x");
+    checkClose(valueAt("2x^2", 3), 18, 0, "2x^2");
+    checkClose(valueAt("100(x - 1)^2", 3), 400, 0, "100(x - 1)^2");
+    checkClose(valueAt("2 sin(x)", 1), 2 * std::sin(1.0), 0, "2 sin(x)");
+    checkClose(valueAt("(x + 1)(x - 1)", 3), 8, 0, "(x + 1)(x - 1)");
+    checkClose(valueAt("2pi x", 1), 2 * std::acos(-1.0), 1e-15, "2pi x");
+    checkClose(valueAt("x / 2x", 4), 8, 0, "x / 2x");
+    ParsedFunction f("sin(x)cos(y)");
+    VectorX x = {0.5, 0.25};
+    checkClose(f(x), std::sin(0.5) * std::cos(0.25), 1e-15, "sin(x)cos(y)");
+}
+
+/**
+ * \brief Malformed formulas report the position of the offending token, counted from 1.
+ */
+static void testErrorPositions()
+{
+    auto parse = [](const std::string &formula, const std::vector<std::string> &variables = {})
+    { return [=] { ParsedFunction f(formula, variables); }; };
+    checkThrows(parse("x + $"), "Unexpected character '$' at position 5 of the formula.", "unexpected character");
+    checkThrows(parse("(x + y"), "Expected ')' instead of end of the formula at position 7 of the formula.", "missing parenthesis");
+    checkThrows(parse("x + * y"), "Unexpected '*' at position 5 of the formula.", "misplaced operator");
+    checkThrows(parse("x)"), "Unexpected ')' at position 2 of the formula.", "extra parenthesis");
+    checkThrows(parse("x^"), "Unexpected end of the formula at position 3 of the formula.", "missing exponent");
+    checkThrows(parse("sin x"), "Expected '(' instead of 'x' at position 5 of the formula.", "function without parentheses");
+    checkThrows(parse("x 1.2.3"), "Malformed number 1.2.3 at position 3 of the formula.", "malformed number");
+    checkThrows(parse("x + foo", {"x"}), "Unknown variable 'foo' at position 5 of the formula.", "unknown variable");
+    checkThrows(parse("2pi"), "Formula must have at least one variable.", "no variables");
+    checkThrows(parse("x + y", {"x", "x"}), "Variable x is listed twice.", "duplicate variable");
+}
+
+/**
+ * \brief The symbolic gradient of every operation agrees with central differences.
+ */
+static void testGradients()
+{
+    std::vector<std::string> formulas = {
+        "sin(x)cos(y) + tan(x / 3)",
+        "exp(y / 2) + log(x^2 + 1) + sqrt(y^2 + 1)",
+        "abs(x - 2y) + x / (1 + y^2)",
+        "x^y + 2^x - y^3",
+        "(x y - 1)^2 + (x - y)^4 + e^(x / 4)",
+    };
+    Xoshiro256 gen(1);
+    for (const std::string &formula : formulas)
+    {
+        ParsedFunction f(formula);
+        for (int k = 0; k < 20; ++k)
+        {
+            VectorX x = randomPoint(gen, f.getDim(), 0.5, 1.5);
+            VectorX expected = centralDifference(f, x);
+            VectorX grad = f.grad(x);
+            for (size_t i = 0; i < x.size(); ++i)
+                checkClose(grad[i], expected[i], 1e-6, formula + ": gradient " + std::to_string(i));
+        }
+    }
+}
+
+/**
+ * \brief evaluateBatch gives the values and gradients of the single-point calls.
+ */
+static void testBatch()
+{
+    ParsedFunction f("sin(x)cos(y) + exp(y / 2) + log(x^2 + 1) + sqrt(y^2 + 1) + abs(x - y)");
+    const size_t count = 37;
+    PointBatch points(f.getDim(), count);
+    Xoshiro256 gen(7);
+    for (size_t k = 0; k < count; ++k)
+        points.setPoint(k, randomPoint(gen, f.getDim(), -2, 2));
+    std::vector<double> values(count);
+    PointBatch grads(f.getDim(), count);
+    f.evaluateBatch(points, values.data(), &grads);
+    for (size_t k = 0; k < count; ++k)
+    {
+        VectorX x = points.getPoint(k);
+        checkClose(values[k], f(x), 1e-14, "batch value " + std::to_string(k));
+        VectorX grad = f.grad(x);
+        VectorX batchGrad = grads.getPoint(k);
+        for (size_t i = 0; i < x.size(); ++i)
+            checkClose(batchGrad[i], grad[i], 1e-14, "batch gradient " + std::to_string(k));
+    }
+}
+
+int main()
+{
+    testBuiltInNames();
+    testPrecedence();
+    testImplicitMultiplication();
+    testErrorPositions();
+    testGradients();
+    testBatch();
+    return testResult("ParsedFunctionTest");
+}
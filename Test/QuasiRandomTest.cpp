@@ -0,0 +1,195 @@
+#include "QuasiRandom.h"
+#include "TestSupport.h"
+#include <set>
+
+/**
+ * \brief Points of the plain Sobol sequence in 256 dimensions, from scipy.stats.qmc.Sobol.
+ *
+ * Generated with scipy 1.17 by Sobol(d=256, scramble=False), fast_forward(index)
+ * and random(1); the coordinates are scaled by 2^30, which makes them integers.
+ */
+struct SobolReference
+{
+    uint64_t index;      ///< The index of the point.
+    uint32_t scaled[15]; ///< The coordinates referenceCoords of the point, times 2^30.
+};
+
+/**
+ * \brief The coordinates of the reference points that are compared.
+ */
+static const size_t referenceCoords[15] = {0, 1, 2, 3, 4, 5, 6, 7, 15, 31, 63, 100, 127, 200, 255};
+
+/**
+ * \brief The reference points.
+ */
+static const SobolReference sobolReference[] = {
+    {1, {536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912, 536870912}},
+    {2, {805306368, 268435456, 268435456, 268435456, 805306368, 805306368, 268435456, 805306368, 268435456, 268435456, 805306368, 268435456, 268435456, 805306368, 805306368}},
+    {3, {268435456, 805306368, 805306368, 805306368, 268435456, 268435456, 805306368, 268435456, 805306368, 805306368, 268435456, 805306368, 805306368, 268435456, 268435456}},
+    {100, {444596224, 276824064, 830472192, 780140544, 947912704, 796917760, 25165824, 511705088, 528482304, 444596224, 696254464, 41943040, 494927872, 914358272, 612368384}},
+    {1000, {235929600, 103809024, 556793856, 726663168, 300941312, 974127104, 49283072, 965738496, 397410304, 156237824, 479199232, 825229312, 584056832, 808452096, 267386880}},
+    {4095, {262144, 1010565120, 358875136, 968097792, 1009516544, 84672512, 1019478016, 419692544, 447479808, 94109696, 594280448, 370409472, 280756224, 182714368, 658243584}},
+    {65537, {536895488, 1073733632, 1043685376, 417505280, 948903936, 284090368, 814211072, 136011776, 197500928, 239181824, 801251328, 74309632, 13967360, 652255232, 444882944}},
+    {1000000, {28427264, 334920704, 889054208, 717523968, 675017728, 853691392, 1042330624, 18031616, 768902144, 581327872, 62407680, 42327040, 760693760, 296109056, 596745216}},
+    {123456789, {1047862216, 850867304, 6878296, 975803336, 939372104, 914141784, 1047228488, 743323784, 737373384, 520510088, 271909448, 574749560, 719844664, 226873112, 140913400}},
+};
+
+/**
+ * \brief Check the points of the plain sequence against SciPy, reached by skipping and by drawing.
+ */
+static void testSobolAgainstScipy()
+{
+    const size_t dim = SobolSequence::maxDim;
+    std::vector<double> u(dim);
+    for (const SobolReference &reference : sobolReference)
+    {
+        SobolSequence skipped(dim);
+        skipped.skipPoints(reference.index, dim);
+        skipped.nextPoint(u.data(), dim);
+        for (size_t c = 0; c < 15; ++c)
+            checkClose(u[referenceCoords[c]] * 0x1p30, reference.scaled[c], 0,
+                       "Sobol point " + std::to_string(reference.index) + ", coordinate " + std::to_string(referenceCoords[c]));
+    }
+    SobolSequence drawn(dim);
+    for (uint64_t index = 0; index <= 4095; ++index)
+    {
+        drawn.nextPoint(u.data(), dim);
+        for (const SobolReference &reference : sobolReference)
+        {
+            if (reference.index != index)
+                continue;
+            for (size_t c = 0; c < 15; ++c)
+                checkClose(u[referenceCoords[c]] * 0x1p30, reference.scaled[c], 0,
+                           "drawn Sobol point " + std::to_string(index) + ", coordinate " + std::to_string(referenceCoords[c]));
+        }
+    }
+    check(drawn.getIndex() == 4096, "Sobol index after drawing");
+
+    // The first points in two dimensions, as tabulated by Joe and Kuo.
+    const double firstPoints[8][2] = {{0, 0}, {0.5, 0.5}, {0.75, 0.25}, {0.25, 0.75}, {0.375, 0.375}, {0.875, 0.875}, {0.625, 0.125}, {0.125, 0.625}};
+    SobolSequence plane(2);
+    for (const auto &point : firstPoints)
+    {
+        double v[2];
+        plane.nextPoint(v, 2);
+        check(v[0] == point[0] && v[1] == point[1], "two-dimensional Sobol point");
+    }
+}
+
+/**
+ * \brief The first 2^k points of every coordinate fall one into each interval of width 2^-k.
+ */
+static void testStratification(SobolSequence sequence, const std::string &what)
+{
+    const size_t dim = SobolSequence::maxDim;
+    const size_t count = 1024;
+    std::vector<double> points(count * dim);
+    for (size_t i = 0; i < count; ++i)
+        sequence.nextPoint(points.data() + i * dim, dim);
+    for (size_t k = 1; (size_t(1) << k) <= count; ++k)
+    {
+        size_t cells = size_t(1) << k;
+        for (size_t j = 0; j < dim; ++j)
+        {
+            std::set<size_t> seen;
+            for (size_t i = 0; i < cells; ++i)
+                seen.insert(static_cast<size_t>(points[i * dim + j] * cells));
+            check(seen.size() == cells, what + ": 2^" + std::to_string(k) + " points of coordinate " + std::to_string(j));
+        }
+    }
+}
+
+/**
+ * \brief The scrambled sequence depends on the seed only, and skipping matches drawing.
+ */
+static void testScrambling()
+{
+    const size_t dim = 8;
+    SobolSequence first(dim, true, 1), again(dim, true, 1), other(dim, true, 2), skipped(dim, true, 1);
+    skipped.skipPoints(999, dim);
+    double a[dim], b[dim], c[dim];
+    bool differs = false;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        first.nextPoint(a, dim);
+        again.nextPoint(b, dim);
+        other.nextPoint(c, dim);
+        for (size_t j = 0; j < dim; ++j)
+        {
+            check(a[j] == b[j], "scrambled sequence is reproducible");
+            differs = differs || a[j] != c[j];
+        }
+    }
+    check(differs, "scrambled sequences of different seeds differ");
+    skipped.nextPoint(b, dim);
+    for (size_t j = 0; j < dim; ++j)
+        check(a[j] == b[j], "scrambled sequence skips to the drawn point");
+}
+
+/**
+ * \brief The Halton sequence holds the radical inverses of the index in the prime bases.
+ */
+static void testHalton()
+{
+    const double expected[5][3] = {{0, 0, 0}, {0.5, 1.0 / 3, 0.2}, {0.25, 2.0 / 3, 0.4}, {0.75, 1.0 / 9, 0.6}, {0.125, 4.0 / 9, 0.8}};
+    HaltonSequence halton(3);
+    for (const auto &point : expected)
+    {
+        double u[3];
+        halton.nextPoint(u, 3);
+        for (size_t j = 0; j < 3; ++j)
+            checkClose(u[j], point[j], 1e-15, "Halton point");
+    }
+    HaltonSequence skipped(3);
+    skipped.skipPoints(12345, 3);
+    double u[3];
+    skipped.nextPoint(u, 3);
+    checkClose(u[0], 0.60955810546875, 1e-15, "Halton point 12345 in base 2");
+    check(skipped.getIndex() == 12346, "Halton index");
+}
+
+/**
+ * \brief makeSampler starts the plain sequences after their corner point.
+ */
+static void testMakeSampler()
+{
+    double u[2];
+    makeSampler(Sampling::Sobol, 2, 0)->nextPoint(u, 2);
+    check(u[0] == 0.5 && u[1] == 0.5, "plain Sobol sampler skips the corner");
+    makeSampler(Sampling::Halton, 2, 0)->nextPoint(u, 2);
+    checkClose(u[0], 0.5, 0, "Halton sampler skips the corner");
+    checkClose(u[1], 1.0 / 3, 1e-15, "Halton sampler skips the corner");
+    double v[2];
+    makeSampler(Sampling::ScrambledSobol, 2, 5)->nextPoint(u, 2);
+    SobolSequence(2, true, 5).nextPoint(v, 2);
+    check(u[0] == v[0] && u[1] == v[1], "scrambled Sobol sampler starts at point 0");
+    check(parseSampling("random") == Sampling::Random && parseSampling("sobol") == Sampling::Sobol &&
+              parseSampling("scrambled-sobol") == Sampling::ScrambledSobol && parseSampling("halton") == Sampling::Halton,
+          "sampling names");
+}
+
+/**
+ * \brief Invalid dimensions and sampling names are rejected.
+ */
+static void testErrors()
+{
+    checkThrows([] { SobolSequence s(0); }, "SobolSequence supports 1 to 256 dimensions.", "Sobol dimension 0");
+    checkThrows([] { SobolSequence s(SobolSequence::maxDim + 1); }, "SobolSequence supports 1 to 256 dimensions.", "Sobol dimension 257");
+    checkThrows([] { HaltonSequence s(0); }, "HaltonSequence needs at least one dimension.", "Halton dimension 0");
+    checkThrows([]
+                { SobolSequence s(3); double u[2]; s.nextPoint(u, 2); },
+                "The point must have the dimension of the sequence.", "Sobol point of another dimension");
+    checkThrows([] { parseSampling("grid"); }, "Unknown sampling grid.", "unknown sampling");
+}
+
+int main()
+{
+    testSobolAgainstScipy();
+    testStratification(SobolSequence(SobolSequence::maxDim), "plain Sobol");
+    testStratification(SobolSequence(SobolSequence::maxDim, true, 228), "scrambled Sobol");
+    testScrambling();
+    testHalton();
+    testMakeSampler();
+    testErrors();
+    return testResult("QuasiRandomTest");
+}
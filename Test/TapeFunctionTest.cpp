@@ -0,0 +1,175 @@
+#include "RandomEngine.h"
+#include "ScalableFunction.h"
+#include "TapeFunction.h"
+#include "TestSupport.h"
+#include <thread>
+
+/**
+ * \brief Draw a point with coordinates uniform in [low, high).
+ */
+static VectorX randomPoint(Xoshiro256 &gen, size_t dim, double low, double high)
+{
+    VectorX x(dim);
+    for (size_t i = 0; i < dim; ++i)
+        x[i] = low + (high - low) * gen.uniform();
+    return x;
+}
+
+/**
+ * \brief A formula that uses every operation of TapeVar.
+ */
+static TapeVar everyOperation(const std::vector<TapeVar> &x)
+{
+    TapeVar sum = sin(x[0]) * cos(x[1]) + exp(x[2] / 4) - log(1 + x[3] * x[3]);
+    sum += sqrt(x[0] * x[0] + x[4] * x[4] + 1) / (2 + x[1]);
+    sum -= pow(x[2], 3.5) * 0.25;
+    TapeVar product = 2 - x[3];
+    product *= x[4] + 1;
+    product /= 3 + x[0];
+    sum += -product + 1 / (x[1] + 4) - (x[2] - 1) * 2;
+    return sum;
+}
+
+/**
+ * \brief The chained Rosenbrock function of RosenbrockFunction, written over TapeVar.
+ */
+static TapeVar rosenbrock(const std::vector<TapeVar> &x)
+{
+    TapeVar sum;
+    for (size_t i = 0; i + 1 < x.size(); ++i)
+    {
+        TapeVar a = 1 - x[i];
+        TapeVar b = x[i + 1] - x[i] * x[i];
+        sum += a * a + 100 * b * b;
+    }
+    return sum;
+}
+
+/**
+ * \brief The recorded tape is replayed at points other than the one it was recorded at.
+ */
+static void testGradientsAgainstDifferences()
+{
+    TapeFunction f("every operation", 5, everyOperation);
+    check(f.getTapeSize() > 0, "the tape is recorded once");
+    Xoshiro256 gen(228);
+    for (int k = 0; k < 50; ++k)
+    {
+        VectorX x = randomPoint(gen, 5, 0.1, 2);
+        VectorX expected = centralDifference(f, x);
+        VectorX grad = f.grad(x);
+        Evaluation eval = f.evaluate(x, true);
+        checkClose(eval.value, f(x), 0, "evaluate value");
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            checkClose(grad[i], expected[i], 1e-6, "gradient " + std::to_string(i));
+            checkClose(eval.grad[i], grad[i], 0, "evaluate gradient " + std::to_string(i));
+        }
+    }
+}
+
+/**
+ * \brief In high dimension the gradient matches the analytic gradient of RosenbrockFunction.
+ */
+static void testRosenbrock()
+{
+    const size_t n = 1000;
+    TapeFunction f("chained Rosenbrock", n, rosenbrock);
+    RosenbrockFunction reference(n);
+    Xoshiro256 gen(1);
+    for (int k = 0; k < 5; ++k)
+    {
+        VectorX x = randomPoint(gen, n, -2, 2);
+        checkClose(f(x), reference(x), 1e-12, "Rosenbrock value");
+        VectorX grad = f.grad(x);
+        VectorX expected = reference.grad(x);
+        for (size_t i = 0; i < n; ++i)
+            checkClose(grad[i], expected[i], 1e-12, "Rosenbrock gradient " + std::to_string(i));
+    }
+}
+
+/**
+ * \brief A formula that branches on its values is correct on both sides when recorded at every point.
+ */
+static void testRetape()
+{
+    auto absolute = [](const std::vector<TapeVar> &x)
+    {
+        TapeVar sum;
+        for (const TapeVar &xi : x)
+            sum += xi.value() < 0 ? -xi : xi;
+        return sum * x[0];
+    };
+    TapeFunction f("branching", 3, absolute, true);
+    check(f.getTapeSize() == 0, "a retaped function keeps no tape");
+    Xoshiro256 gen(7);
+    for (int k = 0; k < 50; ++k)
+    {
+        VectorX x = randomPoint(gen, 3, -1, 1);
+        double abs = std::abs(x[0]) + std::abs(x[1]) + std::abs(x[2]);
+        checkClose(f(x), abs * x[0], 1e-15, "retaped value");
+        VectorX grad = f.grad(x);
+        checkClose(grad[0], abs + x[0] * (x[0] < 0 ? -1 : 1), 1e-15, "retaped gradient 0");
+        for (size_t i = 1; i < 3; ++i)
+            checkClose(grad[i], x[0] * (x[i] < 0 ? -1 : 1), 1e-15, "retaped gradient " + std::to_string(i));
+    }
+}
+
+/**
+ * \brief Clones share the tape and evaluate from several threads at once.
+ */
+static void testThreads()
+{
+    TapeFunction f("every operation", 5, everyOperation);
+    std::shared_ptr<Function> clone = f.clone();
+    Xoshiro256 gen(11);
+    std::vector<VectorX> points;
+    for (int k = 0; k < 200; ++k)
+        points.push_back(randomPoint(gen, 5, 0.1, 2));
+    std::vector<VectorX> expected;
+    for (const VectorX &x : points)
+        expected.push_back(f.grad(x));
+    std::vector<VectorX> fromThread(points.size()), fromClone(points.size());
+    {
+        std::jthread first([&]
+                           { for (size_t k = 0; k < points.size(); ++k) fromThread[k] = f.grad(points[k]); });
+        std::jthread second([&]
+                            { for (size_t k = 0; k < points.size(); ++k) fromClone[k] = clone->grad(points[k]); });
+    }
+    for (size_t k = 0; k < points.size(); ++k)
+    {
+        for (size_t i = 0; i < 5; ++i)
+        {
+            checkClose(fromThread[k][i], expected[k][i], 0, "gradient on another thread");
+            checkClose(fromClone[k][i], expected[k][i], 0, "gradient of the clone");
+        }
+    }
+}
+
+/**
+ * \brief Invalid arguments are rejected; a result recorded on no tape is a constant.
+ */
+static void testErrors()
+{
+    checkThrows([] { TapeFunction f("empty", 0, rosenbrock); }, "Dimension must be positive.", "zero dimension");
+    checkThrows([] { TapeFunction f("empty", 2, TapeFunction::Formula()); }, "Formula must not be empty.", "empty formula");
+    Tape other;
+    checkThrows([&]
+                { TapeFunction f("foreign", 2, [&](const std::vector<TapeVar> &) { return other.input(1); }); },
+                "Formula must return a variable recorded on its own tape.", "result on another tape");
+    TapeFunction constant("constant", 2, [](const std::vector<TapeVar> &) { return TapeVar(); });
+    VectorX grad = constant.grad(VectorX(2, 1.0));
+    check(constant(VectorX(2, 1.0)) == 0 && grad[0] == 0 && grad[1] == 0, "a result off the tape is a constant");
+    TapeFunction f("chained Rosenbrock", 3, rosenbrock);
+    checkThrows([&] { f(VectorX(2, 0.0)); }, "Input vector must have exactly 3 elements.", "wrong dimension");
+}
+
+int main()
+{
+    testGradientsAgainstDifferences();
+    testRosenbrock();
+    testRetape();
+    testThreads();
+    testErrors();
+    return testResult("TapeFunctionTest");
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "Function.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+
+/**
+ * \brief The number of failed checks of the test program.
+ *
+ * \return A reference to the counter.
+ */
+inline size_t &testFailures()
+{
+    static size_t failures = 0;
+    return failures;
+}
+
+/**
+ * \brief Check a condition and report it if it does not hold.
+ *
+ * \param condition The condition.
+ * \param what A description of the check.
+ */
+inline void check(bool condition, const std::string &what)
+{
+    if (condition)
+        return;
+    ++testFailures();
+    std::cerr << "FAILED: " << what << std::endl;
+}
+
+/**
+ * \brief Check that two numbers agree to a mixed absolute and relative tolerance.
+ *
+ * \param actual The computed number.
+ * \param expected The reference number.
+ * \param tolerance The allowed difference relative to max(1, |expected|).
+ * \param what A description of the check.
+ */
+inline void checkClose(double actual, double expected, double tolerance, const std::string &what)
+{
+    if (std::abs(actual - expected) <= tolerance * std::max(1.0, std::abs(expected)))
+        return;
+    ++testFailures();
+    std::cerr.precision(17);
+    std::cerr << "FAILED: " << what << ": got " << actual << ", expected " << expected << std::endl;
+}
+
+/**
+ * \brief Check that a call throws std::invalid_argument with the given message.
+ *
+ * \param call The call.
+ * \param message The expected message, or empty to accept any.
+ * \param what A description of the check.
+ */
+template <typename Call>
+void checkThrows(Call call, const std::string &message, const std::string &what)
+{
+    try
+    {
+        call();
+    }
+    catch (const std::invalid_argument &e)
+    {
+        check(message.empty() || e.what() == message, what + ": message \"" + e.what() + "\"");
+        return;
+    }
+    check(false, what + ": no exception");
+}
+
+/**
+ * \brief Approximate the gradient of a function by central differences.
+ *
+ * \param f The function.
+ * \param x The point.
+ * \param h The step, relative to max(1, |x_i|).
+ * \return The approximate gradient.
+ */
+inline VectorX centralDifference(const Function &f, const VectorX &x, double h = 1e-6)
+{
+    VectorX grad(x.size());
+    VectorX shifted = x;
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        double step = h * std::max(1.0, std::abs(x[i]));
+        shifted[i] = x[i] + step;
+        double forward = f(shifted);
+        shifted[i] = x[i] - step;
+        double backward = f(shifted);
+        shifted[i] = x[i];
+        grad[i] = (forward - backward) / (2 * step);
+    }
+    return grad;
+}
+
+/**
+ * \brief Report the outcome of the test program.
+ *
+ * \param name The name of the test program.
+ * \return The exit code: 0 if every check passed.
+ */
+inline int testResult(const std::string &name)
+{
+    if (testFailures() == 0)
+    {
+        std::cout << name << ": all checks passed" << std::endl;
+        return 0;
+    }
+    std::cout << name << ": " << testFailures() << " checks failed" << std::endl;
+    return 1;
+}
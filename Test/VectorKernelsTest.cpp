@@ -0,0 +1,227 @@
+#include "RandomEngine.h"
+#include "TestSupport.h"
+#include "VectorKernels.h"
+#include <bit>
+#include <cstring>
+#include <limits>
+
+/**
+ * \brief Map a double to an integer that orders like the double, so that adjacent doubles differ by 1.
+ */
+static int64_t orderedBits(double x)
+{
+    int64_t bits = std::bit_cast<int64_t>(x);
+    return bits < 0 ? std::numeric_limits<int64_t>::min() - bits : bits;
+}
+
+/**
+ * \brief The distance in units in the last place between two doubles; 0 if both are NaN.
+ */
+static uint64_t ulpDistance(double a, double b)
+{
+    if (std::isnan(a) || std::isnan(b))
+        return std::isnan(a) && std::isnan(b) ? 0 : std::numeric_limits<uint64_t>::max();
+    int64_t ia = orderedBits(a), ib = orderedBits(b);
+    return ia > ib ? uint64_t(ia) - uint64_t(ib) : uint64_t(ib) - uint64_t(ia);
+}
+
+/**
+ * \brief Check that two arrays are bit-identical, treating all NaNs as equal.
+ */
+static void checkIdentical(const std::vector<double> &actual, const std::vector<double> &expected, const std::string &what)
+{
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        if (ulpDistance(actual[i], expected[i]) != 0 || (std::signbit(actual[i]) != std::signbit(expected[i]) && !std::isnan(expected[i])))
+        {
+            check(false, what + ", element " + std::to_string(i));
+            return;
+        }
+    }
+}
+
+/**
+ * \brief The inputs of one test case: the vectors and a name for the report.
+ */
+struct Inputs
+{
+    std::string name;      ///< Describes the inputs.
+    std::vector<double> x; ///< The first operand.
+    std::vector<double> y; ///< The second operand, the same length as x.
+};
+
+/**
+ * \brief Random inputs of every length up to 67, some longer ones, and edge values.
+ *
+ * The lengths cover the tails of every vector width, and the first element
+ * is left out of an aligned buffer to test unaligned access.
+ */
+static std::vector<Inputs> makeInputs()
+{
+    std::vector<Inputs> inputs;
+    Xoshiro256 gen(228);
+    auto random = [&](size_t n, double scale)
+    {
+        std::vector<double> v(n);
+        for (double &e : v)
+            e = (2 * gen.uniform() - 1) * scale;
+        return v;
+    };
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 67; ++n)
+        lengths.push_back(n);
+    for (size_t n : {255, 256, 257, 1000, 4099})
+        lengths.push_back(n);
+    for (size_t n : lengths)
+    {
+        inputs.push_back({"random of length " + std::to_string(n), random(n, 1), random(n, 1)});
+        inputs.push_back({"wide-ranged of length " + std::to_string(n), random(n, 1e100), random(n, 1e-100)});
+    }
+
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double tiny = std::numeric_limits<double>::denorm_min();
+    const double least = std::numeric_limits<double>::min();
+    const double most = std::numeric_limits<double>::max();
+    std::vector<double> edge = {0.0, -0.0, tiny, -tiny, least, -least, least / 3, 1e-160, -1e-160, 1.0, -1.0,
+                                most, -most, 1e154, -1e154, inf, -inf, nan, 0.5, 3.0};
+    std::vector<double> x, y;
+    for (double a : edge)
+    {
+        for (double b : edge)
+        {
+            x.push_back(a);
+            y.push_back(b);
+        }
+    }
+    inputs.push_back({"edge values", x, y});
+    std::vector<double> subnormal(37, tiny), zeros(41, 0.0), negativeZeros(41, -0.0);
+    inputs.push_back({"subnormals", subnormal, subnormal});
+    inputs.push_back({"zeros", zeros, negativeZeros});
+    inputs.push_back({"negative zeros", negativeZeros, zeros});
+    return inputs;
+}
+
+/**
+ * \brief Copy a vector into a buffer one element past an aligned start, so that the kernels see unaligned data.
+ */
+static double *unaligned(std::vector<double> &buffer, const std::vector<double> &v)
+{
+    buffer.assign(v.size() + 1, 0.0);
+    std::memcpy(buffer.data() + 1, v.data(), v.size() * sizeof(double));
+    return buffer.data() + 1;
+}
+
+/**
+ * \brief The element-wise kernels give the results of the scalar table bit for bit.
+ */
+static void testElementWise(const VectorKernels &kernels, const Inputs &in)
+{
+    const VectorKernels &scalar = scalarVectorKernels();
+    const size_t n = in.x.size();
+    const std::string what = std::string(kernels.name) + " on " + in.name;
+    std::vector<double> bufferY, bufferX, bufferM, bufferV;
+    auto run = [&](const VectorKernels &k, auto kernel)
+    {
+        double *y = unaligned(bufferY, in.y);
+        const double *x = unaligned(bufferX, in.x);
+        kernel(k, y, x);
+        return std::vector<double>(y, y + n);
+    };
+    auto compare = [&](const std::string &name, auto kernel)
+    { checkIdentical(run(kernels, kernel), run(scalar, kernel), name + " " + what); };
+    compare("add", [n](const VectorKernels &k, double *y, const double *x) { k.add(y, x, n); });
+    compare("sub", [n](const VectorKernels &k, double *y, const double *x) { k.sub(y, x, n); });
+    for (double a : {0.0, -0.0, 0.75, -3.0, 1e300, std::numeric_limits<double>::infinity()})
+    {
+        compare("scale by " + std::to_string(a), [n, a](const VectorKernels &k, double *y, const double *) { k.scale(y, a, n); });
+        compare("axpy by " + std::to_string(a), [n, a](const VectorKernels &k, double *y, const double *x) { k.axpy(y, a, x, n); });
+    }
+
+    // The moments start from the operands themselves, so the edge values reach every operation.
+    AdamCoefficients c = {0.9, 0.999, 1 - 0.9 * 0.9 * 0.9, 1 - 0.999 * 0.999 * 0.999, 1e-3, 1e-8};
+    std::vector<double> results[2][3];
+    const VectorKernels *tables[2] = {&kernels, &scalar};
+    for (size_t t = 0; t < 2; ++t)
+    {
+        std::vector<double> v(in.x.size());
+        for (size_t i = 0; i < n; ++i)
+            v[i] = std::abs(in.y[i]);
+        double *xs = unaligned(bufferX, in.y);
+        double *m = unaligned(bufferM, in.x);
+        double *vs = unaligned(bufferV, v);
+        std::vector<double> g = in.x;
+        tables[t]->adamStep(xs, m, vs, g.data(), n, c);
+        results[t][0].assign(xs, xs + n);
+        results[t][1].assign(m, m + n);
+        results[t][2].assign(vs, vs + n);
+    }
+    for (size_t r = 0; r < 3; ++r)
+        checkIdentical(results[0][r], results[1][r], "adamStep " + what);
+}
+
+/**
+ * \brief sumSquares stays within n - 1 ULP of the sequential sum, and its root within n / 2 + 1 ULP.
+ */
+static void testSumSquares(const VectorKernels &kernels, const Inputs &in)
+{
+    const size_t n = in.x.size();
+    const std::string what = std::string(kernels.name) + " on " + in.name;
+    std::vector<double> buffer;
+    for (const std::vector<double> *v : {&in.x, &in.y})
+    {
+        const double *x = unaligned(buffer, *v);
+        double actual = kernels.sumSquares(x, n);
+        double expected = scalarVectorKernels().sumSquares(x, n);
+        if (std::isinf(expected) || std::isnan(expected))
+        {
+            // An infinity or a NaN among the elements decides the result in every order.
+            check(std::isinf(expected) ? actual == expected : std::isnan(actual), "sumSquares " + what + ": special value");
+            continue;
+        }
+        uint64_t bound = n > 0 ? n - 1 : 0;
+        check(ulpDistance(actual, expected) <= bound, "sumSquares " + what + ": " + std::to_string(ulpDistance(actual, expected)) + " ULP");
+        check(ulpDistance(std::sqrt(actual), std::sqrt(expected)) <= n / 2 + 1, "norm " + what);
+    }
+}
+
+/**
+ * \brief philoxUniform gives the numbers of the scalar table bit for bit, across the carries of the counter.
+ */
+static void testPhilox(const VectorKernels &kernels)
+{
+    const uint32_t key[2] = {0x12345678u, 0x9abcdef0u};
+    for (uint64_t firstBlock : {uint64_t(0), uint64_t(5), uint64_t(0xFFFFFFF0u), UINT64_C(0xFFFFFFFFFFFFFFF8)})
+    {
+        for (uint64_t stream : {uint64_t(0), UINT64_C(0x0123456789ABCDEF)})
+        {
+            for (size_t blocks : {0, 1, 3, 4, 7, 8, 9, 16, 33, 100})
+            {
+                std::vector<double> actual(2 * blocks), expected(2 * blocks);
+                kernels.philoxUniform(actual.data(), blocks, firstBlock, stream, key);
+                scalarVectorKernels().philoxUniform(expected.data(), blocks, firstBlock, stream, key);
+                checkIdentical(actual, expected, std::string("philoxUniform ") + kernels.name + " from block " + std::to_string(firstBlock) +
+                                                     " of " + std::to_string(blocks));
+            }
+        }
+    }
+}
+
+int main()
+{
+    std::vector<const VectorKernels *> tables = supportedVectorKernels();
+    check(!tables.empty() && tables.back() == &scalarVectorKernels(), "the scalar table is supported");
+    check(!tables.empty() && tables.front() == &vectorKernels(), "the widest table is selected");
+    std::vector<Inputs> inputs = makeInputs();
+    for (const VectorKernels *kernels : tables)
+    {
+        std::cout << "Testing the " << kernels->name << " kernels" << std::endl;
+        for (const Inputs &in : inputs)
+        {
+            testElementWise(*kernels, in);
+            testSumSquares(*kernels, in);
+        }
+        testPhilox(*kernels);
+    }
+    return testResult("VectorKernelsTest");
+}